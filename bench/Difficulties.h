@@ -0,0 +1,31 @@
+#pragma once
+
+#include <benchmark/benchmark.h>
+
+/// Board sizes of the difficulties, see Board::sizeFromDifficulty, the boards have 20 % of mines.
+inline constexpr int DIFFICULTY_SIZES[] = { 10, 15, 20 };
+
+/// Run the benchmark for every difficulty, the argument is the size of the board.
+inline void difficulties(benchmark::internal::Benchmark *benchmark)
+{
+	for (int size : DIFFICULTY_SIZES) {
+		benchmark->Arg(size);
+	}
+}
+
+/// Sides of the square boards from the beginner board to the largest supported one.
+inline constexpr int BOARD_SIZES[] = { 9, 16, 30, 100, 300, 1000 };
+
+/// Run the benchmark for every board size, the argument is the side of the board.
+inline void boardSizes(benchmark::internal::Benchmark *benchmark)
+{
+	for (int size : BOARD_SIZES) {
+		benchmark->Arg(size);
+	}
+}
+
+/// Run the benchmark for the leaderboards from a thousand to a million records, the argument is the record count.
+inline void leaderboardSizes(benchmark::internal::Benchmark *benchmark)
+{
+	benchmark->RangeMultiplier(10)->Range(1'000, 1'000'000);
+}
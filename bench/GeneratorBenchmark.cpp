@@ -0,0 +1,84 @@
+#include "Difficulties.h"
+#include "Generator.h"
+#include "Scheduler.h"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <thread>
+
+#define NO_GUESS_TIMEOUT std::chrono::seconds(10)
+
+/// Accepted no-guess boards per second of one core.
+static void BM_NoGuessBoardsPerCore(benchmark::State &state)
+{
+	int size = state.range(0);
+	Generator generator(size, size, size * size / 5);
+	int first = (size / 2) * size + size / 2;
+
+	uint64_t seed = state.thread_index() + 1;
+	uint64_t attempts = 0;
+	uint64_t boards = 0;
+	for (auto _ : state) {
+		while (!generator.isNoGuess(first, Generator::candidate(seed, attempts++))) {
+		}
+		boards++;
+	}
+
+	state.counters["boards/s/core"] = benchmark::Counter(boards, benchmark::Counter::kIsRate | benchmark::Counter::kAvgThreads);
+	state.counters["attempts/board"] = benchmark::Counter(static_cast<double>(attempts) / boards, benchmark::Counter::kAvgThreads);
+}
+BENCHMARK(BM_NoGuessBoardsPerCore)
+	->Apply(difficulties)
+	->ThreadRange(1, std::max(1u, std::thread::hardware_concurrency()))
+	->Unit(benchmark::kMillisecond)
+	->UseRealTime();
+
+/// Latency of the parallel search on the first click using all the cores.
+static void BM_NoGuessGenerate(benchmark::State &state)
+{
+	int size = state.range(0);
+	Scheduler scheduler;
+	Generator generator(size, size, size * size / 5, &scheduler);
+	int first = (size / 2) * size + size / 2;
+
+	uint64_t seed = 1;
+	uint64_t failures = 0;
+	for (auto _ : state) {
+		auto layout = generator.generate(first, seed++, NO_GUESS_TIMEOUT);
+		failures += !layout.accepted;
+	}
+
+	state.counters["timeouts"] = failures;
+}
+BENCHMARK(BM_NoGuessGenerate)
+	->Apply(difficulties)
+	->Unit(benchmark::kMillisecond)
+	->UseRealTime();
+
+/// Latency of the parallel search for a no-guess layout with the 3BV in the middle band of the difficulty.
+static void BM_TargetBbbvGenerate(benchmark::State &state)
+{
+	int size = state.range(0);
+	Scheduler scheduler;
+	Generator generator(size, size, size * size / 5, &scheduler);
+	int first = (size / 2) * size + size / 2;
+
+	// The median 3BV is about a third of the cells, the band covers roughly the middle third of the layouts.
+	Generator::Requirements requirements;
+	requirements.minimumBbbv = size * size / 3 - size / 2;
+	requirements.maximumBbbv = size * size / 3 + size / 2;
+
+	uint64_t seed = 1;
+	uint64_t failures = 0;
+	for (auto _ : state) {
+		auto layout = generator.generate(first, seed++, NO_GUESS_TIMEOUT, requirements);
+		failures += !layout.accepted;
+	}
+
+	state.counters["timeouts"] = failures;
+}
+BENCHMARK(BM_TargetBbbvGenerate)
+	->Apply(difficulties)
+	->Unit(benchmark::kMillisecond)
+	->UseRealTime();
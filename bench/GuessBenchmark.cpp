@@ -0,0 +1,111 @@
+#include "GuessOptimizer.h"
+#include "ProbabilityEngine.h"
+#include "Solver.h"
+
+#include <benchmark/benchmark.h>
+
+#include <chrono>
+#include <cmath>
+
+/// Expert board, the layout the win rates of the solvers are usually quoted for.
+#define EXPERT_WIDTH 30
+#define EXPERT_HEIGHT 16
+#define EXPERT_MINES 99
+/// Enough paired games to tell a gain of about one percentage point from the noise.
+#define GAMES 4000
+#define GUESS_BUDGET std::chrono::milliseconds(20)
+/// Two sided 95 % quantile of the normal distribution.
+#define CONFIDENCE_Z 1.96
+
+namespace
+{
+
+/// How the cell is chosen when the solver can not deduce one.
+enum Policy
+{
+	MinimumProbability,
+	Lookahead,
+};
+
+/// Play the game, the solver reveals the deduced safe cells and the policy chooses the guesses.
+bool play(uint64_t seed, Policy policy, uint64_t &guesses)
+{
+	Minefield field(EXPERT_WIDTH, EXPERT_HEIGHT, EXPERT_MINES);
+	Solver solver(field);
+	ProbabilityEngine probability(field, solver);
+	GuessOptimizer optimizer(field);
+
+	int first = field.index(EXPERT_WIDTH / 2, EXPERT_HEIGHT / 2);
+	field.generate(first, seed);
+	field.reveal(first);
+	solver.update(field.changes());
+
+	while (field.state() == Minefield::State::Playing) {
+		bool progress = false;
+		for (auto [cell, mine] : solver.deductions()) {
+			if (!mine && field.reveal(cell)) {
+				solver.update(field.changes());
+				progress = true;
+			}
+		}
+		if (progress) {
+			continue;
+		}
+
+		int cell;
+		if (policy == Policy::Lookahead) {
+			cell = optimizer.guess(GUESS_BUDGET);
+		}
+		else {
+			probability.compute();
+			cell = probability.safestCell();
+		}
+
+		guesses++;
+		field.reveal(cell);
+		solver.update(field.changes());
+	}
+
+	return field.state() == Minefield::State::Win;
+}
+
+}
+
+/// Win rates of the guess policies over the same expert boards, the gain of the lookahead is the mean of the paired
+/// differences, only the boards won by one of the policies add to it and to its confidence interval.
+static void BM_GuessPolicyWinRate(benchmark::State &state)
+{
+	uint64_t minimumWins = 0;
+	uint64_t lookaheadWins = 0;
+	uint64_t onlyMinimum = 0;
+	uint64_t onlyLookahead = 0;
+	uint64_t minimumGuesses = 0;
+	uint64_t lookaheadGuesses = 0;
+	for (auto _ : state) {
+		for (uint64_t seed = 1; seed <= GAMES; seed++) {
+			bool minimum = play(seed, Policy::MinimumProbability, minimumGuesses);
+			bool lookahead = play(seed, Policy::Lookahead, lookaheadGuesses);
+			minimumWins += minimum;
+			lookaheadWins += lookahead;
+			onlyMinimum += minimum && !lookahead;
+			onlyLookahead += lookahead && !minimum;
+		}
+	}
+
+	double games = GAMES;
+	double difference = (static_cast<double>(onlyLookahead) - static_cast<double>(onlyMinimum)) / games;
+	double variance = (onlyLookahead + onlyMinimum) / games - difference * difference;
+
+	state.counters["minimum probability win rate"] = minimumWins / games;
+	state.counters["lookahead win rate"] = lookaheadWins / games;
+	state.counters["gain"] = difference;
+	state.counters["gain 95% CI"] = CONFIDENCE_Z * std::sqrt(variance / games);
+	state.counters["only minimum probability won"] = onlyMinimum;
+	state.counters["only lookahead won"] = onlyLookahead;
+	state.counters["minimum probability guesses/game"] = minimumGuesses / games;
+	state.counters["lookahead guesses/game"] = lookaheadGuesses / games;
+}
+BENCHMARK(BM_GuessPolicyWinRate)
+	->Iterations(1)
+	->Unit(benchmark::kSecond)
+	->UseRealTime();
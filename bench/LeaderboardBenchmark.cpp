@@ -0,0 +1,195 @@
+#include "Difficulties.h"
+#include "NamePool.h"
+#include "Scheduler.h"
+#include "ScoreFile.h"
+#include "ScoreJournal.h"
+#include "ScoreRecord.h"
+
+#include <benchmark/benchmark.h>
+
+#include <filesystem>
+#include <format>
+#include <functional>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+#define NAMES 100
+#define DIFFICULTY 200
+/// The threshold of the leaderboards of the game, see Status.
+#define PARALLEL_SORT_RECORDS 65536
+
+namespace
+{
+
+/// Records of random scores and players, every record has its own hash.
+std::vector<ScoreRecord> records(NamePool &names, int64_t count)
+{
+	std::mt19937_64 random(1);
+	std::vector<uint32_t> players;
+	for (int i = 0; i < NAMES; i++) {
+		players.push_back(names.intern(std::format("player{}", i)));
+	}
+
+	std::vector<ScoreRecord> result(count);
+	for (int64_t i = 0; i < count; i++) {
+		result[i] = {
+			.score = static_cast<int64_t>(random() % 100'000),
+			.hash = static_cast<uint64_t>(i) + 1,
+			.name = players[random() % NAMES],
+			.width = 20,
+			.height = 20,
+			.numberOfMines = 80,
+			.time = static_cast<uint32_t>(random() % 1000 + 1),
+			.bbbv = static_cast<uint32_t>(random() % 150 + 1),
+			.clicks = static_cast<uint32_t>(random() % 300 + 1),
+		};
+	}
+	return result;
+}
+
+DifficultyTab leaderboard(NamePool &names, int64_t count)
+{
+	auto content = records(names, count);
+	DifficultyTab tab;
+	tab.push(content.begin(), content.end());
+	return tab;
+}
+
+/// Directory of the files of the benchmarks, emptied on every call.
+std::filesystem::path scratch(std::string_view name)
+{
+	auto path = std::filesystem::temp_directory_path() / "minesweeper-bench" / name;
+	std::filesystem::remove_all(path);
+	std::filesystem::create_directories(path);
+	return path;
+}
+
+/// Write the records to a score file in the legacy text format.
+std::string writeLegacy(const std::filesystem::path &directory, NamePool &names, int64_t count)
+{
+	auto path = (directory / "scores.txt").string();
+	std::ofstream file(path);
+	file << "0\n" << DIFFICULTY << '\n';
+	for (const auto &record : records(names, count)) {
+		file << std::format("{} {} {} {} {} {}\n", record.score, names.name(record.name), record.numberOfMines,
+			record.hash, record.width, record.height);
+	}
+	return path;
+}
+
+/// Number of the records of all the difficulties.
+int64_t recordCount(const ScoreFile::Contents &contents)
+{
+	int64_t count = 0;
+	for (const auto &[difficulty, tab] : contents.sections) {
+		count += tab.size();
+	}
+	return count;
+}
+
+}
+
+/// Push of one record into a full leaderboard, the record is inserted at its place.
+static void BM_LeaderboardPush(benchmark::State &state)
+{
+	NamePool names;
+	auto tab = leaderboard(names, state.range(0));
+	auto record = tab.back();
+
+	for (auto _ : state) {
+		tab.push(record);
+		tab.pop();
+	}
+}
+BENCHMARK(BM_LeaderboardPush)->Apply(leaderboardSizes)->Unit(benchmark::kMillisecond);
+
+/// Change of the sort order of a full leaderboard, switching between the score and the 3BV/s as the menu does.
+static void BM_LeaderboardSetSorter(benchmark::State &state)
+{
+	Scheduler scheduler;
+	NamePool names;
+	auto tab = leaderboard(names, state.range(0));
+
+	bool byScore = false;
+	for (auto _ : state) {
+		std::function<bool(const ScoreRecord &, const ScoreRecord &)> compare = std::greater<ScoreRecord>();
+		if (!byScore) {
+			compare = [](const ScoreRecord &lhs, const ScoreRecord &rhs) {
+				return lhs.bbbvPerSecond() > rhs.bbbvPerSecond();
+			};
+		}
+		tab.setSorter(compare, /*invoke*/ false);
+		scheduler.sort(tab.begin(), tab.end(), compare, PARALLEL_SORT_RECORDS);
+		byScore = !byScore;
+	}
+
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_LeaderboardSetSorter)->Apply(leaderboardSizes)->Unit(benchmark::kMillisecond);
+
+/// Import of the score file of older versions.
+static void BM_ScoreFileParse(benchmark::State &state)
+{
+	Scheduler scheduler;
+	NamePool names;
+	auto path = writeLegacy(scratch("legacy"), names, state.range(0));
+	if (NamePool pool; recordCount(ScoreFile(path).parse(pool, &scheduler)) != state.range(0)) {
+		state.SkipWithError("The score file was not parsed completely");
+		return;
+	}
+
+	for (auto _ : state) {
+		NamePool pool;
+		auto contents = ScoreFile(path).parse(pool, &scheduler);
+		benchmark::DoNotOptimize(contents.sections.size());
+	}
+
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ScoreFileParse)->Apply(leaderboardSizes)->Unit(benchmark::kMillisecond);
+
+/// Start of the game, the leaderboard is read from the compacted snapshot.
+static void BM_ScoreJournalLoad(benchmark::State &state)
+{
+	Scheduler scheduler;
+	auto directory = scratch("load");
+	auto journal = (directory / "scores").string();
+	std::string legacy;
+	{
+		// The first load imports the legacy file into the snapshot.
+		NamePool names;
+		legacy = writeLegacy(directory, names, state.range(0));
+		if (recordCount(ScoreJournal(journal, names, &scheduler).load(legacy)) != state.range(0)) {
+			state.SkipWithError("The score file was not imported completely");
+			return;
+		}
+	}
+
+	for (auto _ : state) {
+		NamePool names;
+		auto contents = ScoreJournal(journal, names, &scheduler).load(legacy);
+		benchmark::DoNotOptimize(contents.sections.size());
+	}
+
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ScoreJournalLoad)->Apply(leaderboardSizes)->Unit(benchmark::kMillisecond);
+
+/// Save of one new record at the end of a game.
+static void BM_ScoreJournalAppend(benchmark::State &state)
+{
+	Scheduler scheduler;
+	auto directory = scratch("append");
+	NamePool names;
+	ScoreJournal journal((directory / "scores").string(), names, &scheduler);
+	journal.load((directory / "scores.txt").string());
+	auto content = records(names, 1);
+
+	for (auto _ : state) {
+		content[0].hash++;
+		journal.append(DIFFICULTY, content[0]);
+	}
+}
+BENCHMARK(BM_ScoreJournalAppend)->Unit(benchmark::kMicrosecond);
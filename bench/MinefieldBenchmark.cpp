@@ -0,0 +1,161 @@
+#include "Difficulties.h"
+#include "Minefield.h"
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+namespace
+{
+
+int center(int size)
+{
+	return (size / 2) * size + size / 2;
+}
+
+/// Field with the mines placed from the seed and the first click revealed.
+Minefield opened(int size, uint64_t seed)
+{
+	Minefield field(size, size, size * size / 5);
+	field.generate(center(size), seed);
+	field.reveal(center(size));
+	return field;
+}
+
+}
+
+/// Random placement of the mines, the counts of the adjacent mines and the 3BV, the work of the first click.
+static void BM_Generate(benchmark::State &state)
+{
+	int size = state.range(0);
+	Minefield field(size, size, size * size / 5);
+
+	uint64_t seed = 1;
+	for (auto _ : state) {
+		field.generate(center(size), seed++);
+		benchmark::DoNotOptimize(field.bbbv());
+	}
+
+	state.SetItemsProcessed(state.iterations() * field.size());
+}
+BENCHMARK(BM_Generate)->Apply(boardSizes)->Unit(benchmark::kMicrosecond);
+
+/// Counting the adjacent mines of the given layout, without the random generator.
+static void BM_PlaceMines(benchmark::State &state)
+{
+	int size = state.range(0);
+	Minefield field(size, size, size * size / 5);
+	field.generate(center(size), 1);
+
+	std::vector<int> mines;
+	for (int cell = 0; cell < field.size(); cell++) {
+		if (field.isMine(cell)) {
+			mines.push_back(cell);
+		}
+	}
+
+	for (auto _ : state) {
+		field.placeMines(mines);
+		benchmark::DoNotOptimize(field.adjacentMines(0));
+	}
+
+	state.SetItemsProcessed(state.iterations() * field.size());
+}
+BENCHMARK(BM_PlaceMines)->Apply(boardSizes)->Unit(benchmark::kMicrosecond);
+
+/// Reading the adjacent mines of every cell, what the renderer does every frame.
+static void BM_AdjacentMines(benchmark::State &state)
+{
+	int size = state.range(0);
+	auto field = opened(size, 1);
+
+	for (auto _ : state) {
+		int sum = 0;
+		for (int cell = 0; cell < field.size(); cell++) {
+			sum += field.adjacentMines(cell);
+		}
+		benchmark::DoNotOptimize(sum);
+	}
+
+	state.SetItemsProcessed(state.iterations() * field.size());
+}
+BENCHMARK(BM_AdjacentMines)->Apply(boardSizes)->Unit(benchmark::kMicrosecond);
+
+/// Flood fill of a board with a single mine in the corner, the first click reveals all the other cells.
+static void BM_FloodReveal(benchmark::State &state)
+{
+	int size = state.range(0);
+	int mine = 0;
+	Minefield field(size, size, 1);
+
+	for (auto _ : state) {
+		state.PauseTiming();
+		field.placeMines({ &mine, 1 });
+		state.ResumeTiming();
+
+		field.reveal(center(size));
+		benchmark::DoNotOptimize(field.changes().data());
+	}
+
+	state.SetItemsProcessed(state.iterations() * (field.size() - 1));
+}
+BENCHMARK(BM_FloodReveal)->Apply(boardSizes)->Unit(benchmark::kMicrosecond);
+
+/// Chord on a revealed number with all its mines flagged.
+static void BM_Chord(benchmark::State &state)
+{
+	int size = state.range(0);
+	auto field = opened(size, 1);
+
+	// A number on the border of the opening, flagged the way a player would before chording.
+	int number = -1;
+	for (int cell = 0; cell < field.size() && number == -1; cell++) {
+		if (!field.isRevealed(cell) || field.adjacentMines(cell) == 0) {
+			continue;
+		}
+		bool hiddenSafe = false;
+		field.forEachNeighbour(cell, [&field, &hiddenSafe](int neighbour) {
+			hiddenSafe |= !field.isRevealed(neighbour) && !field.isMine(neighbour);
+		});
+		if (hiddenSafe) {
+			number = cell;
+		}
+	}
+	if (number == -1) {
+		state.SkipWithError("No number to chord");
+		return;
+	}
+	field.forEachNeighbour(number, [&field](int neighbour) {
+		if (field.isMine(neighbour)) {
+			field.toggleFlag(neighbour);
+		}
+	});
+
+	for (auto _ : state) {
+		state.PauseTiming();
+		auto copy = field;
+		state.ResumeTiming();
+
+		copy.chord(number);
+		benchmark::DoNotOptimize(copy.changes().data());
+	}
+}
+BENCHMARK(BM_Chord)->Apply(boardSizes)->Unit(benchmark::kMicrosecond);
+
+/// Flag toggle followed by the check of the end of the game, the check done after every action.
+static void BM_ToggleFlag(benchmark::State &state)
+{
+	int size = state.range(0);
+	auto field = opened(size, 1);
+
+	int hidden = 0;
+	while (field.isRevealed(hidden)) {
+		hidden++;
+	}
+
+	for (auto _ : state) {
+		field.toggleFlag(hidden);
+		benchmark::DoNotOptimize(field.state());
+	}
+}
+BENCHMARK(BM_ToggleFlag)->Apply(boardSizes);
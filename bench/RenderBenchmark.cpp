@@ -0,0 +1,170 @@
+#include "Application.h"
+#include "Board.h"
+#include "Status.h"
+
+#include <benchmark/benchmark.h>
+
+#include "imgui.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <new>
+#include <random>
+#include <thread>
+
+#define FRAMES 1000
+#define FRAME_TIME (1.0f / 60.0f)
+#define WINDOW_WIDTH 1000
+#define WINDOW_HEIGHT 720
+#define STATUS_WIDTH 350
+/// A click every this many frames, the mouse moves over the board in between.
+#define CLICK_PERIOD 30
+
+namespace
+{
+
+/// Heap allocations of the whole process, counted by the replaced global operator new.
+std::atomic<uint64_t> g_allocations = 0;
+
+/// Allocations of ImGui, counted by its allocator hooks.
+std::atomic<uint64_t> g_imguiAllocations = 0;
+
+void *imguiAlloc(size_t size, void *)
+{
+	g_imguiAllocations.fetch_add(1, std::memory_order_relaxed);
+	return std::malloc(size);
+}
+
+void imguiFree(void *pointer, void *)
+{
+	std::free(pointer);
+}
+
+/// Score file in the legacy text format with the given number of records of the first difficulty.
+void writeScores(const std::filesystem::path &directory, int64_t count)
+{
+	std::mt19937_64 random(1);
+	std::ofstream file(directory / "scores.txt");
+	file << "0\n0\n";
+	for (int64_t i = 0; i < count; i++) {
+		file << random() % 100'000 << " player" << random() % 100 << " 20 " << i + 1 << " 10 10\n";
+	}
+}
+
+}
+
+void *operator new(size_t size)
+{
+	g_allocations.fetch_add(1, std::memory_order_relaxed);
+	if (void *pointer = std::malloc(size ? size : 1)) {
+		return pointer;
+	}
+	throw std::bad_alloc();
+}
+
+void operator delete(void *pointer) noexcept
+{
+	std::free(pointer);
+}
+
+void operator delete(void *pointer, size_t) noexcept
+{
+	std::free(pointer);
+}
+
+/**
+ * CPU cost of one frame of the whole UI without a display.
+ *
+ * The application runs without any platform or renderer backend, so only the layers building the draw lists are
+ * measured. The mouse sweeps over the board and clicks a tile from time to time, so the frames include the game
+ * actions and the end of the games. The scores are loaded from a generated score file in a scratch directory, all
+ * the rows of the leaderboard are drawn every frame.
+ */
+static void BM_RenderFrame(benchmark::State &state)
+{
+	int size = state.range(0);
+	auto leaderboard = state.range(1);
+
+	auto previous = std::filesystem::current_path();
+	auto directory = std::filesystem::temp_directory_path() / "minesweeper-bench" / "render";
+	std::filesystem::remove_all(directory);
+	std::filesystem::create_directories(directory);
+	writeScores(directory, leaderboard);
+	std::filesystem::current_path(directory);
+
+	ImGui::SetAllocatorFunctions(imguiAlloc, imguiFree);
+	{
+		auto app = Application::create({ "Minesweeper", WINDOW_WIDTH, WINDOW_HEIGHT, false, false, true, "" },
+			Application::RenderBackend::Headless);
+		app->addLayer(Board::create(size, size, size * size / 5));
+		auto status = Status::create();
+		app->addLayer(status);
+		while (!status->scoreFileLoaded()) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+
+		// The first frame creates the windows, then they get the layout of the game.
+		app->frame(FRAME_TIME);
+		ImGui::SetWindowPos("Board", ImVec2(0, 0));
+		ImGui::SetWindowSize("Board", ImVec2(WINDOW_WIDTH - STATUS_WIDTH, WINDOW_HEIGHT));
+		ImGui::SetWindowPos("Game Status", ImVec2(WINDOW_WIDTH - STATUS_WIDTH, 0));
+		ImGui::SetWindowSize("Game Status", ImVec2(STATUS_WIDTH, WINDOW_HEIGHT));
+		app->frame(FRAME_TIME);
+
+		auto &io = ImGui::GetIO();
+		std::mt19937 random(1);
+		std::uniform_real_distribution<float> x(0, WINDOW_WIDTH - STATUS_WIDTH);
+		std::uniform_real_distribution<float> y(0, WINDOW_HEIGHT);
+
+		uint64_t frame = 0;
+		uint64_t vertices = 0;
+		uint64_t commands = 0;
+		auto allocations = g_allocations.load();
+		auto imguiAllocations = g_imguiAllocations.load();
+		for (auto _ : state) {
+			// A click is a press in one frame and a release in the next one.
+			switch (frame++ % CLICK_PERIOD) {
+			case 0:
+				io.AddMousePosEvent(x(random), y(random));
+				io.AddMouseButtonEvent(frame % 3 == 0 ? ImGuiMouseButton_Right : ImGuiMouseButton_Left, true);
+				break;
+			case 1:
+				io.AddMouseButtonEvent(ImGuiMouseButton_Left, false);
+				io.AddMouseButtonEvent(ImGuiMouseButton_Right, false);
+				break;
+			default:
+				io.AddMousePosEvent(x(random), y(random));
+				break;
+			}
+
+			app->frame(FRAME_TIME);
+
+			auto *data = ImGui::GetDrawData();
+			vertices += data->TotalVtxCount;
+			for (int i = 0; i < data->CmdListsCount; i++) {
+				commands += data->CmdLists[i]->CmdBuffer.Size;
+			}
+		}
+
+		state.counters["vertices/frame"] = benchmark::Counter(vertices, benchmark::Counter::kAvgIterations);
+		state.counters["commands/frame"] = benchmark::Counter(commands, benchmark::Counter::kAvgIterations);
+		state.counters["allocs/frame"] =
+			benchmark::Counter(g_allocations - allocations, benchmark::Counter::kAvgIterations);
+		state.counters["imgui allocs/frame"] =
+			benchmark::Counter(g_imguiAllocations - imguiAllocations, benchmark::Counter::kAvgIterations);
+
+		auto statistics = app->scheduler().statistics();
+		state.counters["tasks"] = statistics.tasks;
+		state.counters["steals"] = statistics.steals;
+		state.counters["sequential loops"] = statistics.sequentialCalls;
+		state.counters["parallel loops"] = statistics.parallelCalls;
+	}
+
+	std::filesystem::current_path(previous);
+}
+BENCHMARK(BM_RenderFrame)
+	->ArgsProduct({ { 10, 20, 50 }, { 100, 1'000, 10'000 } })
+	->Iterations(FRAMES)
+	->Unit(benchmark::kMicrosecond);
@@ -4,6 +4,10 @@
 
 #include <memory>
 
+#define SNAPSHOT_FILE "game.snapshot"
+/// Shared memory segment the board is published into for the overlays, see ObserverReader.
+#define OBSERVER_FEED "/minesweeper-board"
+
 int main(int argc, char *argv[])
 {
 	auto app = Application::create({
@@ -16,7 +20,11 @@ int main(int argc, char *argv[])
 		"../font/BitstromWeraNerdFontMono-Regular.ttf"
 	});
 
-	app->addLayer(Board::create(10, 10, 20));
+	// The game left unfinished by the last run goes on.
+	auto board = Board::create(10, 10, 20);
+	board->resume(SNAPSHOT_FILE);
+	board->observe(OBSERVER_FEED);
+	app->addLayer(board);
 	app->addLayer(Status::create());
 
 	return app->run();
@@ -0,0 +1,127 @@
+#pragma once
+
+#include "PackedTile.h"
+
+#include <bit>
+#include <cstdint>
+#include <type_traits>
+
+/**
+ * @file ArenaProtocol.h
+ * @brief Binary protocol of the bot arena, see @c ArenaServer.
+ *
+ * Every message is an @c ArenaHeader followed by the payload of its type. All the fields are little endian and the
+ * size of the header counts the whole message. A client may send any number of requests without waiting for the
+ * replies, the replies come in the order of the requests.
+ *
+ * The requests and their payloads:
+ * - @c ArenaMessage::NewGame, @c ArenaNewGame: start the game with the number in the header, replacing any game of
+ *   the connection with the same number. The mines are placed by the first action, so it never hits one.
+ * - @c ArenaMessage::Reveal, @c ArenaMessage::Flag, @c ArenaMessage::Chord, @c ArenaAction: the action of the
+ *   player on the cell.
+ * - @c ArenaMessage::Observe, no payload: all the cells of the game that are not hidden.
+ * - @c ArenaMessage::Close, no payload: forget the game.
+ *
+ * The reply to every request has the type of the request with @c ARENA_REPLY set, the game of the request and an
+ * @c ArenaStatus. Its payload is an @c ArenaDelta followed by its cells, one @c uint32_t each: the index of the cell
+ * in the low 24 bits and its @c PackedTile in the high 8 bits. The cells of an action are the cells it changed, the
+ * end of the game adds the mines and the wrong flags it uncovered.
+ */
+
+/// Types of the messages, the replies have @c ARENA_REPLY set.
+enum class ArenaMessage : uint8_t
+{
+	NewGame = 1,
+	Reveal,
+	Flag,
+	Chord,
+	Observe,
+	Close,
+};
+
+/// Bit of the type of the replies.
+constexpr uint8_t ARENA_REPLY = 0x80;
+
+/// Number of the request types, for the counters indexed by the type.
+constexpr int ARENA_MESSAGE_TYPES = static_cast<int>(ArenaMessage::Close) + 1;
+
+/// Outcome of a request.
+enum class ArenaStatus : uint8_t
+{
+	Ok,
+	/// The connection has no game with the number.
+	UnknownGame,
+	/// The cell of the action is not on the board.
+	InvalidCell,
+	/// The dimensions or the number of the mines of a new game are not allowed.
+	InvalidBoard,
+	/// The connection has too many games already.
+	TooManyGames,
+	/// The message can not be decoded, the connection is closed after the reply.
+	Malformed,
+};
+
+/// State of a game, the same as @c Minefield::State.
+enum class ArenaState : uint8_t
+{
+	Playing,
+	Win,
+	Lose,
+};
+
+struct ArenaHeader
+{
+	/// Size of the whole message in bytes.
+	uint32_t size;
+	uint8_t type;
+	/// @c ArenaStatus of a reply, zero in the requests.
+	uint8_t status;
+	uint16_t reserved;
+	/// Number of the game chosen by the client.
+	uint32_t game;
+};
+
+struct ArenaNewGame
+{
+	uint16_t width;
+	uint16_t height;
+	uint32_t numberOfMines;
+	/// Seed of the mines, zero for a random one.
+	uint64_t seed;
+};
+
+struct ArenaAction
+{
+	/// Index of the cell, y * width + x.
+	uint32_t cell;
+};
+
+struct ArenaDelta
+{
+	/// @c ArenaState of the game after the request.
+	uint8_t state;
+	uint8_t reserved[3];
+	/// Number of the cells following the delta.
+	uint32_t count;
+};
+
+/// Largest number of cells of a board, the index of a cell has to fit in the 24 bits of a delta cell.
+constexpr uint32_t ARENA_MAX_CELLS = 1 << 16;
+
+constexpr uint32_t ARENA_CELL_BITS = 24;
+constexpr uint32_t ARENA_CELL_MASK = (1 << ARENA_CELL_BITS) - 1;
+
+constexpr uint32_t arenaPackCell(uint32_t cell, PackedTile tile)
+{
+	return cell | static_cast<uint32_t>(tile) << ARENA_CELL_BITS;
+}
+
+constexpr uint32_t arenaCell(uint32_t packed) { return packed & ARENA_CELL_MASK; }
+constexpr PackedTile arenaTile(uint32_t packed) { return static_cast<PackedTile>(packed >> ARENA_CELL_BITS); }
+
+// The structures are copied to and from the wire as they are.
+static_assert(std::endian::native == std::endian::little, "The arena protocol is little endian");
+static_assert(sizeof(ArenaHeader) == 12 && std::is_trivially_copyable_v<ArenaHeader>);
+static_assert(sizeof(ArenaNewGame) == 16 && std::is_trivially_copyable_v<ArenaNewGame>);
+static_assert(sizeof(ArenaAction) == 4 && std::is_trivially_copyable_v<ArenaAction>);
+static_assert(sizeof(ArenaDelta) == 8 && std::is_trivially_copyable_v<ArenaDelta>);
@@ -0,0 +1,554 @@
+#include "ArenaServer.h"
+
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string_view>
+
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#define LISTEN_BACKLOG 128
+#define MAX_EVENTS 256
+/// Bytes read from a connection at once, the other connections are served before it is read again.
+#define READ_CHUNK (64 * 1024)
+/// Largest request, a new game is the longest one.
+#define MAX_REQUEST_SIZE (sizeof(ArenaHeader) + sizeof(ArenaNewGame))
+/// The connection is not read while it has more replies waiting to be sent.
+#define MAX_PENDING_OUTPUT (4 * 1024 * 1024)
+/// Cells that are never mined around the first action, see Minefield::generate.
+#define SAFE_CELLS 9
+
+namespace
+{
+
+constexpr std::array<std::string_view, ARENA_MESSAGE_TYPES> MESSAGE_NAMES {
+	"", "new_game", "reveal", "flag", "chord", "observe", "close",
+};
+
+/// Size of the payload of the request type.
+size_t payloadSize(ArenaMessage type)
+{
+	switch (type) {
+	case ArenaMessage::NewGame:
+		return sizeof(ArenaNewGame);
+	case ArenaMessage::Reveal:
+	case ArenaMessage::Flag:
+	case ArenaMessage::Chord:
+		return sizeof(ArenaAction);
+	case ArenaMessage::Observe:
+	case ArenaMessage::Close:
+		return 0;
+	}
+	return 0;
+}
+
+template <typename T>
+void append(std::vector<char> &output, const T &value)
+{
+	auto bytes = reinterpret_cast<const char *>(&value);
+	output.insert(output.end(), bytes, bytes + sizeof(T));
+}
+
+template <typename T>
+T load(const char *data)
+{
+	T value;
+	std::memcpy(&value, data, sizeof(T));
+	return value;
+}
+
+ArenaState arenaState(Minefield::State state)
+{
+	return static_cast<ArenaState>(state);
+}
+
+}
+
+uint64_t ArenaServer::Metrics::totalRequests() const
+{
+	uint64_t total = 0;
+	for (auto count : requests) {
+		total += count;
+	}
+	return total;
+}
+
+double ArenaServer::Metrics::latencyQuantile(double quantile) const
+{
+	uint64_t total = 0;
+	for (auto count : latency) {
+		total += count;
+	}
+	if (total == 0) {
+		return 0;
+	}
+
+	auto target = std::max<uint64_t>(1, std::ceil(quantile * total));
+	uint64_t cumulative = 0;
+	for (int bucket = 0; bucket < LATENCY_BUCKETS; bucket++) {
+		cumulative += latency[bucket];
+		if (cumulative >= target) {
+			return static_cast<double>(uint64_t(1) << bucket) / 1000;
+		}
+	}
+	return static_cast<double>(uint64_t(1) << (LATENCY_BUCKETS - 1)) / 1000;
+}
+
+ArenaServer::ArenaServer(const Options &options)
+	: m_options(options)
+	, m_listener(-1)
+	, m_epoll(-1)
+	, m_random(std::random_device()())
+	, m_lastRequests(0)
+	, m_lastMetrics(Clock::now())
+{
+}
+
+ArenaServer::~ArenaServer()
+{
+	for (auto &[fd, connection] : m_connections) {
+		::close(fd);
+	}
+	if (m_listener >= 0) {
+		::close(m_listener);
+		::unlink(m_options.socket.c_str());
+	}
+	if (m_epoll >= 0) {
+		::close(m_epoll);
+	}
+}
+
+bool ArenaServer::listen()
+{
+	sockaddr_un address {};
+	address.sun_family = AF_UNIX;
+	if (m_options.socket.size() >= sizeof(address.sun_path)) {
+		errno = ENAMETOOLONG;
+		return false;
+	}
+	std::memcpy(address.sun_path, m_options.socket.c_str(), m_options.socket.size() + 1);
+
+	m_epoll = ::epoll_create1(EPOLL_CLOEXEC);
+	if (m_epoll < 0) {
+		return false;
+	}
+	m_listener = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (m_listener < 0) {
+		return false;
+	}
+
+	// The socket file of a previous run that was not stopped cleanly.
+	::unlink(m_options.socket.c_str());
+	if (::bind(m_listener, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) < 0
+		|| ::listen(m_listener, LISTEN_BACKLOG) < 0)
+	{
+		int error = errno;
+		::close(m_listener);
+		m_listener = -1;
+		errno = error;
+		return false;
+	}
+
+	epoll_event event {};
+	event.events = EPOLLIN;
+	event.data.fd = m_listener;
+	return ::epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_listener, &event) == 0;
+}
+
+bool ArenaServer::writeMetrics(const std::string &path)
+{
+	auto now = Clock::now();
+	double seconds = std::chrono::duration<double>(now - m_lastMetrics).count();
+	uint64_t requests = m_metrics.totalRequests();
+	double rate = seconds > 0 ? (requests - m_lastRequests) / seconds : 0;
+	m_lastMetrics = now;
+	m_lastRequests = requests;
+
+	// The readers of the file never see it half written.
+	auto temporary = path + ".tmp";
+	std::unique_ptr<FILE, decltype(&fclose)> file(fopen(temporary.c_str(), "w"), fclose);
+	if (!file) {
+		return false;
+	}
+
+	auto counter = [&file](std::string_view name, uint64_t value) {
+		fprintf(file.get(), "%s\t%llu\n", name.data(), static_cast<unsigned long long>(value));
+	};
+	counter("connections", m_metrics.connections);
+	counter("active_connections", m_metrics.activeConnections);
+	counter("rejected_connections", m_metrics.rejectedConnections);
+	counter("active_games", m_metrics.activeGames);
+	counter("requests", requests);
+	for (int type = 1; type < ARENA_MESSAGE_TYPES; type++) {
+		fprintf(file.get(), "requests_%s\t%llu\n", MESSAGE_NAMES[type].data(),
+			static_cast<unsigned long long>(m_metrics.requests[type]));
+	}
+	counter("errors", m_metrics.errors);
+	counter("wins", m_metrics.wins);
+	counter("losses", m_metrics.losses);
+	counter("bytes_received", m_metrics.bytesReceived);
+	counter("bytes_sent", m_metrics.bytesSent);
+	fprintf(file.get(), "requests_per_second\t%.1f\n", rate);
+	fprintf(file.get(), "latency_p50_us\t%.3f\n", m_metrics.latencyQuantile(0.5));
+	fprintf(file.get(), "latency_p90_us\t%.3f\n", m_metrics.latencyQuantile(0.9));
+	fprintf(file.get(), "latency_p99_us\t%.3f\n", m_metrics.latencyQuantile(0.99));
+	fprintf(file.get(), "latency_max_us\t%.3f\n", m_metrics.latencyQuantile(1));
+
+	if (fflush(file.get()) != 0 || ferror(file.get())) {
+		return false;
+	}
+	file.reset();
+
+	std::error_code error;
+	std::filesystem::rename(temporary, path, error);
+	return !error;
+}
+
+bool ArenaServer::poll(std::chrono::milliseconds timeout)
+{
+	std::array<epoll_event, MAX_EVENTS> events;
+	int count = ::epoll_wait(m_epoll, events.data(), events.size(), timeout.count());
+	if (count < 0) {
+		// A signal, the caller checks whether it is to stop.
+		return errno == EINTR;
+	}
+
+	for (int i = 0; i < count; i++) {
+		int fd = events[i].data.fd;
+		if (fd == m_listener) {
+			accept();
+			continue;
+		}
+
+		auto found = m_connections.find(fd);
+		if (found == m_connections.end()) {
+			continue;
+		}
+
+		auto &connection = *found->second;
+		bool open = (events[i].events & EPOLLERR) == 0;
+		if (open && (events[i].events & EPOLLOUT)) {
+			open = serve(connection);
+		}
+		if (open && (events[i].events & (EPOLLIN | EPOLLHUP))) {
+			open = receive(connection);
+		}
+		if (!open) {
+			close(connection);
+		}
+	}
+	return true;
+}
+
+void ArenaServer::accept()
+{
+	while (true) {
+		int fd = ::accept4(m_listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+		if (fd < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			// No more pending connections, or no descriptors left for them until some are closed.
+			return;
+		}
+
+		if (static_cast<int>(m_connections.size()) >= m_options.maxConnections) {
+			::close(fd);
+			m_metrics.rejectedConnections++;
+			continue;
+		}
+
+		auto connection = std::make_unique<Connection>();
+		connection->fd = fd;
+		connection->events = EPOLLIN;
+
+		epoll_event event {};
+		event.events = connection->events;
+		event.data.fd = fd;
+		if (::epoll_ctl(m_epoll, EPOLL_CTL_ADD, fd, &event) < 0) {
+			::close(fd);
+			m_metrics.rejectedConnections++;
+			continue;
+		}
+
+		m_connections.emplace(fd, std::move(connection));
+		m_metrics.connections++;
+		m_metrics.activeConnections++;
+	}
+}
+
+bool ArenaServer::receive(Connection &connection)
+{
+	auto &input = connection.input;
+	size_t size = input.size();
+	input.resize(size + READ_CHUNK);
+	ssize_t count = ::recv(connection.fd, input.data() + size, READ_CHUNK, 0);
+	input.resize(size + std::max<ssize_t>(count, 0));
+
+	if (count < 0) {
+		return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+	}
+	m_metrics.bytesReceived += count;
+	// The peer closed its side, the requests it sent before are still answered.
+	connection.finished = count == 0;
+	return serve(connection);
+}
+
+bool ArenaServer::serve(Connection &connection)
+{
+	bool more = true;
+	while (more) {
+		more = process(connection);
+		if (!flush(connection)) {
+			return false;
+		}
+		// The requests left over by a full output are handled as soon as it drains.
+		more = more && connection.output.empty();
+	}
+
+	if (connection.output.empty() && (connection.closing || connection.finished)) {
+		return false;
+	}
+	watch(connection);
+	return true;
+}
+
+bool ArenaServer::process(Connection &connection)
+{
+	auto &input = connection.input;
+	size_t offset = 0;
+	bool full = false;
+	while (!connection.closing && input.size() - offset >= sizeof(ArenaHeader)) {
+		if (connection.output.size() - connection.written >= MAX_PENDING_OUTPUT) {
+			full = true;
+			break;
+		}
+
+		auto header = load<ArenaHeader>(input.data() + offset);
+		if (header.size < sizeof(ArenaHeader) || header.size > MAX_REQUEST_SIZE) {
+			header.size = sizeof(ArenaHeader);
+			// The cells of the previous request are not a part of the reply.
+			m_cells.clear();
+			reply(connection, header, ArenaStatus::Malformed, ArenaState::Playing);
+			connection.closing = true;
+			break;
+		}
+		if (input.size() - offset < header.size) {
+			break;
+		}
+
+		// Every request of the batch is timed on its own, the requests before it do not count.
+		auto started = Clock::now();
+		connection.closing = !handle(connection, header, input.data() + offset + sizeof(ArenaHeader));
+		offset += header.size;
+		measure(started);
+	}
+	input.erase(input.begin(), input.begin() + offset);
+	return full;
+}
+
+bool ArenaServer::flush(Connection &connection)
+{
+	auto &output = connection.output;
+	while (connection.written < output.size()) {
+		ssize_t count = ::send(connection.fd, output.data() + connection.written, output.size() - connection.written,
+			MSG_NOSIGNAL);
+		if (count < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return errno == EAGAIN || errno == EWOULDBLOCK;
+		}
+		connection.written += count;
+		m_metrics.bytesSent += count;
+	}
+
+	output.clear();
+	connection.written = 0;
+	return true;
+}
+
+void ArenaServer::close(Connection &connection)
+{
+	int fd = connection.fd;
+	m_metrics.activeGames -= connection.games.size();
+	m_metrics.activeConnections--;
+	::epoll_ctl(m_epoll, EPOLL_CTL_DEL, fd, nullptr);
+	::close(fd);
+	m_connections.erase(fd);
+}
+
+void ArenaServer::watch(Connection &connection)
+{
+	size_t pending = connection.output.size() - connection.written;
+	uint32_t events = 0;
+	if (!connection.closing && !connection.finished && pending < MAX_PENDING_OUTPUT) {
+		events |= EPOLLIN;
+	}
+	if (pending > 0) {
+		events |= EPOLLOUT;
+	}
+	if (events == connection.events) {
+		return;
+	}
+
+	epoll_event event {};
+	event.events = events;
+	event.data.fd = connection.fd;
+	::epoll_ctl(m_epoll, EPOLL_CTL_MOD, connection.fd, &event);
+	connection.events = events;
+}
+
+bool ArenaServer::handle(Connection &connection, const ArenaHeader &header, const char *payload)
+{
+	m_cells.clear();
+	auto type = static_cast<ArenaMessage>(header.type);
+	if (header.type == 0 || header.type >= ARENA_MESSAGE_TYPES
+		|| header.size != sizeof(ArenaHeader) + payloadSize(type))
+	{
+		reply(connection, header, ArenaStatus::Malformed, ArenaState::Playing);
+		return false;
+	}
+	m_metrics.requests[header.type]++;
+
+	auto found = connection.games.find(header.game);
+	if (type == ArenaMessage::NewGame) {
+		auto request = load<ArenaNewGame>(payload);
+		int64_t cells = static_cast<int64_t>(request.width) * request.height;
+		if (cells == 0 || cells > ARENA_MAX_CELLS || request.numberOfMines > std::max<int64_t>(cells - SAFE_CELLS, 0)) {
+			reply(connection, header, ArenaStatus::InvalidBoard, ArenaState::Playing);
+			return true;
+		}
+		if (found == connection.games.end() && static_cast<int>(connection.games.size()) >= m_options.maxGames) {
+			reply(connection, header, ArenaStatus::TooManyGames, ArenaState::Playing);
+			return true;
+		}
+
+		Game game {
+			Minefield(request.width, request.height, request.numberOfMines),
+			request.seed != 0 ? request.seed : m_random(),
+		};
+		if (found != connection.games.end()) {
+			found->second = std::move(game);
+		}
+		else {
+			connection.games.emplace(header.game, std::move(game));
+			m_metrics.activeGames++;
+		}
+		reply(connection, header, ArenaStatus::Ok, ArenaState::Playing);
+		return true;
+	}
+
+	if (found == connection.games.end()) {
+		reply(connection, header, ArenaStatus::UnknownGame, ArenaState::Playing);
+		return true;
+	}
+
+	auto &game = found->second;
+	auto &field = game.field;
+	auto state = arenaState(field.state());
+	switch (type) {
+	case ArenaMessage::Observe:
+		for (int cell = 0; cell < field.size(); cell++) {
+			if (auto tile = field.packedTile(cell); tile != PackedTile::Hidden) {
+				m_cells.push_back(arenaPackCell(cell, tile));
+			}
+		}
+		break;
+	case ArenaMessage::Close:
+		connection.games.erase(found);
+		m_metrics.activeGames--;
+		break;
+	default: {
+		auto action = load<ArenaAction>(payload);
+		if (action.cell >= static_cast<uint32_t>(field.size())) {
+			reply(connection, header, ArenaStatus::InvalidCell, state);
+			return true;
+		}
+		act(game, type, action.cell);
+		state = arenaState(field.state());
+		break;
+	}
+	}
+
+	reply(connection, header, ArenaStatus::Ok, state);
+	return true;
+}
+
+void ArenaServer::act(Game &game, ArenaMessage type, uint32_t cell)
+{
+	auto &field = game.field;
+	auto before = field.state();
+	// The same as the Board, the first action of any kind places the mines around its cell.
+	if (!field.initialized()) {
+		field.generate(cell, game.seed);
+	}
+
+	bool changed = false;
+	switch (type) {
+	case ArenaMessage::Reveal:
+		changed = field.reveal(cell);
+		break;
+	case ArenaMessage::Flag:
+		changed = field.toggleFlag(cell);
+		break;
+	case ArenaMessage::Chord:
+		changed = field.chord(cell);
+		break;
+	default:
+		break;
+	}
+	if (!changed) {
+		return;
+	}
+
+	for (int changedCell : field.changes()) {
+		m_cells.push_back(arenaPackCell(changedCell, field.packedTile(changedCell)));
+	}
+
+	if (before != Minefield::State::Playing || field.state() == Minefield::State::Playing) {
+		return;
+	}
+	(field.state() == Minefield::State::Win ? m_metrics.wins : m_metrics.losses)++;
+	// The end of the game uncovers the mines and the wrong flags.
+	for (int other = 0; other < field.size(); other++) {
+		if (!field.isRevealed(other) && field.isMine(other) != field.isFlagged(other)) {
+			m_cells.push_back(arenaPackCell(other, field.packedTile(other)));
+		}
+	}
+}
+
+void ArenaServer::reply(Connection &connection, const ArenaHeader &request, ArenaStatus status, ArenaState state)
+{
+	ArenaHeader header {};
+	header.size = sizeof(ArenaHeader) + sizeof(ArenaDelta) + m_cells.size() * sizeof(uint32_t);
+	header.type = request.type | ARENA_REPLY;
+	header.status = static_cast<uint8_t>(status);
+	header.game = request.game;
+
+	ArenaDelta delta {};
+	delta.state = static_cast<uint8_t>(state);
+	delta.count = m_cells.size();
+
+	auto &output = connection.output;
+	append(output, header);
+	append(output, delta);
+	auto cells = reinterpret_cast<const char *>(m_cells.data());
+	output.insert(output.end(), cells, cells + m_cells.size() * sizeof(uint32_t));
+
+	m_metrics.errors += status != ArenaStatus::Ok;
+}
+
+void ArenaServer::measure(Clock::time_point started)
+{
+	auto nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - started).count();
+	int bucket = std::bit_width(static_cast<uint64_t>(std::max<int64_t>(nanoseconds, 0)));
+	m_metrics.latency[std::min(bucket, Metrics::LATENCY_BUCKETS - 1)]++;
+}
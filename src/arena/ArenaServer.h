@@ -0,0 +1,219 @@
+#pragma once
+
+#include "ArenaProtocol.h"
+#include "Minefield.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @class ArenaServer
+ * @brief Local server the bots play many games through at once, see @c ArenaProtocol.h.
+ *
+ * The bots connect to a Unix domain socket. A single thread serves all the connections by an epoll event loop on
+ * nonblocking sockets: a readable connection is read a chunk at a time, all the complete requests in its buffer are
+ * handled on their @c Minefield and their replies are sent back in one write. A connection that does not take its
+ * replies is not read until it does, so a slow bot does not make the server buffer without a limit.
+ *
+ * Every connection owns its games, numbered by the bot, so thousands of games are played by a few connections
+ * without any locking. The server counts the requests and measures how long they take, see @c Metrics.
+ */
+class ArenaServer
+{
+public:
+	/// Configuration of the server.
+	struct Options
+	{
+		/// Path of the socket, an existing socket file is replaced.
+		std::string socket = "minesweeper-arena.sock";
+		/// Largest number of the connections served at once, the further ones are closed right away.
+		int maxConnections = 1024;
+		/// Largest number of the games of one connection.
+		int maxGames = 4096;
+	};
+
+	/// Counters of the server since its start.
+	struct Metrics
+	{
+		/// Number of the latency buckets, the bucket i counts the requests handled in less than 2^i nanoseconds.
+		static constexpr int LATENCY_BUCKETS = 40;
+
+		uint64_t connections = 0;
+		uint64_t activeConnections = 0;
+		uint64_t rejectedConnections = 0;
+		uint64_t activeGames = 0;
+		/// Requests of every @c ArenaMessage, indexed by the type.
+		std::array<uint64_t, ARENA_MESSAGE_TYPES> requests = {};
+		/// Requests answered with another status than @c ArenaStatus::Ok.
+		uint64_t errors = 0;
+		uint64_t wins = 0;
+		uint64_t losses = 0;
+		uint64_t bytesReceived = 0;
+		uint64_t bytesSent = 0;
+		/// Time from taking the request up to its reply being ready to send, with the requests read before it.
+		std::array<uint64_t, LATENCY_BUCKETS> latency = {};
+
+		/// Total number of the requests.
+		uint64_t totalRequests() const;
+
+		/// Upper bound of the latency at the quantile in the range [0, 1] in microseconds.
+		double latencyQuantile(double quantile) const;
+	};
+
+	explicit ArenaServer(const Options &options);
+	~ArenaServer();
+
+	ArenaServer(const ArenaServer &) = delete;
+	ArenaServer &operator=(const ArenaServer &) = delete;
+
+	/**
+	 * @brief Create the socket and start listening.
+	 *
+	 * @return True if the socket is listening, otherwise the reason is left in errno.
+	 */
+	bool listen();
+
+	/**
+	 * @brief Serve the connections until the stop flag is set or an error occurs.
+	 *
+	 * The flag may be set by a signal handler, the loop checks it at least every @p period.
+	 *
+	 * @param stop Flag stopping the loop.
+	 * @param period Longest time between two calls of @p tick.
+	 * @param tick Called with the metrics about every @p period, e.g. to export them.
+	 * @return True if the loop was stopped by the flag.
+	 */
+	template <typename Tick>
+	bool run(const std::atomic<bool> &stop, std::chrono::milliseconds period, Tick &&tick)
+	{
+		auto next = std::chrono::steady_clock::now() + period;
+		while (!stop.load(std::memory_order_relaxed)) {
+			if (!poll(period)) {
+				return false;
+			}
+			if (auto now = std::chrono::steady_clock::now(); now >= next) {
+				tick(m_metrics);
+				next = now + period;
+			}
+		}
+		return true;
+	}
+
+	const Metrics &metrics() const { return m_metrics; }
+
+	/**
+	 * @brief Write the metrics to a tab separated file, one counter per line.
+	 *
+	 * The requests per second are computed from the previous call.
+	 *
+	 * @return True if the whole file was written.
+	 */
+	bool writeMetrics(const std::string &path);
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	struct Game
+	{
+		Minefield field;
+		/// Seed the mines are placed from by the first action.
+		uint64_t seed;
+	};
+
+	struct Connection
+	{
+		int fd;
+		/// Received bytes not forming a complete request yet.
+		std::vector<char> input;
+		/// Replies not sent yet, from @c written on.
+		std::vector<char> output;
+		size_t written = 0;
+		/// The epoll events the connection waits for.
+		uint32_t events = 0;
+		/// A malformed request was received, the connection is closed once the replies are sent.
+		bool closing = false;
+		/// The peer closed its side, the connection is closed once all its requests are answered.
+		bool finished = false;
+		std::unordered_map<uint32_t, Game> games;
+	};
+
+	/**
+	 * @brief Wait for the events of the sockets and handle them.
+	 *
+	 * @return False if the waiting failed.
+	 */
+	bool poll(std::chrono::milliseconds timeout);
+
+	void accept();
+
+	/**
+	 * @brief Read the available bytes and serve the connection.
+	 *
+	 * @return False if the connection is to be closed.
+	 */
+	bool receive(Connection &connection);
+
+	/**
+	 * @brief Handle the complete requests and send their replies, as much of them as the socket takes.
+	 *
+	 * @return False if the connection is to be closed.
+	 */
+	bool serve(Connection &connection);
+
+	/**
+	 * @brief Handle the complete requests of the input until the output is full.
+	 *
+	 * @return True if some requests were left for the output to drain.
+	 */
+	bool process(Connection &connection);
+
+	/**
+	 * @brief Send the pending replies until the socket takes no more.
+	 *
+	 * @return False if the sending failed.
+	 */
+	bool flush(Connection &connection);
+
+	/// Close the connection and forget its games, the connection is destroyed.
+	void close(Connection &connection);
+
+	/// Update the events the connection waits for by the state of its buffers.
+	void watch(Connection &connection);
+
+	/**
+	 * @brief Handle one request and append its reply to the output.
+	 *
+	 * @return False if the request is malformed.
+	 */
+	bool handle(Connection &connection, const ArenaHeader &header, const char *payload);
+
+	/// Perform the action on the game and collect the changed cells for the reply.
+	void act(Game &game, ArenaMessage type, uint32_t cell);
+
+	/// Append the reply with the collected cells to the output.
+	void reply(Connection &connection, const ArenaHeader &request, ArenaStatus status, ArenaState state);
+
+	/// Count the latency of the request handled since the time point.
+	void measure(Clock::time_point started);
+
+private:
+	Options m_options;
+	int m_listener;
+	int m_epoll;
+	std::unordered_map<int, std::unique_ptr<Connection>> m_connections;
+	Metrics m_metrics;
+	/// Cells of the reply being built, reused by all the requests.
+	std::vector<uint32_t> m_cells;
+	/// Seeds of the games started without one.
+	std::mt19937_64 m_random;
+	/// State of the last @c writeMetrics, for the rates.
+	uint64_t m_lastRequests;
+	Clock::time_point m_lastMetrics;
+};
@@ -1,12 +1,46 @@
 #include "Board.h"
 
+#include "Application.h"
 #include "IconPool.h"
 #include "imgui.h"
 
 #include <algorithm>
-#include <execution>
 #include <random>
 
+#define SAFE_HINT_COLOR (ImVec4)ImColor::HSV(0.55f, 0.6f, 0.8f)
+#define MINE_HINT_COLOR (ImVec4)ImColor::HSV(0.0f, 0.6f, 0.8f)
+#define GUESS_HINT_COLOR (ImVec4)ImColor::HSV(0.15f, 0.6f, 0.8f)
+#define GUESS_BUDGET std::chrono::milliseconds(100)
+#define NO_GUESS_TIMEOUT std::chrono::milliseconds(500)
+/// Cells of the actions kept for the undo, a few megabytes.
+#define HISTORY_CAPACITY (1 << 20)
+#define HEATMAP_COLOR(probability) (ImVec4)ImColor::HSV(0.3f * (1.0f - (probability)), 0.7f, 0.7f)
+/// Period of the game thread while a replay is played or the auto-solve makes progress.
+#define BUSY_TICK std::chrono::milliseconds(5)
+/// Period of the game thread without any command, the elapsed time of the snapshot is stored this often.
+#define IDLE_TICK std::chrono::milliseconds(100)
+/// Fewer rows are reset on the game thread, a row of tiles is reset quicker than it is handed over to a worker.
+#define PARALLEL_RESET_ROWS 256
+
+static_assert(static_cast<int>(PackedTile::Hidden) == static_cast<int>(Icon::Ocupant::WrongFlag) + 1,
+	"The packed tiles extend the ocupants of the tiles");
+
+namespace
+{
+
+std::vector<int> revealedCells(const Minefield &field)
+{
+	std::vector<int> revealed;
+	for (int cell = 0; cell < field.size(); cell++) {
+		if (field.isRevealed(cell)) {
+			revealed.push_back(cell);
+		}
+	}
+	return revealed;
+}
+
+}
+
 bool operator==(const Pose &lhs, const Pose &rhs)
 {
 	return rhs.x == lhs.x && rhs.y == lhs.y;
@@ -14,49 +48,95 @@ bool operator==(const Pose &lhs, const Pose &rhs)
 
 Board::Board(int width, int height, int numberOfMines)
 	: Layer("Board")
-	, m_initialized(false)
-	, m_minePositions(numberOfMines)
+	, m_field(width, height, numberOfMines)
+	, m_solver(m_field)
+	, m_guessSearch(nullptr)
 	, m_gameState(GameState::Playing)
 	, m_width(width)
 	, m_height(height)
 	, m_numberOfMines(numberOfMines)
-	, m_numberOfFlags(0)
 	, m_start(nullptr)
+	, m_end()
+	, m_game(0)
 	, m_difficulty(0)
+	, m_numberOfClicks(0)
+	, m_autoSolve(false)
+	, m_assisted(false)
+	, m_heatmap(false)
+	, m_heatmapStale(false)
+	, m_requirements{ .noGuess = false }
+	, m_recording()
+	, m_finishedRecording(nullptr)
+	, m_player(std::nullopt)
+	, m_replayTime()
+	, m_practice(false)
+	, m_history(HISTORY_CAPACITY)
+	, m_snapshot(nullptr)
+	, m_feed(nullptr)
+	, m_changedCells()
+	, m_epoch()
+	, m_application(nullptr)
+	, m_staleCells()
+	, m_staleViews{ true, true, true }
+	, m_view(nullptr)
+	, m_acknowledgedGame(0)
+	, m_hint(std::nullopt)
+	, m_guess(std::nullopt)
+	, m_hintEpoch(0)
+	, m_probabilities()
+	, m_probabilitiesEpoch(0)
 {
 	Icons::instance();
 	setupEmptyTiles();
+	publish();
+	m_view = &m_views.read();
+}
+
+void Board::onAttach()
+{
+	m_application = &app();
+	if (m_application->renderBackend() != Application::RenderBackend::Headless) {
+		Icons::instance().loadTextures();
+	}
+
+	// The layers attached later see the outcome of the commands posted before, e.g. the resumed game.
+	if (runCommands()) {
+		publish();
+	}
+	m_view = &m_views.read();
+	m_worker = std::jthread([this](std::stop_token stop) {
+		run(stop);
+	});
 }
 
-void SelectableColor(ImU32 color)
+void Board::onDetach()
 {
-	ImVec2 p_min = ImGui::GetItemRectMin();
-	ImVec2 p_max = ImGui::GetItemRectMax();
-	ImGui::GetWindowDrawList()->AddRectFilled(p_min, p_max, color);
+	m_worker = std::jthread();
 }
 
 void Board::render()
 {
-	if (m_gameState > GameState::Playing || !isGamePlayable()) {
-		std::for_each(std::execution::par_unseq, m_tiles.begin(), m_tiles.end(), [&](auto &row) {
-			for (auto &tile : row) {
-				if (tile.belongsTo(Icon::Ocupant::Flag)
-					&& m_minePositions.find(tile.position()) == m_minePositions.end())
-				{
-					tile.setOcupant(Icon::Ocupant::WrongFlag);
-				}
-				tile.click();
-			}
-		});
+	m_view = &m_views.read();
+	const auto &view = *m_view;
+
+	if (view.practice && ImGui::IsKeyChordPressed(ImGuiMod_Ctrl | ImGuiKey_Z)) {
+		undo();
+	}
+	else if (view.practice && ImGui::IsKeyChordPressed(ImGuiMod_Ctrl | ImGuiKey_Y)) {
+		redo();
 	}
 
 	if (not ImGui::Begin("Board", NULL, m_windowFlags)) {
 		throw std::runtime_error("Could not create board window");
 	}
 
+	// The tiles of a replay are shown as they are, only the clicks are disabled.
+	ImGui::PushStyleVar(ImGuiStyleVar_DisabledAlpha, 1.0f);
+	ImGui::BeginDisabled(view.state == GameState::Replaying);
+
 	auto size = ImGui::GetWindowSize();
-	int buttonWidth = size.x / (m_width + 1);
-	int buttonHeight = size.y / (m_height + 1);
+	int buttonWidth = size.x / (view.width + 1);
+	int buttonHeight = size.y / (view.height + 1);
 	int buttonSize = buttonWidth < buttonHeight ? buttonWidth : buttonHeight;
 
 	auto buttonFlags = ImGuiButtonFlags_MouseButtonLeft | ImGuiButtonFlags_MouseButtonRight;
@@ -65,70 +145,94 @@ void Board::render()
 	style.ItemSpacing = ImVec2(1, 1);
 	style.FrameRounding = 2.0f;
 
-	for (int y = 0; y < m_height; y++) {
-		for (int x = 0; x < m_width; x++) {
+	for (int y = 0; y < view.height; y++) {
+		for (int x = 0; x < view.width; x++) {
 			if (x > 0) {
 				ImGui::SameLine();
 			}
-			int id = y * m_tiles.front().size() + x;
+			int id = y * view.width + x;
 			ImGui::PushID(id);
 
-			ImGui::PushStyleColor(ImGuiCol_Button, (ImVec4)m_tiles[y][x].color());
-			if (m_tiles[y][x].clicked()) {
-				handleClickedTile(buttonSize, x, y, buttonFlags);
+			ImGui::PushStyleColor(ImGuiCol_Button, tileColor(view, x, y));
+			if (view.tiles[y][x].clicked()) {
+				handleClickedTile(view, buttonSize, x, y, buttonFlags);
 			}
 			else {
-				handleUnclickedTile(buttonSize, x, y, buttonFlags);
+				handleUnclickedTile(view, buttonSize, x, y, buttonFlags);
 			}
 			ImGui::PopStyleColor(1);
+
+			if (auto probability = this->probability(view, id); probability && ImGui::IsItemHovered()) {
+				ImGui::SetTooltip("Mine probability: %.1f%%", *probability * 100);
+			}
 			ImGui::PopID();
 		}
 	}
+
+	ImGui::EndDisabled();
+	ImGui::PopStyleVar();
 	ImGui::End();
 }
 
 Board &Board::setNumberOfMines(int size)
 {
-	m_numberOfMines = size;
-	m_numberOfFlags = 0;
-	m_gameState = GameState::Playing;
-	m_initialized = false;
-
-	for (auto &row : m_tiles) {
-		for (auto &tile : row) {
-			tile.click(false);
-		}
-	}
+	post([this, size] {
+		m_numberOfMines = size;
+		newGame();
+	});
 	return *this;
 }
 
-long Board::elapsedTime()
+Board::GameState Board::gameState() const
 {
-	if (m_start == nullptr) {
+	const auto &view = this->view();
+	bool over = view.state == GameState::Win || view.state == GameState::Lose;
+	return over && view.game == m_acknowledgedGame ? GameState::Waiting : view.state;
+}
+
+long Board::elapsedTime() const
+{
+	const auto &view = this->view();
+	if (!view.start.has_value()) {
 		return -1;
 	}
 
-	if (m_gameState == GameState::Playing) {
-		auto diff = std::chrono::steady_clock::now() - *m_start;
-		m_lastElapsedTime = std::chrono::duration_cast<std::chrono::seconds>(diff).count();
-	}
+	auto end = view.state == GameState::Playing ? std::chrono::steady_clock::now() : view.end;
+	return std::chrono::duration_cast<std::chrono::seconds>(end - *view.start).count();
+}
 
-	return m_lastElapsedTime;
+void Board::resetTimer()
+{
+	post([this] {
+		m_start = nullptr;
+	});
 }
 
 void Board::setDifficulty(int difficulty, bool reconfigure)
 {
-	m_difficulty = difficulty;
-	if (!reconfigure) {
-		return;
-	}
+	post([this, difficulty, reconfigure] {
+		m_difficulty = difficulty;
+		if (!reconfigure) {
+			return;
+		}
 
-	m_height = sizeFromDifficulty();
-	m_width = m_height;
+		m_height = sizeFromDifficulty();
+		m_width = m_height;
+		m_numberOfMines = (m_height*m_width) / 5;
 
-	setupEmptyTiles();
-	setNumberOfMines((m_height*m_width) / 5);
-	resetTimer();
+		setupEmptyTiles();
+		m_start = nullptr;
+	});
+}
+
+void Board::resize(int width, int height)
+{
+	post([this, width, height] {
+		m_width = width;
+		m_height = height;
+		setupEmptyTiles();
+		m_start = nullptr;
+	});
 }
 
 void Board::setupEmptyTiles()
@@ -142,231 +246,595 @@ void Board::setupEmptyTiles()
 		}
 		m_tiles[y] = row;
 	}
+
+	newGame();
 }
 
 void Board::on_refreshBoard_activated()
 {
-	m_gameState = GameState::Playing;
-	m_initialized = false;
-	m_numberOfClicks = 0;
-	m_numberOfFlags = 0;
-
-	resetTimer();
+	post([this] {
+		newGame();
+		m_start = nullptr;
+	});
+}
 
-	std::for_each(std::execution::par_unseq, m_tiles.begin(),  m_tiles.end(), [](auto &row) {
-		for (auto &tile : row) {
-			tile.click(false);
+void Board::ackGameOver()
+{
+	const auto &view = this->view();
+	m_acknowledgedGame = view.game;
+	post([this, game = view.game] {
+		if (m_game == game && (m_gameState == GameState::Win || m_gameState == GameState::Lose)) {
+			m_gameState = GameState::Waiting;
 		}
 	});
 }
 
-void Board::initTiles(int X, int Y)
+void Board::hint()
 {
-	m_minePositions = generateMinePositions(X, Y);
-	m_numberOfClicks = 0;
-
-	m_tiles.clear();
-	m_tiles.resize(m_height);
-
-	for (int y = 0; y < m_height; y++) {
-		std::vector<Tile> row;
-		row.reserve(m_width);
-
-		for (int x = 0; x < m_width; x++) {
-			auto ocupant = countSurroundingMines<Icon::Ocupant>(x, y);
-			row.emplace_back(Tile(ocupant, {x, y}));
+	post([this] {
+		if (m_gameState == GameState::Playing && m_field.initialized()) {
+			markAssisted();
+			findHint(m_epoch.token(), m_field, m_guessSearch);
 		}
+	});
+}
 
-		m_tiles[y] = row;
-	}
-
-	m_initialized = true;
+void Board::setAutoSolve(bool enabled)
+{
+	post([this, enabled] {
+		m_autoSolve = enabled;
+		if (enabled && m_gameState == GameState::Playing) {
+			markAssisted();
+		}
+	});
 }
 
-bool Board::isInRange(Pose pose, Pose generated, int range)
+void Board::setHeatmap(bool enabled)
 {
-	return (generated.x >= pose.x - range && generated.x <= pose.x + range) &&
-		(generated.y >= pose.y - range && generated.y <= pose.y + range);
+	post([this, enabled] {
+		m_heatmap = enabled;
+		m_heatmapStale = true;
+	});
 }
 
-std::unordered_set<Pose> Board::generateMinePositions(int x, int y)
+void Board::setNoGuess(bool enabled)
 {
-	std::unordered_set<Pose> minePositions;
-	std::random_device rd;
-	std::mt19937 gen(rd());
-	std::uniform_int_distribution hDis(0, m_height - 1);
-	std::uniform_int_distribution wDis(0, m_width - 1);
+	post([this, enabled] {
+		m_requirements.noGuess = enabled;
+	});
+}
 
-	while (minePositions.size() < m_numberOfMines) {
-		int X = wDis(gen);
-		int Y = hDis(gen);
+void Board::post(Command command)
+{
+	{
+		std::lock_guard lock(m_commandMutex);
+		m_commands.push_back(std::move(command));
+	}
+	m_commandPosted.notify_one();
+}
 
-		// Ensures that the mines will not be generated around the first click.
-		if (isInRange({x, y}, {X, Y}, 1)) {
-			continue;
-		}
+bool Board::runCommands()
+{
+	std::vector<Command> commands;
+	{
+		std::lock_guard lock(m_commandMutex);
+		commands.swap(m_commands);
+	}
 
-		minePositions.insert({X, Y});
+	for (auto &command : commands) {
+		command();
 	}
-	return minePositions;
+	return !commands.empty();
 }
 
-template <Countable T>
-T Board::countSurroundingMines(int x, int y)
+void Board::run(std::stop_token stop)
 {
-	int count = 0;
-	if (m_minePositions.find({x, y}) != m_minePositions.end()) {
-		return static_cast<T>(9);
-	}
+	bool solving = false;
+	while (!stop.stop_requested()) {
+		{
+			// The replay and the auto-solve go on without any command.
+			std::unique_lock lock(m_commandMutex);
+			m_commandPosted.wait_for(lock, stop, m_player || solving ? BUSY_TICK : IDLE_TICK, [this] {
+				return !m_commands.empty();
+			});
+		}
 
-	for (int i = -1; i < 2; i++) {
-		for (int j = -1; j < 2; j++) {
-			if (!tileExists(x,y)) {
-				continue;
-			}
-			if (m_minePositions.find({x + j, y + i}) != m_minePositions.end()) {
-				count++;
-			}
+		bool changed = runCommands();
+		if (m_player) {
+			changed |= advanceReplay();
+		}
+		// One round of the auto-solve per tick, so its progress is shown.
+		solving = m_autoSolve && (changed || solving) && runAutoSolve();
+		changed |= solving;
+
+		if (m_heatmap && m_heatmapStale) {
+			m_heatmapStale = false;
+			computeHeatmap(m_epoch.token(), m_field);
+		}
+
+		if (m_snapshot && m_snapshot->active() && m_start) {
+			auto elapsed = std::chrono::steady_clock::now() - *m_start;
+			m_snapshot->setElapsed(std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count());
+		}
+
+		if (changed) {
+			publish();
 		}
 	}
-	return static_cast<T>(count);
 }
 
-int Board::countSurroundingFlags(int x, int y)
+void Board::publish()
 {
-	int count = 0;
-	if (m_tiles[y][x].belongsTo(Icon::Ocupant::Flag)) {
-		return 9;
+	// Every view is patched with the cells changed since it was filled, the grid is copied only after it was rebuilt.
+	for (size_t index = 0; index < m_staleCells.size(); index++) {
+		auto &cells = m_staleCells[index];
+		if (m_staleViews[index]) {
+			continue;
+		}
+		// The view not read for long is copied whole once it is read again.
+		if (cells.size() + m_changedCells.size() > static_cast<size_t>(m_field.size())) {
+			m_staleViews[index] = true;
+			cells.clear();
+			continue;
+		}
+		cells.insert(cells.end(), m_changedCells.begin(), m_changedCells.end());
 	}
 
-	for (int i = -1; i < 2; i++) {
-		for (int j = -1; j < 2; j++) {
-			if (!tileExists(x + j, y + i)) {
-				continue;
-			}
-			if (m_tiles[y + i][x + j].belongsTo(Icon::Ocupant::Flag)) {
-				count++;
-			}
+	auto index = m_views.backIndex();
+	auto &view = m_views.back();
+	if (m_staleViews[index]) {
+		view.tiles = m_tiles;
+		m_staleViews[index] = false;
+	}
+	else {
+		for (int cell : m_staleCells[index]) {
+			int x = m_field.x(cell);
+			int y = m_field.y(cell);
+			view.tiles[y][x] = m_tiles[y][x];
 		}
 	}
-
-	return count;
+	m_staleCells[index].clear();
+	view.state = m_gameState;
+	view.epoch = m_epoch.value();
+	view.game = m_game;
+	view.width = m_width;
+	view.height = m_height;
+	view.numberOfMines = m_numberOfMines;
+	view.numberOfFlags = m_field.numberOfFlags();
+	view.bbbv = m_field.initialized() ? m_field.bbbv() : 0;
+	view.clicks = m_numberOfClicks;
+	view.start = m_start ? std::optional(*m_start) : std::nullopt;
+	view.end = m_end;
+	view.recording = m_finishedRecording;
+	view.autoSolve = m_autoSolve;
+	view.assisted = m_assisted;
+	view.heatmap = m_heatmap;
+	view.noGuess = m_requirements.noGuess;
+	view.bbbvBand = restrictsBbbv();
+	view.practice = m_practice;
+	view.canUndo = m_practice && m_history.canUndo();
+	view.canRedo = m_practice && m_history.canRedo();
+	view.replaying = m_player.has_value();
+	m_views.publish();
+
+	if (m_feed) {
+		m_feed->publish(m_game, m_field, m_changedCells);
+	}
+	m_changedCells.clear();
 }
 
-void Board::setButtonColor(int x, int y)
+void Board::newGame()
 {
-	if (isTilePlayable(x, y)) {
-		ImGui::PushStyleColor(ImGuiCol_ButtonHovered, (ImVec4)ImColor::HSV(0.3f, 0.7f, 0.7f));
-		ImGui::PushStyleColor(ImGuiCol_ButtonActive, (ImVec4)ImColor::HSV(7.0f, 0.8f, 0.8f));
+	m_game++;
+	m_field = Minefield(m_width, m_height, m_numberOfMines);
+	m_solver.reset();
+	m_guessSearch = std::make_shared<GuessSearch>(m_field);
+	m_gameState = GameState::Playing;
+	m_numberOfClicks = 0;
+	// The auto-solve left enabled plays the new game too.
+	m_assisted = m_autoSolve;
+	m_recording = Replay();
+	m_finishedRecording = std::make_shared<const Replay>();
+	m_player = std::nullopt;
+	m_history.clear();
+	if (m_snapshot) {
+		m_snapshot->clear();
+	}
+	invalidate();
+	m_staleViews.fill(true);
+	for (auto &cells : m_staleCells) {
+		cells.clear();
+	}
+
+	auto resetRow = [this](size_t y) {
+		for (auto &tile : m_tiles[y]) {
+			tile.setOcupant(Icon::Ocupant::Empty).click(false);
+		}
+	};
+	// The board is reset by its constructor before it is attached to the application.
+	if (m_application == nullptr) {
+		for (size_t y = 0; y < m_tiles.size(); y++) {
+			resetRow(y);
+		}
 	}
 	else {
-		ImGui::PushStyleColor(ImGuiCol_ButtonHovered, (ImVec4)m_tiles[y][x].color());
-		ImGui::PushStyleColor(ImGuiCol_ButtonActive, (ImVec4)m_tiles[y][x].color());
+		m_application->scheduler().parallelFor(m_tiles.size(), 1, resetRow, PARALLEL_RESET_ROWS);
 	}
 }
 
-bool Board::isTilePlayable(int x, int y)
+void Board::setBbbvBand(int minimum, int maximum)
 {
-	const auto &tile = m_tiles[y][x];
-	return !tile.clicked();
+	post([this, minimum, maximum] {
+		m_requirements.minimumBbbv = std::max(0, minimum);
+		m_requirements.maximumBbbv = std::max(m_requirements.minimumBbbv, maximum);
+	});
 }
 
-bool Board::tileExists(int x, int y)
+bool Board::restrictsBbbv() const
 {
-	return x >= 0 && x < m_width && y >= 0 && y < m_height;
+	return m_requirements.minimumBbbv > 0 || m_requirements.maximumBbbv < std::numeric_limits<int>::max();
 }
 
-bool Board::isGamePlayable()
+void Board::invalidate()
 {
-	if (m_numberOfFlags != m_numberOfMines) {
-		return true;
-	}
+	m_epoch.advance();
+	m_heatmapStale = true;
+}
 
-	for (size_t i = 0; i < m_width; i++) {
-		for (size_t j = 0; j < m_height; j++) {
-			if (isTilePlayable(j, i)) {
-				return true;
-			}
+Job Board::findHint(CancellationToken token, Minefield field, std::shared_ptr<GuessSearch> search)
+{
+	co_await m_application->background(token);
+
+	Solver solver(field);
+	solver.update(revealedCells(field));
+	auto hint = solver.hint();
+	std::optional<int> guess;
+	if (!hint.has_value()) {
+		std::lock_guard lock(search->mutex);
+		search->field = field;
+		if (int cell = search->optimizer.guess(GUESS_BUDGET, token); cell != -1) {
+			guess = cell;
 		}
 	}
-	return false;
+
+	co_await m_application->nextFrame(token);
+	m_hint = hint;
+	m_guess = guess;
+	m_hintEpoch = token.epoch();
 }
 
-void Board::clickAllEmptyTiles(int x, int y)
+Job Board::computeHeatmap(CancellationToken token, Minefield field)
 {
-	if (!tileExists(x, y)) {
-		return;
+	co_await m_application->background(token);
+
+	Solver solver(field);
+	solver.update(revealedCells(field));
+	// The probabilities build on everything the solver can deduce.
+	solver.deductions();
+	ProbabilityEngine probability(field, solver, &m_application->scheduler());
+	probability.compute(token);
+
+	co_await m_application->nextFrame(token);
+	m_probabilities = probability.probabilities();
+	m_probabilitiesEpoch = token.epoch();
+}
+
+void Board::initTiles(int x, int y)
+{
+	std::random_device rd;
+	uint64_t seed = (static_cast<uint64_t>(rd()) << 32) | rd();
+	int first = m_field.index(x, y);
+
+	if (m_requirements.noGuess || restrictsBbbv()) {
+		Generator generator(m_width, m_height, m_numberOfMines, &m_application->scheduler());
+		seed = generator.generate(first, seed, NO_GUESS_TIMEOUT, m_requirements).seed;
 	}
-	if (m_tiles[y][x].clicked()) {
-		return;
+	m_field.generate(first, seed);
+	m_numberOfClicks = 0;
+	m_recording = Replay(m_width, m_height, m_numberOfMines, seed);
+	if (m_snapshot && !m_practice) {
+		m_snapshot->start(m_field);
+		m_snapshot->setAssisted(m_assisted);
 	}
-	m_tiles[y][x].click();
-	if (countSurroundingMines<int>(x, y) != 0) {
+
+	for (int cell = 0; cell < m_field.size(); cell++) {
+		syncTile(cell);
+	}
+	invalidate();
+}
+
+void Board::actionPerformed()
+{
+	const auto &changes = m_field.changes();
+	if (changes.empty()) {
 		return;
 	}
-	for (int i = -1; i < 2; i++) {
-		for (int j = -1; j < 2; ++j) {
-			clickAllEmptyTiles(x + j, y + i);
+
+	for (int cell : changes) {
+		syncTile(cell);
+	}
+	m_solver.update(changes);
+	invalidate();
+	updateSnapshot();
+
+	if (m_field.state() != Minefield::State::Playing && m_gameState == GameState::Playing) {
+		// The practice game goes on, the last action can still be taken back.
+		if (!m_practice) {
+			m_gameState = m_field.state() == Minefield::State::Win ? GameState::Win : GameState::Lose;
+			m_end = std::chrono::steady_clock::now();
+			m_finishedRecording = std::make_shared<const Replay>(m_recording);
 		}
+		setAllTilesClicked();
 	}
 }
 
-void Board::clickPossibleTiles(int x, int y)
+void Board::syncTile(int cell)
 {
-	if (!tileExists(x, y)) {
+	m_changedCells.push_back(cell);
+	auto &tile = m_tiles[m_field.y(cell)][m_field.x(cell)];
+	if (m_field.isFlagged(cell)) {
+		tile.setOcupant(Icon::Ocupant::Flag).click();
+	}
+	else {
+		tile.setOcupant(static_cast<Icon::Ocupant>(m_field.adjacentMines(cell))).click(m_field.isRevealed(cell));
+	}
+}
+
+void Board::record(int cell, Replay::Action action)
+{
+	if (m_practice) {
+		m_history.push(m_field.lastDelta());
 		return;
 	}
-	if (m_tiles[y][x].clicked()) {
+	if (m_recording.width() == 0) {
+		// The resumed game has no recording, see resume.
 		return;
 	}
 
-	m_tiles[y][x].click();
+	auto time = m_start ? std::chrono::steady_clock::now() - *m_start : std::chrono::steady_clock::duration::zero();
+	m_recording.record(cell, action, std::chrono::duration_cast<std::chrono::milliseconds>(time).count());
+}
 
-	if (m_tiles[y][x].ocupant() == Icon::Ocupant::Mine) {
-		m_gameState = GameState::Lose;
+void Board::playReplay(const Replay &replay, double speed)
+{
+	post([this, replay, speed] {
+		m_width = replay.width();
+		m_height = replay.height();
+		m_numberOfMines = replay.numberOfMines();
+		setupEmptyTiles();
+		m_start = nullptr;
+
+		m_player.emplace(replay, speed);
+		m_replayTime = std::chrono::steady_clock::now();
+		m_gameState = GameState::Replaying;
+	});
+}
+
+void Board::setPractice(bool enabled)
+{
+	post([this, enabled] {
+		m_practice = enabled;
+		newGame();
+		m_start = nullptr;
+	});
+}
+
+void Board::undo()
+{
+	post([this] {
+		if (!m_practice || m_gameState != GameState::Playing) {
+			return;
+		}
+
+		bool over = m_field.state() != Minefield::State::Playing;
+		const auto *delta = m_history.undo(m_field);
+		if (delta == nullptr) {
+			return;
+		}
+
+		if (over) {
+			// All the tiles were revealed when the game ended.
+			for (int cell = 0; cell < m_field.size(); cell++) {
+				syncTile(cell);
+			}
+		}
+		if (!delta->flag) {
+			m_solver.retract(delta->cells);
+		}
+		actionPerformed();
+	});
+}
+
+void Board::redo()
+{
+	post([this] {
+		if (m_practice && m_gameState == GameState::Playing && m_history.redo(m_field) != nullptr) {
+			actionPerformed();
+		}
+	});
+}
+
+void Board::resume(const std::string &path)
+{
+	post([this, path] {
+		auto snapshot = std::make_unique<GameSnapshot>(path);
+		if (snapshot->active()) {
+			m_width = snapshot->width();
+			m_height = snapshot->height();
+			setupEmptyTiles();
+
+			m_field.restore(snapshot->cells(), snapshot->seed());
+			m_numberOfMines = m_field.numberOfMines();
+			m_numberOfClicks = snapshot->clicks();
+			m_assisted = snapshot->assisted();
+			m_start = std::make_shared<time>(std::chrono::steady_clock::now()
+				- std::chrono::milliseconds(snapshot->elapsed()));
+			// The actions before the exit are not known, the resumed game has no replay.
+			m_recording = Replay();
+
+			resetSolver();
+			for (int cell = 0; cell < m_field.size(); cell++) {
+				syncTile(cell);
+			}
+			invalidate();
+		}
+
+		m_snapshot = std::move(snapshot);
+	});
+}
+
+void Board::observe(const std::string &name)
+{
+	post([this, name] {
+		m_feed = std::make_unique<ObserverFeed>(name);
+		if (!m_feed->isOpen()) {
+			m_feed = nullptr;
+			return;
+		}
+		m_feed->publish(m_game, m_field, {});
+	});
+}
+
+void Board::updateSnapshot()
+{
+	if (!m_snapshot || !m_snapshot->active() || m_gameState != GameState::Playing) {
 		return;
 	}
 
-	if (countSurroundingFlags(x, y) != (int)m_tiles[y][x].ocupant()) {
+	if (m_field.state() != Minefield::State::Playing) {
+		m_snapshot->clear();
 		return;
 	}
-	for (int i = -1; i < 2; i++) {
-		for (int j = -1; j < 2; ++j) {
-			clickPossibleTiles(x + j, y + i);
+	m_snapshot->update(m_field, m_field.changes());
+	m_snapshot->setClicks(m_numberOfClicks);
+}
+
+void Board::markAssisted()
+{
+	m_assisted = true;
+	if (m_snapshot && m_snapshot->active()) {
+		m_snapshot->setAssisted(true);
+	}
+}
+
+void Board::resetSolver()
+{
+	m_solver.reset();
+	m_solver.update(revealedCells(m_field));
+}
+
+bool Board::advanceReplay()
+{
+	auto now = std::chrono::steady_clock::now();
+	m_player->advance(std::chrono::duration<double, std::milli>(now - m_replayTime).count());
+	m_replayTime = now;
+
+	bool changed = false;
+	while (const auto *event = m_player->next()) {
+		m_player->replay().apply(m_field, *event);
+		actionPerformed();
+		changed = true;
+	}
+
+	if (m_player->finished()) {
+		if (m_field.state() != Minefield::State::Playing) {
+			setAllTilesClicked();
 		}
+		m_player = std::nullopt;
+		m_gameState = GameState::Waiting;
+		changed = true;
 	}
+	return changed;
 }
 
 void Board::setAllTilesClicked()
 {
-	for(int y = 0; y < m_height; y++) {
-		for(int x = 0; x < m_height; x++) {
-			if (m_minePositions.find({x, y}) == m_minePositions.end()) {
-				if (m_tiles[y][x].belongsTo(Icon::Ocupant::Flag)) {
-					unmarkMine(x, y);
-				}
-			}
-			m_tiles[y][x].click();
+	for (int cell = 0; cell < m_field.size(); cell++) {
+		m_changedCells.push_back(cell);
+		auto &tile = m_tiles[m_field.y(cell)][m_field.x(cell)];
+		if (m_field.isFlagged(cell) && !m_field.isMine(cell)) {
+			tile.setOcupant(Icon::Ocupant::WrongFlag);
 		}
+		else if (!m_field.isFlagged(cell)) {
+			tile.setOcupant(static_cast<Icon::Ocupant>(m_field.adjacentMines(cell)));
+		}
+		tile.click();
 	}
 }
 
-void Board::markMine(int x, int y)
+bool Board::runAutoSolve()
 {
-	m_tiles[y][x].setOcupant(Icon::Ocupant::Flag).click();
+	if (m_gameState != GameState::Playing || !m_field.initialized()) {
+		return false;
+	}
+
+	bool changed = false;
+	for (auto [cell, mine] : m_solver.deductions()) {
+		if (m_field.state() != Minefield::State::Playing) {
+			break;
+		}
+
+		if (!mine && m_field.isFlagged(cell)) {
+			// The player flagged a safe cell.
+			m_field.toggleFlag(cell);
+			record(cell, Replay::Action::Flag);
+			actionPerformed();
+			changed = true;
+		}
+
+		if (mine ? m_field.toggleFlag(cell) : m_field.reveal(cell)) {
+			record(cell, mine ? Replay::Action::Flag : Replay::Action::Reveal);
+			m_numberOfClicks++;
+			actionPerformed();
+			changed = true;
+		}
+	}
+	return changed;
 }
 
-void Board::unmarkMine(int x, int y)
+void Board::setButtonColor(const View &view, int x, int y)
 {
-	for(auto &position : m_minePositions) {
-		if (position.x == x && position.y == y) {
-			m_tiles[y][x].setOcupant(Icon::Ocupant::Mine).click(false);
-			return;
+	if (isTilePlayable(view.tiles, x, y)) {
+		ImGui::PushStyleColor(ImGuiCol_ButtonHovered, (ImVec4)ImColor::HSV(0.3f, 0.7f, 0.7f));
+		ImGui::PushStyleColor(ImGuiCol_ButtonActive, (ImVec4)ImColor::HSV(7.0f, 0.8f, 0.8f));
+	}
+	else {
+		ImGui::PushStyleColor(ImGuiCol_ButtonHovered, (ImVec4)view.tiles[y][x].color());
+		ImGui::PushStyleColor(ImGuiCol_ButtonActive, (ImVec4)view.tiles[y][x].color());
+	}
+}
+
+ImVec4 Board::tileColor(const View &view, int x, int y) const
+{
+	int cell = y * view.width + x;
+	if (m_hintEpoch == view.epoch) {
+		if (m_hint.has_value() && m_hint->cell == cell) {
+			return m_hint->mine ? MINE_HINT_COLOR : SAFE_HINT_COLOR;
+		}
+		if (m_guess == cell) {
+			return GUESS_HINT_COLOR;
 		}
 	}
+	if (auto probability = this->probability(view, cell)) {
+		return HEATMAP_COLOR(*probability);
+	}
+	return (ImVec4)view.tiles[y][x].color();
+}
 
-	const auto cnt = countSurroundingMines<Icon::Ocupant>(x, y);
-	m_tiles[y][x].setOcupant(cnt).click(false);
+std::optional<double> Board::probability(const View &view, int cell) const
+{
+	if (!view.heatmap || view.state != GameState::Playing || m_probabilitiesEpoch != view.epoch
+		|| view.tiles[cell / view.width][cell % view.width].clicked())
+	{
+		return std::nullopt;
+	}
+	return m_probabilities[cell];
+}
+
+bool Board::isTilePlayable(const Tiles &tiles, int x, int y)
+{
+	const auto &tile = tiles[y][x];
+	return !tile.clicked();
 }
 
 int Board::sizeFromDifficulty()
@@ -382,78 +850,81 @@ int Board::sizeFromDifficulty()
 	return 10;
 }
 
+void Board::clickHidden(uint64_t game, int x, int y, bool rightButton)
+{
+	if (game != m_game || !isTilePlayable(m_tiles, x, y) || m_gameState != GameState::Playing) {
+		return;
+	}
+
+	if (!m_field.initialized()) {
+		initTiles(x, y);
+		m_start = std::make_shared<time>(std::chrono::steady_clock::now());
+	}
+
+	int cell = m_field.index(x, y);
+	if (rightButton) {
+		if (m_field.toggleFlag(cell)) {
+			record(cell, Replay::Action::Flag);
+		}
+	}
+	else if (m_field.reveal(cell)) {
+		record(cell, Replay::Action::Reveal);
+	}
+
+	m_numberOfClicks++;
+	actionPerformed();
+}
 
-bool Board::allMinesMarked()
+void Board::clickRevealed(uint64_t game, int x, int y, bool rightButton)
 {
-	for (auto &position : m_minePositions) {
-		if (!m_tiles[position.y][position.x].belongsTo(Icon::Ocupant::Flag)) {
-			return false;
+	if (game != m_game) {
+		return;
+	}
+
+	int cell = m_field.index(x, y);
+	if (rightButton) {
+		if (m_gameState == GameState::Playing && m_field.isFlagged(cell)) {
+			m_field.toggleFlag(cell);
+			record(cell, Replay::Action::Flag);
+			actionPerformed();
 		}
 	}
-	return true;
+	else if (m_field.chord(cell)) {
+		record(cell, Replay::Action::Chord);
+		m_numberOfClicks++;
+		actionPerformed();
+	}
 }
 
-void Board::handleUnclickedTile(int buttonSize, int x, int y, int buttonFlags)
+void Board::handleUnclickedTile(const View &view, int buttonSize, int x, int y, int buttonFlags)
 {
-	setButtonColor(x, y);
+	setButtonColor(view, x, y);
 	ImVec2 size(buttonSize, buttonSize);
 
 	if (ImGui::Button("", size, buttonFlags )) {
-		if (isTilePlayable(x, y)) {
-			if (!m_initialized) {
-				initTiles(x, y);
-				m_start = std::make_shared<time>(std::chrono::steady_clock::now());
-			}
-
-			if (ImGui::IsMouseReleased(ImGuiMouseButton_Right)) {
-				m_numberOfFlags++;
-				markMine(x, y);
-				if (allMinesMarked() && m_numberOfFlags == m_numberOfMines) {
-					m_gameState = GameState::Win;
-					setAllTilesClicked();
-				}
-			}
-			else if (m_tiles[y][x].ocupant() == Icon::Ocupant::Mine) {
-				m_gameState = GameState::Lose;
-				setAllTilesClicked();
-			}
-			else if (m_tiles[y][x].ocupant() == Icon::Ocupant::Empty) {
-				clickAllEmptyTiles(x, y);
-			}
-
-			m_tiles[y][x].click();
-			m_numberOfClicks++;
+		if (isTilePlayable(view.tiles, x, y) && view.state == GameState::Playing) {
+			bool rightButton = ImGui::IsMouseReleased(ImGuiMouseButton_Right);
+			post([this, game = view.game, x, y, rightButton] {
+				clickHidden(game, x, y, rightButton);
+			});
 		}
 	}
 	ImGui::PopStyleColor(2);
 
 }
 
-void Board::handleClickedTile(int buttonSize, int x, int y, int buttonFlags)
+void Board::handleClickedTile(const View &view, int buttonSize, int x, int y, int buttonFlags)
 {
-	setButtonColor(x, y);
+	setButtonColor(view, x, y);
 	ImVec2 size(buttonSize - 8, buttonSize - 6);
 
-	const std::string localID = std::to_string(y * m_tiles.front().size() + x);
-	if (ImGui::ImageButton(localID.c_str(), (intptr_t)m_tiles[y][x].icon()->texture(), size, buttonFlags)) {
-		if (ImGui::IsMouseReleased(ImGuiMouseButton_Right) && gameState() == GameState::Playing) {
-			if (m_tiles[y][x].belongsTo(Icon::Ocupant::Flag)) {
-				m_numberOfFlags--;
-				unmarkMine(x, y);
-
-				if (allMinesMarked() && m_numberOfFlags == m_numberOfMines) {
-					m_gameState = GameState::Win;
-					setAllTilesClicked();
-				}
-			}
-		}
-		else if (ImGui::IsMouseReleased(ImGuiMouseButton_Left)) {
-			auto ocup = m_tiles[y][x].ocupant();
-			if (ocup != Icon::Ocupant::Flag && countSurroundingFlags(x, y) == (int)ocup) {
-				m_tiles[y][x].click(false);
-				m_numberOfClicks++;
-				clickPossibleTiles(x, y);
-			}
+	const std::string localID = std::to_string(y * view.width + x);
+	if (ImGui::ImageButton(localID.c_str(), (intptr_t)view.tiles[y][x].icon()->texture(), size, buttonFlags)) {
+		bool rightButton = ImGui::IsMouseReleased(ImGuiMouseButton_Right);
+		if (rightButton || ImGui::IsMouseReleased(ImGuiMouseButton_Left)) {
+			post([this, game = view.game, x, y, rightButton] {
+				clickRevealed(game, x, y, rightButton);
+			});
 		}
 	}
 
@@ -1,24 +1,57 @@
 #pragma once
 
+#include "GameSnapshot.h"
+#include "Generator.h"
+#include "GuessOptimizer.h"
+#include "History.h"
+#include "Job.h"
 #include "Layer.h"
+#include "Minefield.h"
+#include "ObserverFeed.h"
+#include "ProbabilityEngine.h"
+#include "Replay.h"
+#include "Solver.h"
 #include "Tile.h"
+#include "TripleBuffer.h"
 
+#include <array>
 #include <chrono>
-#include <unordered_set>
+#include <condition_variable>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
 #include <vector>
 
-template<typename T>
-concept Countable = std::same_as<T, int> || std::same_as<T, Icon::Ocupant>;
-
 /**
  * @class Board
  * @brief The Board class is a Layer that represents the game board.
  *
- * This class encapsulates all the tiles and keeps their ownership. At the same time it keeps the overall state
- * of the game. It is responsible for rendering the board and handling the user input.
+ * This class encapsulates all the tiles and keeps their ownership. The rules of the game are implemented by the
+ * @c Minefield, the board renders it and translates the user input to its actions. After every action only the
+ * tiles of the changed cells are updated.
+ *
+ * The game runs on its own thread. The input of the player and the calls of the other layers are posted to it as
+ * commands, and after every change it publishes an immutable view of the game through a @c TripleBuffer. The render
+ * and the getters only read the latest view, so a flood reveal, the solver or the heatmap on a big board never stall
+ * the frame. The effect of a command shows up in a later frame.
+ *
+ * The hint and the heatmap are computed by the background jobs on a copy of the minefield. Every change of the board
+ * advances its @c Epoch, which cancels the jobs started for the previous state.
  *
  * @see Layer Base class for all the layers.
  * @see Tile Class representing the state of the separate tiles.
+ * @see Minefield The rules of the game.
+ * @see Solver Deduction of the safe cells used by the hint and the auto-solve.
+ * @see ProbabilityEngine Mine probabilities shown by the heatmap.
+ * @see GuessOptimizer The guess suggested by the hint.
+ * @see Replay Recording of the actions of the current game.
+ * @see History Undo and redo of the actions in the practice mode.
+ * @see GameSnapshot The game in progress kept on the disk.
+ * @see ObserverFeed The board published to the external readers.
+ * @see TripleBuffer Hand over of the views to the render.
  */
 class Board
 	: public Layer
@@ -31,6 +64,8 @@ public:
 		Win,
 		Lose,
 		Waiting,
+		/// A replay is played back, the input is ignored.
+		Replaying,
 	};
 
 	/**
@@ -60,6 +95,10 @@ public:
 
 	/// \addgroup Layer
 	/// @{
+	/// Run the commands posted so far, e.g. @c resume, and start the game thread.
+	void onAttach() override;
+	/// Stop the game thread, the commands posted later wait for the next attach.
+	void onDetach() override;
 	void render() override;
 	/// @}
 
@@ -72,22 +111,25 @@ public:
 	Board &setNumberOfMines(int size);
 
 	/// Get the total number of mines on the board.
-	int totalNumberOfMines() const { return m_numberOfMines; }
+	int totalNumberOfMines() const { return view().numberOfMines; }
 
 	/// Get the number of flags placed on the board.
-	int numberOfFlags() const { return m_numberOfFlags; }
+	int numberOfFlags() const { return view().numberOfFlags; }
 
 	/// Get the number of mines left to be marked.
-	GameState gameState() const { return m_gameState; }
+	GameState gameState() const;
 
 	/// Get the number of elapsed time since the game started.
-	long elapsedTime();
+	long elapsedTime() const;
 
 	/// Reset the timer to the initial state.
-	void resetTimer() { m_start = nullptr; }
+	void resetTimer();
 
 	/// Get the number of clicks made by the user.
-	const long &numberOfClicks() const { return m_numberOfClicks; }
+	long numberOfClicks() const { return view().clicks; }
+
+	/// The 3BV of the current game, zero before the first click.
+	int bbbv() const { return view().bbbv; }
 
 	/**
 	 * @brief Set the difficulty of the game.
@@ -98,176 +140,399 @@ public:
 	void setDifficulty(int difficulty, bool reconfigure = true);
 
 	/// Get the total number of tiles on the board.
-	int totalNumberOfTiles() const { return m_width * m_height; }
+	int totalNumberOfTiles() const { return view().width * view().height; }
 
 	/// Get the width of the board.
-	int &width() { return m_width; }
+	int width() const { return view().width; }
 
 	// Get the height of the board.
-	int &height() { return m_height; }
+	int height() const { return view().height; }
 
 	/**
 	 * @brief Clear the board and resize it to the new dimensions.
 	 *
-	 * If the board is already initialized, the tiles inside are destoryed and reinitialized.
+	 * The tiles are destoryed and reinitialized and the timer is reset.
+	 *
+	 * @param width The number of tiles in the horizontal direction.
+	 * @param height The number of tiles in the vertical direction.
 	 */
-	void setupEmptyTiles();
+	void resize(int width, int height);
 
 	/**
 	 * @brief Acknowledge the game over state.
 	 *
 	 * The statistics are saved in a priority queue with dynamic sorting.
 	 * This acknowledge ensures that after the game over invocation the result will not be written multiple times to the
-	 * score structure.
+	 * score structure. The acknowledged game is reported as waiting right away, before the game thread learns about it.
 	 */
-	void ackGameOver() { m_gameState = GameState::Waiting; }
+	void ackGameOver();
 
 	/**
 	 * @brief Callback method called when the user wants to refresh the board.
 	 *
-	 * The difference with @c setupEmptyTiles is that this method resets the timer
+	 * The difference with @c resize is that this method resets the timer
 	 * but the board dimensions and the number of mines are preserved.
 	 */
 	void on_refreshBoard_activated();
 
-private:
+	/**
+	 * @brief Highlight the next cell that can be played without guessing.
+	 *
+	 * If the player has to guess, the best guess of the @c GuessOptimizer is highlighted instead. The highlight
+	 * disappears after the next action on the board. The search runs in a background job, the highlight is shown once
+	 * it finishes. The game is marked as assisted.
+	 */
+	void hint();
 
 	/**
-	 * @brief Initialize the tiles on the board.
+	 * @brief Enable or disable the auto-solve.
 	 *
-	 * Before this method is called all the tiles are empty. This method generates the mines.
-	 * The mines are not generated on the button clicked or in its vicinity. This ensures that
-	 * the first click always openes a field of empty tiles.
+	 * When enabled, after every change all the deduced safe cells are revealed and the deduced mines are flagged. The
+	 * auto-solve stops making progress when a guess is needed and continues after the player makes it. Enabling it
+	 * marks the current game and the following ones as assisted.
+	 */
+	void setAutoSolve(bool enabled);
+
+	/// True if the auto-solve is enabled.
+	bool autoSolve() const { return view().autoSolve; }
+
+	/// True if a hint or the auto-solve was used in the current game, such a game is not scored.
+	bool assisted() const { return view().assisted; }
+
+	/**
+	 * @brief Show or hide the heatmap of the mine probabilities over the hidden tiles.
 	 *
-	 * @param x X coordinate of the clicked button.
-	 * @param y Y coordinate of the clicked button.
+	 * The probabilities are recomputed in a background job after every change while the heatmap is shown.
 	 */
-	void initTiles(int x, int y);
+	void setHeatmap(bool enabled);
+
+	/// True if the heatmap is shown.
+	bool heatmap() const { return view().heatmap; }
 
 	/**
-	 * @brief Checkes if the @c generated position is in the range of the given position.
+	 * @brief Generate only the boards that can be solved without guessing.
 	 *
-	 * @param pose Ground truth position which is used as a reference.
-	 * @param generated Position to be checked.
-	 * @param range Number of tiles in the vicinity of the reference position to be checked.
-	 * @return True if the generated position is in the range of the reference position, false otherwise.
+	 * Takes effect on the next first click. If no such board is found in time, a random one is used.
 	 */
-	bool isInRange(Pose pose, Pose generated, int range);
+	void setNoGuess(bool enabled);
+
+	/// True if only the boards solvable without guessing are generated.
+	bool noGuess() const { return view().noGuess; }
 
 	/**
-	 * @brief Generates the positions of the mines on the board.
+	 * @brief Generate only the boards with the 3BV in the inclusive band.
 	 *
-	 * The number of generated mines is limited by @c m_numberOfMines. The mines are placed randomly on the board.
-	 * The position of the mines is only restrected by the position of the first clicked button.
+	 * Takes effect on the next first click. If no such board is found in time, a random one is used.
 	 *
-	 * @param x X coordinate of the clicked button.
-	 * @param y Y coordinate of the clicked button.
+	 * @param minimum The lowest accepted 3BV.
+	 * @param maximum The highest accepted 3BV.
+	 */
+	void setBbbvBand(int minimum, int maximum);
+
+	/// Accept the boards of any 3BV.
+	void clearBbbvBand() { setBbbvBand(0, std::numeric_limits<int>::max()); }
+
+	/// True if the 3BV of the generated boards is restricted.
+	bool hasBbbvBand() const { return view().bbbvBand; }
+
+	/// Actions of the finished game since its first click, empty before the game is over.
+	const Replay &recording() const { return *view().recording; }
+
+	/**
+	 * @brief Play the replay back on the board.
 	 *
-	 * @see initTiles Method that initializes the tiles on the board.
+	 * The board takes the dimensions of the replay. The input is ignored until the playback finishes, the finished
+	 * game is not counted as a win or a loss.
 	 *
-	 * @return Set of the positions of the mines.
+	 * @param replay The replay to be played.
+	 * @param speed Multiple of the original pace, zero plays the whole game at once.
 	 */
-	std::unordered_set<Pose> generateMinePositions(int x, int y);
+	void playReplay(const Replay &replay, double speed);
+
+	/// True while a replay is played back.
+	bool replaying() const { return view().replaying; }
 
 	/**
-	 * @brief Count how many mines are in the vicinity of the given position.
+	 * @brief Enable or disable the practice mode and start a new game.
 	 *
-	 * The maximum number is 8 tiles. The method counts the number of mines in the vicinity of the given position.
-	 *
-	 * @param x X coordinate of the position.
-	 * @param y Y coordinate of the position.
+	 * The actions of a practice game can be taken back, including a hit mine, so the game is not over until a new
+	 * one is started. Practice games are neither scored nor recorded.
+	 */
+	void setPractice(bool enabled);
+
+	/// True in the practice mode.
+	bool practice() const { return view().practice; }
+
+	/// Take back the last action of the practice game, if there is one.
+	void undo();
+
+	/// Perform the last action taken back again, if there is one.
+	void redo();
+
+	/**
+	 * @brief Keep the games in the snapshot file and resume the game stored in it.
 	 *
-	 * @template T The type of the return value. Can be @c Icon::Ocupant or @c int.
+	 * From now on every game is written to the file as it is played, so it survives the exit and a crash of the
+	 * application. Practice games are not stored. While another instance keeps its games in the same file, the
+	 * snapshot is disabled.
 	 *
-	 * @return Number of mines in the vicinity of the given position.
+	 * @param path Path to the snapshot file, created if it does not exist.
 	 */
-	template <Countable T>
-	T countSurroundingMines(int x, int y);
+	void resume(const std::string &path);
 
 	/**
-	 * @brief Just like @c countSurroundingMines but counts the number of flags.
+	 * @brief Publish the board into the shared memory segment for the external readers, see @c ObserverReader.
+	 *
+	 * The game thread publishes the changed cells together with the view, the readers do not slow the game down.
+	 *
+	 * @param name Name of the POSIX shared memory segment.
 	 */
-	int countSurroundingFlags(int x, int y);
+	void observe(const std::string &name);
+
+	bool canUndo() const { return view().canUndo; }
+	bool canRedo() const { return view().canRedo; }
+
+private:
+	/// Immutable state of the game published by the game thread for the render.
+	struct View
+	{
+		Tiles tiles;
+		GameState state = GameState::Playing;
+		/// Value of the epoch of the board, the results of the jobs are shown only for the same value.
+		uint64_t epoch = 0;
+		/// Number of the game, increased by every new game.
+		uint64_t game = 0;
+		int width = 0;
+		int height = 0;
+		int numberOfMines = 0;
+		int numberOfFlags = 0;
+		int bbbv = 0;
+		long clicks = 0;
+		/// Start of the game, nothing before the first click.
+		std::optional<time> start;
+		/// Time of the action finishing the game.
+		time end = {};
+		/// Recording of the finished game, shared by all the views of the game.
+		std::shared_ptr<const Replay> recording;
+		bool autoSolve = false;
+		/// The solver helped in the game, see @c assisted.
+		bool assisted = false;
+		bool heatmap = false;
+		bool noGuess = false;
+		bool bbbvBand = false;
+		bool practice = false;
+		bool canUndo = false;
+		bool canRedo = false;
+		bool replaying = false;
+	};
+
+	/// The command is run on the game thread.
+	using Command = std::function<void()>;
+
+	/// Guess search of the hints of one game, the states evaluated for a hint are reused by the later ones.
+	struct GuessSearch
+	{
+		explicit GuessSearch(const Minefield &field)
+			: field(field)
+			, optimizer(this->field)
+		{
+		}
+
+		/// Taken by the hint job for the whole search, the jobs of two hints do not search at once.
+		std::mutex mutex;
+		/// The state the optimizer searches, replaced by the state of every hint.
+		Minefield field;
+		GuessOptimizer optimizer;
+	};
+
+	/// The latest view read by the render.
+	const View &view() const { return *m_view; }
+
+	/// Queue the command for the game thread.
+	void post(Command command);
+
+	/// Run the queued commands, returns true if there were any.
+	bool runCommands();
+
+	/// Loop of the game thread, runs the commands and publishes the view after every change.
+	void run(std::stop_token stop);
+
+	/// Copy the state of the game and the tiles changed since the back view was filled to it and publish it.
+	void publish();
 
 	/**
-	 * @brief Sets the color of the button on the given position when hovered and when clicked.
+	 * @brief Clear the board and resize it to the current dimensions.
+	 *
+	 * If the board is already initialized, the tiles inside are destoryed and reinitialized.
 	 */
-	void setButtonColor(int x, int y);
+	void setupEmptyTiles();
 
 	/**
-	 * Check if the tile on the given position is playable.
+	 * @brief Perform the click of the player on the hidden tile.
+	 *
+	 * @param game Number of the game of the view the click was made on, the clicks on an older game are ignored.
+	 * @param x X coordinate of the clicked button.
+	 * @param y Y coordinate of the clicked button.
+	 * @param rightButton True if the tile is flagged, false if it is revealed.
 	 */
-	bool isTilePlayable(int x, int y);
+	void clickHidden(uint64_t game, int x, int y, bool rightButton);
+
+	/// Perform the click of the player on the revealed tile, the same as @c clickHidden.
+	void clickRevealed(uint64_t game, int x, int y, bool rightButton);
+
+	/// True if the 3BV of the generated boards is restricted.
+	bool restrictsBbbv() const;
+
+	/// Cancel the jobs of the previous state of the board, called after every change.
+	void invalidate();
 
 	/**
-	 * Check if the tile on the given position is in bounds of the board.
+	 * @brief Find the next safe cell, or the best guess, in a background job.
+	 *
+	 * @param token Cancelled by the next change of the board.
+	 * @param field Copy of the minefield to be searched.
+	 * @param search The guess search of the game.
 	 */
-	bool tileExists(int x, int y);
+	Job findHint(CancellationToken token, Minefield field, std::shared_ptr<GuessSearch> search);
+
+	/// Compute the probabilities of the heatmap in a background job, the same as @c findHint.
+	Job computeHeatmap(CancellationToken token, Minefield field);
+
+	/// Start a new game with the current dimensions and the number of mines.
+	void newGame();
 
 	/**
-	 * @brief Check if at least on tile is playable on the board.
+	 * @brief Place the mines on the first click.
 	 *
-	 * @see isTilePlayable Method that checks if the tile is playable.
+	 * The mines are not generated on the clicked button or in its vicinity. This ensures that
+	 * the first click always openes a field of empty tiles. In the no-guess mode or with a 3BV band the layout is
+	 * searched by the @c Generator.
 	 *
-	 * @return True if at least one tile is playable, false otherwise.
+	 * @param x X coordinate of the clicked button.
+	 * @param y Y coordinate of the clicked button.
 	 */
-	bool isGamePlayable();
+	void initTiles(int x, int y);
 
 	/**
-	 * @brief Recursive function to open the fields that do not have any mines in the vicinity.
+	 * @brief Update the tiles and the solver after an action of the minefield.
 	 *
-	 * @param x X coordinate of the start position.
-	 * @param y Y coordinate of the start position.
+	 * If the action finished the game, all the tiles are revealed.
 	 */
-	void clickAllEmptyTiles(int x, int y);
+	void actionPerformed();
+
+	/// Update the tile of the cell to match the minefield.
+	void syncTile(int cell);
+
+	/// Append the action of the player to the recording of the game, or to the history in the practice mode.
+	void record(int cell, Replay::Action action);
+
+	/// Store the cells changed by the last action and the clicks in the snapshot, forget it when the game is over.
+	void updateSnapshot();
+
+	/// Mark the current game as helped by the solver, also in its snapshot.
+	void markAssisted();
+
+	/// Deduce everything again from the revealed cells of a restored game.
+	void resetSolver();
 
 	/**
-	 * @brief Recursive function to open the fields that do not have any mines in the vicinity.
-	 *
-	 * If the starting position does have a mine on it, the @c m_gameOver is set to @c GameOverState::Lose.
+	 * @brief Perform the actions of the replay up to its current position.
 	 *
-	 * @param x X coordinate of the start position.
-	 * @param y Y coordinate of the start position.
+	 * @return True if the board was changed.
 	 */
-	void clickPossibleTiles(int x, int y);
+	bool advanceReplay();
+
+	/// Reveal all the tiles when the game is over, the wrong flags are marked.
+	void setAllTilesClicked();
 
 	/**
-	 * @brief Click all the tiles on the board.
+	 * @brief Reveal the deduced safe cells and flag the deduced mines.
 	 *
-	 * The method is used when the game is over. It opens all the tiles and marks the mines.
+	 * @return True if any cell was changed.
 	 */
-	void setAllTilesClicked();
+	bool runAutoSolve();
+
+	/**
+	 * @brief Sets the color of the button on the given position when hovered and when clicked.
+	 */
+	void setButtonColor(const View &view, int x, int y);
 
-	/// Right click on the tile.
-	void markMine(int x, int y);
+	/// Color of the tile, the hinted tile is highlighted and the hidden tiles are colored by the heatmap.
+	ImVec4 tileColor(const View &view, int x, int y) const;
 
-	/// Right click on the tile.
-	void unmarkMine(int x, int y);
+	/// Mine probability of the cell of the heatmap, nothing if there is none for the view.
+	std::optional<double> probability(const View &view, int cell) const;
+
+	/**
+	 * Check if the tile on the given position is playable.
+	 */
+	static bool isTilePlayable(const Tiles &tiles, int x, int y);
 
 	/// Get the size of the board based on the difficulty.
 	int sizeFromDifficulty();
 
-	/// Check if all the mines are marked correctly on the board.
-	bool allMinesMarked();
-
 	/// Used in rendering the unclicked tiles.
-	void handleUnclickedTile(int buttonSize, int x, int y, int buttonFlags);
+	void handleUnclickedTile(const View &view, int buttonSize, int x, int y, int buttonFlags);
 
 	/// Used in rendering the clicked tiles.
-	void handleClickedTile(int buttonSize, int x, int y, int buttonFlags);
+	void handleClickedTile(const View &view, int buttonSize, int x, int y, int buttonFlags);
 
 private:
-	bool m_initialized;
-	std::unordered_set<Pose> m_minePositions;
+	Minefield m_field;
+	Solver m_solver;
+	/// Created by every new game, shared with its hint jobs.
+	std::shared_ptr<GuessSearch> m_guessSearch;
 	Tiles m_tiles;
 	GameState m_gameState;
 	int m_width;
 	int m_height;
 	int m_numberOfMines;
-	int m_numberOfFlags;
 	std::shared_ptr<time> m_start;
+	time m_end;
+	uint64_t m_game;
 	int m_difficulty;
-	long m_lastElapsedTime;
 	long m_numberOfClicks;
+	bool m_autoSolve;
+	/// A hint or the auto-solve was used in the current game.
+	bool m_assisted;
+	bool m_heatmap;
+	/// The heatmap has to be computed for the current epoch.
+	bool m_heatmapStale;
+	Generator::Requirements m_requirements;
+	Replay m_recording;
+	std::shared_ptr<const Replay> m_finishedRecording;
+	std::optional<ReplayPlayer> m_player;
+	/// Time the replay was advanced to.
+	time m_replayTime;
+	bool m_practice;
+	History m_history;
+	std::unique_ptr<GameSnapshot> m_snapshot;
+	std::unique_ptr<ObserverFeed> m_feed;
+	/// Cells changed since the last publish, for the feed.
+	std::vector<int> m_changedCells;
+	Epoch m_epoch;
+	/// Set by onAttach, the game thread can not reach the application through the weak reference of the layer.
+	Application *m_application;
+
+	/// Commands posted by the render, guarded by the mutex.
+	std::vector<Command> m_commands;
+	std::mutex m_commandMutex;
+	std::condition_variable_any m_commandPosted;
+	TripleBuffer<View> m_views;
+	/// Cells changed since every view was filled, indexed by @c TripleBuffer::backIndex.
+	std::array<std::vector<int>, 3> m_staleCells;
+	/// The view is filled from the whole grid, the tiles were rebuilt or too many changed since it was filled.
+	std::array<bool, 3> m_staleViews;
+	/// Read by the render thread only.
+	const View *m_view;
+	/// The game over of the game was acknowledged by the render, see ackGameOver.
+	uint64_t m_acknowledgedGame;
+	/// Results of the jobs, owned by the render thread with the epoch they were computed for.
+	std::optional<Solver::Deduction> m_hint;
+	std::optional<int> m_guess;
+	uint64_t m_hintEpoch;
+	std::vector<double> m_probabilities;
+	uint64_t m_probabilitiesEpoch;
+	/// Declared last, so the thread is stopped before the state it works on is destroyed.
+	std::jthread m_worker;
 };
-
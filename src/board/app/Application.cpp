@@ -28,6 +28,16 @@ static void glfw_error_callback(int error, const char* description)
 	fprintf(stderr, "GLFW Error %d: %s\n", error, description);
 }
 
+static void resumeJob(std::coroutine_handle<> job, const CancellationToken &token)
+{
+	if (token.cancelled()) {
+		job.destroy();
+	}
+	else {
+		job.resume();
+	}
+}
+
 
 std::shared_ptr<Application> Application::create(const Application::Config &config,
 												 Application::RenderBackend renderBackend)
@@ -37,9 +47,47 @@ std::shared_ptr<Application> Application::create(const Application::Config &conf
 
 Application::~Application()
 {
+	for (auto &layer : m_layers) {
+		layer.second->onDetach();
+	}
+
+	// The running jobs may still queue themselves for a frame that never comes.
+	m_scheduler.wait();
+	for (auto &pending : m_frameJobs) {
+		pending.job.destroy();
+	}
+	m_frameJobs.clear();
+
 	Cleanup();
 }
 
+Application::JobTransfer::JobTransfer(Application &application, const CancellationToken &token, bool nextFrame)
+	: m_application(application)
+	, m_token(token)
+	, m_nextFrame(nextFrame)
+{
+}
+
+void Application::JobTransfer::await_suspend(std::coroutine_handle<> job)
+{
+	// The awaiter lives in the frame of the job, it must not be touched once the job is destroyed or resumed.
+	auto &application = m_application;
+	auto token = m_token;
+	if (token.cancelled()) {
+		job.destroy();
+		return;
+	}
+
+	if (m_nextFrame) {
+		std::lock_guard lock(application.m_frameJobMutex);
+		application.m_frameJobs.push_back({ job, std::move(token) });
+		return;
+	}
+	application.m_scheduler.submit([job, token] {
+		resumeJob(job, token);
+	});
+}
+
 Application &Application::addLayer(const std::shared_ptr<Layer> &layer)
 {
 	assert(m_layers.find(layer->name()) == m_layers.end());
@@ -92,19 +140,8 @@ int Application::run()
 		ImGui_ImplGlfw_NewFrame();
 		ImGui::NewFrame();
 
-		if (m_config.enableDocking) {
-			ImGuiDockNodeFlags dockspace_flags = ImGuiDockNodeFlags_None;
-			dockspace_flags |= ImGuiDockNodeFlags_AutoHideTabBar
-							| ImGuiDockNodeFlags_NoResize
-							| ImGuiDockNodeFlags_NoUndocking;
-
-			dockspace_flags ^= ImGuiDockNodeFlags_PassthruCentralNode;
-			ImGui::DockSpaceOverViewport(0, ImGui::GetMainViewport(), dockspace_flags);
-		}
-
-		for(auto &layer : m_layers) {
-			layer.second->render();
-		}
+		resumeJobs();
+		renderLayers();
 
 		// Rendering
 		ImGui::Render();
@@ -132,11 +169,57 @@ int Application::run()
 	return 0;
 }
 
+void Application::frame(float deltaTime)
+{
+	ImGui::GetIO().DeltaTime = deltaTime;
+	ImGui::NewFrame();
+	resumeJobs();
+	renderLayers();
+	ImGui::Render();
+}
+
+void Application::resumeJobs()
+{
+	std::vector<PendingJob> jobs;
+	{
+		std::lock_guard lock(m_frameJobMutex);
+		jobs.swap(m_frameJobs);
+	}
+
+	for (auto &pending : jobs) {
+		resumeJob(pending.job, pending.token);
+	}
+}
+
+void Application::renderLayers()
+{
+	if (m_config.enableDocking) {
+		ImGuiDockNodeFlags dockspace_flags = ImGuiDockNodeFlags_None;
+		dockspace_flags |= ImGuiDockNodeFlags_AutoHideTabBar
+						| ImGuiDockNodeFlags_NoResize
+						| ImGuiDockNodeFlags_NoUndocking;
+
+		dockspace_flags ^= ImGuiDockNodeFlags_PassthruCentralNode;
+		ImGui::DockSpaceOverViewport(0, ImGui::GetMainViewport(), dockspace_flags);
+	}
+
+	for(auto &layer : m_layers) {
+		layer.second->render();
+	}
+}
+
 Application::Application(const Application::Config &config, Application::RenderBackend renderBackend)
-	: m_renderBackend(renderBackend)
+	: m_window(nullptr)
+	, m_renderBackend(renderBackend)
 	, m_config(config)
+	, m_scheduler(config.threads)
 {
-	Init();
+	if (m_renderBackend == RenderBackend::Headless) {
+		InitHeadless();
+	}
+	else {
+		Init();
+	}
 }
 
 void Application::Init()
@@ -246,8 +329,38 @@ void Application::Init()
 	m_clearColor = ImVec4(0.45f, 0.55f, 0.60f, 1.00f);
 }
 
+void Application::InitHeadless()
+{
+	IMGUI_CHECKVERSION();
+	ImGui::CreateContext();
+	ImGuiIO &io = ImGui::GetIO();
+	io.ConfigFlags |= ImGuiConfigFlags_DockingEnable;
+	io.DisplaySize = ImVec2(m_config.width, m_config.height);
+	// The layout of the windows must not depend on the imgui.ini of the working directory.
+	io.IniFilename = nullptr;
+
+	ImGui::StyleColorsDark();
+
+	ImFontConfig cfg;
+	cfg.SizePixels = 18.0f;
+	io.Fonts->AddFontDefault(&cfg);
+
+	// Normally built by the renderer backend, the texture data are not uploaded anywhere.
+	unsigned char *pixels;
+	int width;
+	int height;
+	io.Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);
+
+	m_clearColor = ImVec4(0.45f, 0.55f, 0.60f, 1.00f);
+}
+
 void Application::Cleanup()
 {
+	if (m_renderBackend == RenderBackend::Headless) {
+		ImGui::DestroyContext();
+		return;
+	}
+
 #ifdef __EMSCRIPTEN__
 	EMSCRIPTEN_MAINLOOP_END;
 #endif
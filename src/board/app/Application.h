@@ -1,11 +1,15 @@
 #pragma once
 
 #include "imgui.h"
+#include "Job.h"
 #include "Layer.h"
+#include "Scheduler.h"
 #include <GLFW/glfw3.h> // Will drag system OpenGL headers
 
 #include <cassert>
+#include <coroutine>
 #include <memory>
+#include <mutex>
 #include <unordered_map>
 #include <vector>
 
@@ -22,17 +26,46 @@ public:
 		bool fullscreen;
 		bool enableDocking;
 		std::string font;
+		/// Number of the worker threads of the scheduler, zero for all the cores.
+		unsigned threads = 0;
 	};
 
 	enum class RenderBackend
 	{
 		Polling,
 		WaitEvents,
+		/// No window and no platform or renderer backend, the frames are driven by @c frame.
+		Headless,
+	};
+
+	/**
+	 * @brief Awaitable moving a @c Job to another thread, see @c background and @c nextFrame.
+	 *
+	 * The awaitable only refers to the token of the job and has to be trivially destructible, the job may be destroyed
+	 * while it is suspended on it.
+	 */
+	class JobTransfer
+	{
+	public:
+		bool await_ready() const noexcept { return false; }
+		void await_suspend(std::coroutine_handle<> job);
+		void await_resume() const noexcept {}
+
+	private:
+		friend class Application;
+
+		JobTransfer(Application &application, const CancellationToken &token, bool nextFrame);
+
+		Application &m_application;
+		const CancellationToken &m_token;
+		bool m_nextFrame;
 	};
 
 	static std::shared_ptr<Application> create(
 		const Application::Config &config,
 		Application::RenderBackend renderBackend = Application::RenderBackend::Polling);
+
+	/// The layers are detached first, so no job is started while the pending jobs are destroyed.
 	~Application();
 
 	Application &addLayer(const std::shared_ptr<Layer> &layer);
@@ -42,13 +75,52 @@ public:
 
 	Application &setWindowSize(int width, int height);
 	GLFWwindow* window() const { return m_window; }
+	RenderBackend renderBackend() const { return m_renderBackend; }
 	int run();
 
+	/**
+	 * @brief Build one frame of all the layers without presenting it.
+	 *
+	 * Used with the @c RenderBackend::Headless, the input is fed to the ImGui IO before the call and the draw data of
+	 * the frame are available from @c ImGui::GetDrawData after it.
+	 *
+	 * @param deltaTime Time since the previous frame in seconds.
+	 */
+	void frame(float deltaTime);
+
+	/**
+	 * @brief The scheduler of all the parallel work of the application.
+	 *
+	 * Runs the background jobs and the parallel loops of the layers, so the number of the threads is set in one
+	 * place and the work is counted, see @c Scheduler::statistics.
+	 */
+	Scheduler &scheduler() { return m_scheduler; }
+
+	/// Awaited by a @c Job to continue on a worker of the scheduler, the token has to be kept by the job.
+	JobTransfer background(const CancellationToken &token) { return JobTransfer(*this, token, false); }
+
+	/// Awaited by a @c Job to continue on the UI thread at the start of the next frame, the same as @c background.
+	JobTransfer nextFrame(const CancellationToken &token) { return JobTransfer(*this, token, true); }
+
 private:
+	/// A job waiting for the next frame.
+	struct PendingJob
+	{
+		std::coroutine_handle<> job;
+		CancellationToken token;
+	};
+
 	explicit Application(const Application::Config &config, Application::RenderBackend renderBackend);
 	void Init();
+	void InitHeadless();
 	void Cleanup();
 
+	/// Render the dock space and all the layers into the current ImGui frame.
+	void renderLayers();
+
+	/// Resume the jobs waiting for the frame, the cancelled ones are destroyed.
+	void resumeJobs();
+
 private:
 	/// OpenGL3 window data.
 	GLFWwindow* m_window;
@@ -65,6 +137,13 @@ private:
 	/// All the windows displayed in the application.
 	/// The key is the name of the layer.
 	std::unordered_map<std::string, std::shared_ptr<Layer>> m_layers;
+
+	/// Workers of the background jobs and the parallel loops.
+	Scheduler m_scheduler;
+
+	/// Jobs waiting for the next frame, guarded by the mutex.
+	std::vector<PendingJob> m_frameJobs;
+	std::mutex m_frameJobMutex;
 };
 
 template <typename T>
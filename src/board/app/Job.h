@@ -0,0 +1,32 @@
+#pragma once
+
+#include "CancellationToken.h"
+
+#include <coroutine>
+#include <exception>
+
+/**
+ * @class Job
+ * @brief Coroutine computing a result in the background and handing it over to the UI thread.
+ *
+ * The job starts right away on the calling thread and the caller does not wait for it. The job moves between the
+ * threads by awaiting @c Application::background and @c Application::nextFrame with its @c CancellationToken. When
+ * the token is cancelled at one of them, the job is destroyed instead of resumed, so a stale result is never applied
+ * and a superseded job does not take any more time of the workers.
+ *
+ * The parameters of the job are kept in its frame, so the state it works on has to be passed by value.
+ */
+class Job
+{
+public:
+	struct promise_type
+	{
+		Job get_return_object() { return Job(); }
+		std::suspend_never initial_suspend() noexcept { return {}; }
+		/// The finished job destroys itself.
+		std::suspend_never final_suspend() noexcept { return {}; }
+		void return_void() {}
+		/// The jobs run on the workers of the @c Scheduler, which must not throw.
+		void unhandled_exception() { std::terminate(); }
+	};
+};
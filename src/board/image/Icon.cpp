@@ -36,8 +36,17 @@ Icon::Icon(Ocupant ocupation, const std::string &texturePath, int width, int hei
 	: m_ocupation(ocupation)
 	, m_width(width)
 	, m_height(height)
+	, m_texture(0)
 	, m_texturePath(texturePath)
 {
+}
+
+void Icon::loadTexture()
+{
+	if (m_texture != 0 || m_texturePath.empty()) {
+		return;
+	}
+
 	int h;
 	int w;
 
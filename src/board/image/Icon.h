@@ -28,6 +28,9 @@ public:
 
 	explicit Icon(Ocupant ocupation, const std::string &texturePath, int width, int height);
 	Ocupant ocupation() const;
+
+	/// Upload the image to a texture, needs the current OpenGL context. Until then the texture is 0.
+	void loadTexture();
 	GLuint texture();
 	int textureWidth() const { return m_width; }
 	int textureHeight() const { return m_height; }
@@ -37,6 +37,13 @@ Icons &Icons::instance()
 	return instance;
 }
 
+void Icons::loadTextures()
+{
+	for (auto &icon : m_icons) {
+		icon->loadTexture();
+	}
+}
+
 Icon::Ptr Icons::icon(Icon::Ocupant ocupant)
 {
 	return m_icons[static_cast<int>(ocupant)];
@@ -13,6 +13,9 @@ class Icons
 public:
 	static Icons &instance();
 
+	/// Load the textures of all the icons, the headless application has no OpenGL context and skips it.
+	void loadTextures();
+
 	Icon::Ptr icon(Icon::Ocupant ocupant);
 
 private:
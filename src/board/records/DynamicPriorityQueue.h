@@ -1,7 +1,6 @@
 #pragma once
 
 #include <algorithm>
-#include <execution>
 #include <vector>
 #include <functional>
 
@@ -46,20 +45,39 @@ public:
 
 	/**
 	 * @brief Sort the elements in the container.
+	 *
+	 * The elements are sorted on the calling thread, a large queue can be sorted on the workers of a scheduler
+	 * after the sorter is set without invoking it.
 	 */
 	void sort()
 	{
-		std::sort(std::execution::par_unseq, this->begin(), this->end(), m_sorter);
+		std::sort(this->begin(), this->end(), m_sorter);
 	}
 
 	/**
 	 * @brief Push an element to the priority queue.
 	 *
+	 * The element is inserted after its equals, the sorted container is not sorted again.
+	 *
 	 * @param value Element to push to the priority queue.
 	 */
 	void push(const T &value)
 	{
-		this->push_back(value);
+		this->insert(std::upper_bound(this->begin(), this->end(), value, m_sorter), value);
+	}
+
+	/**
+	 * @brief Push a range of elements to the priority queue.
+	 *
+	 * The container is sorted only once after all the elements are inserted.
+	 *
+	 * @param first Iterator to the first element to push.
+	 * @param last Iterator past the last element to push.
+	 */
+	template <typename InputIt>
+	void push(InputIt first, InputIt last)
+	{
+		this->insert(this->end(), first, last);
 		sort();
 	}
 
@@ -0,0 +1,159 @@
+#include "BoardCorpus.h"
+
+#include "Minefield.h"
+
+#include <algorithm>
+#include <cstring>
+
+bool BoardCorpus::Board::valid() const
+{
+	if (size() > MAX_CELLS || first >= size()) {
+		return false;
+	}
+
+	uint64_t count = 0;
+	for (uint64_t word = 0; word < words(); word++) {
+		count += std::popcount(mineWord(word));
+	}
+	return count == numberOfMines;
+}
+
+void BoardCorpus::Board::place(Minefield &field) const
+{
+	std::vector<int> cells;
+	cells.reserve(numberOfMines);
+
+	for (uint64_t word = 0; word < words(); word++) {
+		// Only the set bits are visited, the boards are mostly empty.
+		for (uint64_t bits = mineWord(word); bits != 0; bits &= bits - 1) {
+			cells.push_back(static_cast<int>(word * 64 + std::countr_zero(bits)));
+		}
+	}
+
+	field.placeMines(cells);
+}
+
+BoardCorpus::BoardCorpus(const std::string &path)
+	: m_file(path)
+	, m_header(nullptr)
+{
+	if (!m_file.isOpen() || m_file.size() < sizeof(Header)) {
+		return;
+	}
+
+	auto header = reinterpret_cast<const Header *>(m_file.data().data());
+	if (std::memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0 || header->version != VERSION
+		|| header->headerSize < sizeof(Header) || header->headerSize > m_file.size())
+	{
+		return;
+	}
+
+	m_header = header;
+}
+
+uint64_t BoardCorpus::size() const
+{
+	if (!isOpen()) {
+		return 0;
+	}
+
+	// Every board takes at least its header and one word, a corrupted count does not make the readers reserve more.
+	auto capacity = (m_file.size() - m_header->headerSize) / (sizeof(Board) + sizeof(uint64_t));
+	return std::min<uint64_t>(m_header->count, capacity);
+}
+
+BoardCorpus::Iterator BoardCorpus::begin() const
+{
+	if (!isOpen()) {
+		return {};
+	}
+
+	auto data = m_file.data();
+	return { data.data() + m_header->headerSize, data.data() + data.size() };
+}
+
+BoardCorpus::Iterator BoardCorpus::end() const
+{
+	if (!isOpen()) {
+		return {};
+	}
+
+	auto data = m_file.data();
+	return { data.data() + data.size(), data.data() + data.size() };
+}
+
+BoardCorpusWriter::BoardCorpusWriter(const std::string &path)
+	: m_file(std::fopen(path.c_str(), "wb"))
+	, m_count(0)
+{
+	// The header is rewritten with the final count by close.
+	if (m_file != nullptr && !writeHeader()) {
+		std::fclose(m_file);
+		m_file = nullptr;
+	}
+}
+
+BoardCorpusWriter::~BoardCorpusWriter()
+{
+	close();
+}
+
+bool BoardCorpusWriter::add(const Minefield &field, int first)
+{
+	if (m_file == nullptr) {
+		return false;
+	}
+
+	BoardCorpus::Board board {
+		.width = static_cast<uint16_t>(field.width()),
+		.height = static_cast<uint16_t>(field.height()),
+		.numberOfMines = static_cast<uint32_t>(field.numberOfMines()),
+		.first = static_cast<uint32_t>(first),
+		.reserved = 0,
+		.seed = field.seed(),
+	};
+
+	m_bitset.assign(board.words(), 0);
+	for (int cell = 0; cell < field.size(); cell++) {
+		if (field.isMine(cell)) {
+			m_bitset[cell / 64] |= uint64_t(1) << (cell % 64);
+		}
+	}
+
+	if (std::fwrite(&board, sizeof(board), 1, m_file) != 1
+		|| std::fwrite(m_bitset.data(), sizeof(uint64_t), m_bitset.size(), m_file) != m_bitset.size())
+	{
+		std::fclose(m_file);
+		m_file = nullptr;
+		return false;
+	}
+
+	m_count++;
+	return true;
+}
+
+bool BoardCorpusWriter::close()
+{
+	if (m_file == nullptr) {
+		return false;
+	}
+
+	bool written = std::fseek(m_file, 0, SEEK_SET) == 0 && writeHeader();
+	written &= std::fclose(m_file) == 0;
+	m_file = nullptr;
+	return written;
+}
+
+bool BoardCorpusWriter::writeHeader()
+{
+	BoardCorpus::Header header {
+		.magic = {},
+		.version = BoardCorpus::VERSION,
+		.headerSize = sizeof(BoardCorpus::Header),
+		.count = m_count,
+		.reserved = 0,
+	};
+	std::copy(std::begin(BoardCorpus::MAGIC), std::end(BoardCorpus::MAGIC), header.magic);
+
+	return std::fwrite(&header, sizeof(header), 1, m_file) == 1;
+}
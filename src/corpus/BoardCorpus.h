@@ -0,0 +1,221 @@
+#pragma once
+
+#include "MappedFile.h"
+
+#include <bit>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <iterator>
+#include <span>
+#include <string>
+#include <vector>
+
+class Minefield;
+
+static_assert(std::endian::native == std::endian::little, "The corpus is stored in the little endian byte order");
+
+/**
+ * @class BoardCorpus
+ * @brief Memory mapped, read only collection of fixed boards.
+ *
+ * The corpus is the shared workload of the solver and generator regression runs, the simulator and the benchmarks.
+ * The boards are stored with their mines, so the workload does not depend on the random generator of the version
+ * that reads it.
+ *
+ * File layout, all the numbers are little endian:
+ *  - Header of 32 bytes: magic "MSCORPUS", format version, size of the header, number of boards, reserved.
+ *  - Every board is a 24 byte header, see @c Board, followed by the mine bitset of width * height bits, bit i of
+ *    the 64 bit word i / 64 is the cell i. The bitset is padded to whole words, so every board starts 8 byte
+ *    aligned. The padding bits are ignored.
+ *
+ * The reader does not parse the file, the iterator points directly into the mapping and the next board is found
+ * from the dimensions of the current one.
+ */
+class BoardCorpus
+{
+public:
+	/// Header of one board, the mine bitset follows it.
+	struct Board
+	{
+		uint16_t width;
+		uint16_t height;
+		uint32_t numberOfMines;
+		/// The first clicked cell, no mine is placed around it.
+		uint32_t first;
+		uint32_t reserved;
+		/// Seed the board was generated from, zero if the mines were placed explicitly.
+		uint64_t seed;
+
+		/// Number of the cells, the product of the dimensions of a corrupted header does not fit in an int.
+		uint64_t size() const { return uint64_t(width) * height; }
+
+		/// Number of the 64 bit words of the mine bitset.
+		uint64_t words() const { return (size() + 63) / 64; }
+
+		/// Mine bitset following the header.
+		std::span<const uint64_t> mines() const
+		{
+			return { reinterpret_cast<const uint64_t *>(this + 1), words() };
+		}
+
+		bool isMine(int cell) const { return mines()[cell / 64] >> (cell % 64) & 1; }
+
+		/// Word of the mine bitset without the padding bits past the last cell.
+		uint64_t mineWord(uint64_t word) const
+		{
+			uint64_t bits = size() - word * 64;
+			return bits >= 64 ? mines()[word] : mines()[word] & ((uint64_t(1) << bits) - 1);
+		}
+
+		/**
+		 * @brief True if the board fits on a field, the first cell is on the board and the bitset holds the
+		 * declared number of the mines.
+		 */
+		bool valid() const;
+
+		/// Place the mines of the valid board on the field of the same dimensions.
+		void place(Minefield &field) const;
+	};
+
+	/// Header of the corpus file.
+	struct Header
+	{
+		char magic[8];
+		uint32_t version;
+		uint32_t headerSize;
+		uint64_t count;
+		uint64_t reserved;
+	};
+
+	/// Forward iterator over the boards pointing into the mapping.
+	class Iterator
+	{
+	public:
+		using iterator_category = std::forward_iterator_tag;
+		using value_type = Board;
+		using difference_type = std::ptrdiff_t;
+		using pointer = const Board *;
+		using reference = const Board &;
+
+		Iterator() = default;
+		Iterator(const char *current, const char *end) : m_current(current), m_end(end) { check(); }
+
+		const Board &operator*() const { return *reinterpret_cast<const Board *>(m_current); }
+		const Board *operator->() const { return reinterpret_cast<const Board *>(m_current); }
+
+		Iterator &operator++()
+		{
+			m_current += sizeof(Board) + (*this)->words() * sizeof(uint64_t);
+			check();
+			return *this;
+		}
+
+		Iterator operator++(int)
+		{
+			auto previous = *this;
+			++*this;
+			return previous;
+		}
+
+		bool operator==(const Iterator &other) const { return m_current == other.m_current; }
+
+	private:
+		/// Stop at a board that is truncated, overruns the file or is not valid, the file is not trusted.
+		void check()
+		{
+			if (m_current != m_end && (m_end - m_current < static_cast<std::ptrdiff_t>(sizeof(Board))
+				|| m_end - m_current < static_cast<std::ptrdiff_t>(sizeof(Board) + (*this)->words() * sizeof(uint64_t))
+				|| !(*this)->valid()))
+			{
+				m_current = m_end;
+			}
+		}
+
+	private:
+		const char *m_current = nullptr;
+		const char *m_end = nullptr;
+	};
+
+	static constexpr char MAGIC[8] = { 'M', 'S', 'C', 'O', 'R', 'P', 'U', 'S' };
+	static constexpr uint32_t VERSION = 1;
+	/// Most cells of a board, the cells of a @c Minefield are indexed by int.
+	static constexpr uint64_t MAX_CELLS = INT_MAX;
+
+	/**
+	 * @brief Map the corpus file.
+	 *
+	 * If the file does not exist or its header is not valid, the corpus is empty and @c isOpen returns false.
+	 *
+	 * @param path Path to the corpus file.
+	 */
+	explicit BoardCorpus(const std::string &path);
+
+	/// True if the file is mapped and its header is valid.
+	bool isOpen() const { return m_header != nullptr; }
+
+	/// Number of the boards declared by the header, at most as many as the file can hold.
+	uint64_t size() const;
+
+	Iterator begin() const;
+	Iterator end() const;
+
+private:
+	MappedFile m_file;
+	const Header *m_header;
+};
+
+static_assert(sizeof(BoardCorpus::Board) == 24 && sizeof(BoardCorpus::Header) == 32);
+
+/**
+ * @class BoardCorpusWriter
+ * @brief Writer of the corpus files read by the @c BoardCorpus.
+ *
+ * The boards are appended one by one, the number of the boards in the header is written by @c close.
+ */
+class BoardCorpusWriter
+{
+public:
+	/**
+	 * @brief Create the corpus file, an existing file is replaced.
+	 *
+	 * @param path Path to the corpus file.
+	 */
+	explicit BoardCorpusWriter(const std::string &path);
+	BoardCorpusWriter(const BoardCorpusWriter &) = delete;
+	BoardCorpusWriter &operator=(const BoardCorpusWriter &) = delete;
+
+	/// Close the file if it was not closed yet.
+	~BoardCorpusWriter();
+
+	/// True if the file was created and no write failed.
+	bool isOpen() const { return m_file != nullptr; }
+
+	/**
+	 * @brief Append the board of the field.
+	 *
+	 * @param field Field with the mines placed.
+	 * @param first The first clicked cell of the board.
+	 * @return True if the board was written.
+	 */
+	bool add(const Minefield &field, int first);
+
+	/// Number of the boards written so far.
+	uint64_t count() const { return m_count; }
+
+	/**
+	 * @brief Write the header and close the file.
+	 *
+	 * @return True if all the boards and the header were written.
+	 */
+	bool close();
+
+private:
+	/// Write the header with the current number of the boards at the start of the file.
+	bool writeHeader();
+
+private:
+	std::FILE *m_file;
+	uint64_t m_count;
+	std::vector<uint64_t> m_bitset;
+};
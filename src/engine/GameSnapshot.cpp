@@ -0,0 +1,143 @@
+#include "GameSnapshot.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define SNAPSHOT_MAGIC "MSSNAPSH"
+#define SNAPSHOT_VERSION 1
+
+static_assert(sizeof(GameSnapshot::Header) == 64);
+
+GameSnapshot::GameSnapshot(const std::string &path)
+	: m_fd(-1)
+	, m_header(nullptr)
+	, m_size(0)
+{
+	m_fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+	if (m_fd == -1) {
+		return;
+	}
+
+	// Another instance plays the game of the file, it would be overwritten by both. The lock is released when the fd
+	// is closed, also by a crash.
+	if (::flock(m_fd, LOCK_EX | LOCK_NB) != 0) {
+		return;
+	}
+
+	struct stat info;
+	if (::fstat(m_fd, &info) != 0) {
+		return;
+	}
+
+	if (!resize(std::max<size_t>(info.st_size, sizeof(Header)))) {
+		return;
+	}
+	if (!valid()) {
+		reset();
+	}
+}
+
+GameSnapshot::~GameSnapshot()
+{
+	if (m_header != nullptr) {
+		::munmap(m_header, m_size);
+	}
+	if (m_fd != -1) {
+		::close(m_fd);
+	}
+}
+
+std::span<const uint8_t> GameSnapshot::cells() const
+{
+	return { reinterpret_cast<const uint8_t *>(m_header) + sizeof(Header), m_size - sizeof(Header) };
+}
+
+void GameSnapshot::start(const Minefield &field)
+{
+	if (!isOpen()) {
+		return;
+	}
+
+	// A crash in the middle of the write must not leave a half written game behind.
+	m_header->active = 0;
+	if (!resize(sizeof(Header) + field.size())) {
+		return;
+	}
+
+	auto *cells = reinterpret_cast<uint8_t *>(m_header) + sizeof(Header);
+	std::copy(field.cells().begin(), field.cells().end(), cells);
+	m_header->width = field.width();
+	m_header->height = field.height();
+	m_header->numberOfMines = field.numberOfMines();
+	m_header->seed = field.seed();
+	m_header->elapsed = 0;
+	m_header->clicks = 0;
+	m_header->assisted = 0;
+	// The compiler must not move the game ahead of its content, the stores are seen in order by the page cache.
+	std::atomic_signal_fence(std::memory_order_release);
+	m_header->active = 1;
+}
+
+void GameSnapshot::update(const Minefield &field, std::span<const int> changed)
+{
+	if (!active()) {
+		return;
+	}
+
+	auto *cells = reinterpret_cast<uint8_t *>(m_header) + sizeof(Header);
+	for (int cell : changed) {
+		cells[cell] = field.cells()[cell];
+	}
+}
+
+void GameSnapshot::clear()
+{
+	if (isOpen()) {
+		m_header->active = 0;
+	}
+}
+
+bool GameSnapshot::resize(size_t size)
+{
+	if (m_header != nullptr && size == m_size) {
+		return true;
+	}
+
+	if (m_header != nullptr) {
+		::munmap(m_header, m_size);
+		m_header = nullptr;
+	}
+	if (::ftruncate(m_fd, size) != 0) {
+		return false;
+	}
+
+	void *data = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+	if (data == MAP_FAILED) {
+		return false;
+	}
+	m_header = static_cast<Header *>(data);
+	m_size = size;
+	return true;
+}
+
+bool GameSnapshot::valid() const
+{
+	return std::memcmp(m_header->magic, SNAPSHOT_MAGIC, sizeof(m_header->magic)) == 0
+		&& m_header->version == SNAPSHOT_VERSION && m_header->headerSize == sizeof(Header)
+		&& m_size == sizeof(Header) + static_cast<size_t>(m_header->width) * m_header->height;
+}
+
+void GameSnapshot::reset()
+{
+	std::memset(m_header, 0, sizeof(Header));
+	std::memcpy(m_header->magic, SNAPSHOT_MAGIC, sizeof(m_header->magic));
+	m_header->version = SNAPSHOT_VERSION;
+	m_header->headerSize = sizeof(Header);
+	resize(sizeof(Header));
+}
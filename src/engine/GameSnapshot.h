@@ -0,0 +1,120 @@
+#pragma once
+
+#include "Minefield.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+
+/**
+ * @class GameSnapshot
+ * @brief The game in progress kept in a shared memory mapped file.
+ *
+ * The file is the header followed by the cells of the @c Minefield in their internal form. The mapping is shared,
+ * so every write lands in the page cache right away. The game is written once when it starts, after that only the
+ * cells changed by an action, the clicks and the elapsed time are written. Nothing is serialized at the exit and a
+ * crash of the process loses nothing, the kernel writes the pages back on its own.
+ *
+ * Layout of the header, all the numbers in the native byte order:
+ *  - 0  Magic "MSSNAPSH".
+ *  - 8  Version and the size of the header, u32 each.
+ *  - 16 Width and height, u16 each, the number of mines u32.
+ *  - 24 Seed of the mines, u64.
+ *  - 32 Elapsed milliseconds, u64.
+ *  - 40 Clicks, u64.
+ *  - 48 Nonzero while the game is in progress, u32.
+ *  - 52 Nonzero if the solver helped in the game, u32, followed by the reserved bytes.
+ */
+class GameSnapshot
+{
+public:
+	/// The fixed size start of the file.
+	struct Header
+	{
+		char magic[8];
+		uint32_t version;
+		uint32_t headerSize;
+		uint16_t width;
+		uint16_t height;
+		uint32_t numberOfMines;
+		uint64_t seed;
+		uint64_t elapsed;
+		uint64_t clicks;
+		uint32_t active;
+		uint32_t assisted;
+		uint32_t reserved[2];
+	};
+
+	/**
+	 * @brief Open or create the snapshot file and map it.
+	 *
+	 * A file that is not a valid snapshot is reset. The file is locked for as long as the object exists. If the file
+	 * can not be created or another instance holds its lock, the object is created but @c isOpen returns false and
+	 * nothing is stored.
+	 *
+	 * @param path Path to the snapshot file.
+	 */
+	explicit GameSnapshot(const std::string &path);
+	GameSnapshot(const GameSnapshot &) = delete;
+	GameSnapshot &operator=(const GameSnapshot &) = delete;
+	~GameSnapshot();
+
+	/// True if the file was successfully mapped.
+	bool isOpen() const { return m_header != nullptr; }
+
+	/// True if the file holds a game in progress.
+	bool active() const { return isOpen() && m_header->active != 0; }
+
+	int width() const { return m_header->width; }
+	int height() const { return m_header->height; }
+	uint64_t seed() const { return m_header->seed; }
+
+	/// Milliseconds played until the last update.
+	uint64_t elapsed() const { return m_header->elapsed; }
+
+	uint64_t clicks() const { return m_header->clicks; }
+
+	/// True if the solver helped in the game, so it is not scored when resumed.
+	bool assisted() const { return m_header->assisted != 0; }
+
+	/// The stored cells, see @c Minefield::restore.
+	std::span<const uint8_t> cells() const;
+
+	/**
+	 * @brief Store the whole field as the game in progress.
+	 *
+	 * The file is resized to the dimensions of the field, the game becomes active only once it is completely written.
+	 */
+	void start(const Minefield &field);
+
+	/**
+	 * @brief Store the cells changed by an action.
+	 *
+	 * @param field The field the game was started with.
+	 * @param changed The changed cells, see @c Minefield::changes.
+	 */
+	void update(const Minefield &field, std::span<const int> changed);
+
+	void setElapsed(uint64_t milliseconds) { m_header->elapsed = milliseconds; }
+	void setClicks(uint64_t clicks) { m_header->clicks = clicks; }
+	void setAssisted(bool assisted) { m_header->assisted = assisted; }
+
+	/// Mark the game as finished, it is not resumed anymore.
+	void clear();
+
+private:
+	/// Resize the file and map it again, the content up to the new size is kept.
+	bool resize(size_t size);
+
+	/// True if the mapped content is a snapshot of this version.
+	bool valid() const;
+
+	/// Write an empty header.
+	void reset();
+
+private:
+	int m_fd;
+	Header *m_header;
+	size_t m_size;
+};
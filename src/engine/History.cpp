@@ -0,0 +1,66 @@
+#include "History.h"
+
+#include <utility>
+
+History::History(size_t capacity)
+	: m_capacity(capacity)
+	, m_cells(0)
+	, m_position(0)
+	, m_deltas()
+{
+}
+
+void History::clear()
+{
+	m_deltas.clear();
+	m_cells = 0;
+	m_position = 0;
+}
+
+void History::push(Minefield::Delta delta)
+{
+	if (delta.cells.empty()) {
+		return;
+	}
+
+	while (canRedo()) {
+		m_cells -= m_deltas.back().cells.size();
+		m_deltas.pop_back();
+	}
+
+	m_cells += delta.cells.size();
+	m_deltas.push_back(std::move(delta));
+	m_position = m_deltas.size();
+	trim();
+}
+
+const Minefield::Delta *History::undo(Minefield &field)
+{
+	if (!canUndo()) {
+		return nullptr;
+	}
+
+	const auto &delta = m_deltas[--m_position];
+	field.undo(delta);
+	return &delta;
+}
+
+const Minefield::Delta *History::redo(Minefield &field)
+{
+	if (!canRedo()) {
+		return nullptr;
+	}
+
+	const auto &delta = m_deltas[m_position++];
+	field.redo(delta);
+	return &delta;
+}
+
+void History::trim()
+{
+	while (m_cells > m_capacity && m_deltas.size() > 1) {
+		m_cells -= m_deltas.front().cells.size();
+		m_deltas.pop_front();
+		m_position--;
+	}
+}
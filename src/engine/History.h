@@ -0,0 +1,66 @@
+#pragma once
+
+#include "Minefield.h"
+
+#include <cstddef>
+#include <deque>
+
+/**
+ * @class History
+ * @brief Undo and redo of the actions performed on a @c Minefield.
+ *
+ * Every action is stored as its @c Minefield::Delta, the cells it changed, so taking it back or performing it again
+ * costs as much as the action itself and no copy of the whole field is made. The memory is bounded by the total
+ * number of the stored cells, the oldest actions are forgotten once it is exceeded.
+ */
+class History
+{
+public:
+	/**
+	 * @brief Create an empty history.
+	 *
+	 * @param capacity Total number of the cells of the stored actions, the last action is kept even if it is larger.
+	 */
+	explicit History(size_t capacity);
+
+	/// Forget all the actions, called when a new game starts.
+	void clear();
+
+	/**
+	 * @brief Store the action performed on the field.
+	 *
+	 * The actions taken back are forgotten, they can not be performed again.
+	 *
+	 * @param delta Delta of the action, nothing is stored if it changed no cell.
+	 */
+	void push(Minefield::Delta delta);
+
+	bool canUndo() const { return m_position > 0; }
+	bool canRedo() const { return m_position < m_deltas.size(); }
+
+	/**
+	 * @brief Take back the last action.
+	 *
+	 * @return The delta taken back, nullptr if there is no action to be taken back.
+	 */
+	const Minefield::Delta *undo(Minefield &field);
+
+	/**
+	 * @brief Perform the last action taken back again.
+	 *
+	 * @return The delta performed, nullptr if no action was taken back.
+	 */
+	const Minefield::Delta *redo(Minefield &field);
+
+private:
+	/// Forget the oldest actions until the stored cells fit into the capacity.
+	void trim();
+
+private:
+	size_t m_capacity;
+	/// Number of the cells of all the stored deltas.
+	size_t m_cells;
+	/// Number of the deltas not taken back, the deltas behind it can be performed again.
+	size_t m_position;
+	std::deque<Minefield::Delta> m_deltas;
+};
@@ -0,0 +1,36 @@
+#include "MappedFile.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::MappedFile(const std::string &path)
+	: m_data(nullptr)
+	, m_size(0)
+{
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd == -1) {
+		return;
+	}
+
+	struct stat info;
+	if (::fstat(fd, &info) == 0 && info.st_size > 0) {
+		void *data = ::mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (data != MAP_FAILED) {
+			m_data = static_cast<const char *>(data);
+			m_size = info.st_size;
+			::madvise(data, m_size, MADV_SEQUENTIAL);
+		}
+	}
+
+	// The mapping stays valid after the descriptor is closed.
+	::close(fd);
+}
+
+MappedFile::~MappedFile()
+{
+	if (m_data != nullptr) {
+		::munmap(const_cast<char *>(m_data), m_size);
+	}
+}
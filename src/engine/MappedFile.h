@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+/**
+ * @class MappedFile
+ * @brief Read only memory mapping of a whole file.
+ *
+ * The mapping is created in the constructor and released in the destructor. The size of the mapping is fixed
+ * at the time of the construction, so data appended to the file later are not visible through this object.
+ */
+class MappedFile
+{
+public:
+	/**
+	 * @brief Map the file into memory.
+	 *
+	 * If the file does not exist or is empty, the object is created but @c isOpen returns false.
+	 *
+	 * @param path Path to the file.
+	 */
+	explicit MappedFile(const std::string &path);
+	MappedFile(const MappedFile &) = delete;
+	MappedFile &operator=(const MappedFile &) = delete;
+	~MappedFile();
+
+	/// True if the file was successfully mapped.
+	bool isOpen() const { return m_data != nullptr; }
+
+	/// View of the whole mapped file.
+	std::string_view data() const { return { m_data, m_size }; }
+
+	/// Size of the mapping in bytes.
+	size_t size() const { return m_size; }
+
+private:
+	const char *m_data;
+	size_t m_size;
+};
@@ -0,0 +1,344 @@
+#include "Minefield.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <random>
+
+namespace
+{
+
+/// Uniform number in the range [0, bound), unlike std::uniform_int_distribution the same on every platform.
+uint64_t bounded(std::mt19937_64 &random, uint64_t bound)
+{
+	return static_cast<uint64_t>((static_cast<unsigned __int128>(random()) * bound) >> 64);
+}
+
+}
+
+Minefield::Minefield(int width, int height, int numberOfMines)
+	: m_width(width)
+	, m_height(height)
+	, m_numberOfMines(numberOfMines)
+	, m_numberOfFlags(0)
+	, m_numberOfCorrectFlags(0)
+	, m_numberOfRevealed(0)
+	, m_bbbv(0)
+	, m_initialized(false)
+	, m_seed(0)
+	, m_state(State::Playing)
+	, m_lastState(State::Playing)
+	, m_lastFlag(false)
+	, m_cells(width * height, 0)
+{
+}
+
+void Minefield::generate(int first, uint64_t seed)
+{
+	std::vector<int> candidates;
+	candidates.reserve(size());
+	for (int cell = 0; cell < size(); cell++) {
+		// Ensures that the mines will not be generated around the first click.
+		if (std::abs(x(cell) - x(first)) > 1 || std::abs(y(cell) - y(first)) > 1) {
+			candidates.push_back(cell);
+		}
+	}
+
+	// Partial Fisher-Yates shuffle, the first count candidates are the mines.
+	std::mt19937_64 random(seed);
+	int count = std::min<int>(m_numberOfMines, candidates.size());
+	for (int i = 0; i < count; i++) {
+		std::swap(candidates[i], candidates[i + bounded(random, candidates.size() - i)]);
+	}
+	candidates.resize(count);
+
+	placeMines(candidates);
+	m_seed = seed;
+}
+
+void Minefield::placeMines(std::span<const int> mines)
+{
+	std::fill(m_cells.begin(), m_cells.end(), 0);
+	m_numberOfMines = mines.size();
+	m_numberOfFlags = 0;
+	m_numberOfCorrectFlags = 0;
+	m_numberOfRevealed = 0;
+	m_state = State::Playing;
+	m_seed = 0;
+	m_changes.clear();
+
+	for (int mine : mines) {
+		m_cells[mine] |= MINE_BIT;
+		forEachNeighbour(mine, [this](int neighbour) {
+			m_cells[neighbour]++;
+		});
+	}
+
+	m_bbbv = computeBbbv();
+	m_initialized = true;
+}
+
+PackedTile Minefield::packedTile(int cell) const
+{
+	bool over = m_state != State::Playing;
+	if (isFlagged(cell)) {
+		return over && !isMine(cell) ? PackedTile::WrongFlag : PackedTile::Flag;
+	}
+	if (isRevealed(cell) || (over && isMine(cell))) {
+		return static_cast<PackedTile>(adjacentMines(cell));
+	}
+	return PackedTile::Hidden;
+}
+
+void Minefield::packTiles(std::span<PackedTile> tiles) const
+{
+	if (m_state != State::Playing) {
+		for (int cell = 0; cell < size(); cell++) {
+			tiles[cell] = packedTile(cell);
+		}
+		return;
+	}
+
+	// The cells in play are hidden, flagged or revealed, without the branches of the finished game.
+	for (int cell = 0; cell < size(); cell++) {
+		uint8_t value = m_cells[cell];
+		tiles[cell] = value & FLAG_BIT ? PackedTile::Flag
+			: value & REVEALED_BIT ? static_cast<PackedTile>(value & COUNT_MASK)
+			: PackedTile::Hidden;
+	}
+}
+
+bool Minefield::reveal(int cell)
+{
+	m_changes.clear();
+	m_lastState = m_state;
+	m_lastFlag = false;
+	if (!m_initialized || m_state != State::Playing || isRevealed(cell) || isFlagged(cell)) {
+		return false;
+	}
+
+	open(cell);
+	checkWin();
+	return true;
+}
+
+bool Minefield::chord(int cell)
+{
+	m_changes.clear();
+	m_lastState = m_state;
+	m_lastFlag = false;
+	if (m_state != State::Playing || !isRevealed(cell) || isMine(cell)
+		|| adjacentFlags(cell) != adjacentMines(cell))
+	{
+		return false;
+	}
+
+	forEachNeighbour(cell, [this](int neighbour) {
+		if (m_state == State::Playing && !isRevealed(neighbour) && !isFlagged(neighbour)) {
+			open(neighbour);
+		}
+	});
+
+	checkWin();
+	return !m_changes.empty();
+}
+
+bool Minefield::toggleFlag(int cell)
+{
+	m_changes.clear();
+	m_lastState = m_state;
+	m_lastFlag = true;
+	if (m_state != State::Playing || isRevealed(cell)) {
+		return false;
+	}
+
+	m_cells[cell] ^= FLAG_BIT;
+	int delta = isFlagged(cell) ? 1 : -1;
+	m_numberOfFlags += delta;
+	if (isMine(cell)) {
+		m_numberOfCorrectFlags += delta;
+	}
+
+	m_changes.push_back(cell);
+	checkWin();
+	return true;
+}
+
+void Minefield::restore(std::span<const uint8_t> cells, uint64_t seed)
+{
+	m_cells.assign(cells.begin(), cells.end());
+	m_numberOfMines = 0;
+	m_numberOfFlags = 0;
+	m_numberOfCorrectFlags = 0;
+	m_numberOfRevealed = 0;
+	m_state = State::Playing;
+	m_seed = seed;
+	m_changes.clear();
+
+	for (int cell = 0; cell < size(); cell++) {
+		m_numberOfMines += isMine(cell);
+		m_numberOfFlags += isFlagged(cell);
+		m_numberOfCorrectFlags += isFlagged(cell) && isMine(cell);
+		m_numberOfRevealed += isRevealed(cell) && !isMine(cell);
+		if (isRevealed(cell) && isMine(cell)) {
+			m_state = State::Lose;
+		}
+	}
+
+	m_bbbv = computeBbbv();
+	m_initialized = true;
+	checkWin();
+}
+
+Minefield::Delta Minefield::lastDelta() const
+{
+	return { m_changes, m_lastFlag, m_lastState, m_state };
+}
+
+void Minefield::undo(const Delta &delta)
+{
+	flip(delta);
+	m_state = delta.before;
+}
+
+void Minefield::redo(const Delta &delta)
+{
+	flip(delta);
+	m_state = delta.after;
+}
+
+void Minefield::flip(const Delta &delta)
+{
+	uint8_t bit = delta.flag ? FLAG_BIT : REVEALED_BIT;
+	for (int cell : delta.cells) {
+		m_cells[cell] ^= bit;
+		int direction = m_cells[cell] & bit ? 1 : -1;
+		if (delta.flag) {
+			m_numberOfFlags += direction;
+			m_numberOfCorrectFlags += isMine(cell) ? direction : 0;
+		}
+		else if (!isMine(cell)) {
+			// A revealed mine is not counted, see open.
+			m_numberOfRevealed += direction;
+		}
+	}
+	m_changes = delta.cells;
+}
+
+Minefield Minefield::view() const
+{
+	Minefield result(m_width, m_height, m_numberOfMines);
+	result.m_numberOfRevealed = m_numberOfRevealed;
+	result.m_initialized = m_initialized;
+	for (int cell = 0; cell < size(); cell++) {
+		if (isRevealed(cell)) {
+			result.m_cells[cell] = m_cells[cell] & (REVEALED_BIT | COUNT_MASK | MINE_BIT);
+		}
+	}
+	return result;
+}
+
+void Minefield::assume(int cell, int adjacentMines)
+{
+	m_changes.clear();
+	m_cells[cell] = REVEALED_BIT | static_cast<uint8_t>(adjacentMines);
+	m_numberOfRevealed++;
+	m_changes.push_back(cell);
+}
+
+int Minefield::adjacentFlags(int cell) const
+{
+	int count = 0;
+	forEachNeighbour(cell, [this, &count](int neighbour) {
+		count += isFlagged(neighbour);
+	});
+	return count;
+}
+
+void Minefield::open(int cell)
+{
+	if (isMine(cell)) {
+		m_cells[cell] |= REVEALED_BIT;
+		m_changes.push_back(cell);
+		m_state = State::Lose;
+		return;
+	}
+
+	// Iterative flood fill, the recursion would overflow the stack on large empty boards.
+	m_stack.clear();
+	m_stack.push_back(cell);
+	while (!m_stack.empty()) {
+		int current = m_stack.back();
+		m_stack.pop_back();
+
+		if (isRevealed(current) || isFlagged(current)) {
+			continue;
+		}
+
+		m_cells[current] |= REVEALED_BIT;
+		m_numberOfRevealed++;
+		m_changes.push_back(current);
+
+		if ((m_cells[current] & COUNT_MASK) != 0) {
+			continue;
+		}
+
+		forEachNeighbour(current, [this](int neighbour) {
+			if (!isRevealed(neighbour) && !isFlagged(neighbour)) {
+				m_stack.push_back(neighbour);
+			}
+		});
+	}
+}
+
+void Minefield::checkWin()
+{
+	if (m_state != State::Playing) {
+		return;
+	}
+
+	bool allRevealed = m_numberOfRevealed == size() - m_numberOfMines;
+	bool allFlagged = m_numberOfFlags == m_numberOfMines && m_numberOfCorrectFlags == m_numberOfMines;
+	if (allRevealed || allFlagged) {
+		m_state = State::Win;
+	}
+}
+
+int Minefield::computeBbbv()
+{
+	std::vector<uint8_t> covered(size(), 0);
+	int result = 0;
+
+	// Every opening is one click, it reveals the cells around it as well.
+	for (int cell = 0; cell < size(); cell++) {
+		if (covered[cell] || (m_cells[cell] & (MINE_BIT | COUNT_MASK)) != 0) {
+			continue;
+		}
+
+		result++;
+		covered[cell] = 1;
+		m_stack.assign(1, cell);
+		while (!m_stack.empty()) {
+			int current = m_stack.back();
+			m_stack.pop_back();
+
+			forEachNeighbour(current, [this, &covered](int neighbour) {
+				if (covered[neighbour]) {
+					return;
+				}
+				covered[neighbour] = 1;
+				if ((m_cells[neighbour] & (MINE_BIT | COUNT_MASK)) == 0) {
+					m_stack.push_back(neighbour);
+				}
+			});
+		}
+	}
+
+	// Every other safe cell needs its own click.
+	for (int cell = 0; cell < size(); cell++) {
+		if (!covered[cell] && !isMine(cell)) {
+			result++;
+		}
+	}
+
+	return result;
+}
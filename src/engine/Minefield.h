@@ -0,0 +1,260 @@
+#pragma once
+
+#include "PackedTile.h"
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+/**
+ * @class Minefield
+ * @brief Rules of the game without any rendering.
+ *
+ * The minefield keeps the mines, the revealed cells and the flags of one game and implements the player actions.
+ * It does not depend on ImGui or OpenGL, so the same rules are used by the @c Board, the solver and the headless
+ * tools.
+ *
+ * The cells are addressed by their index @c y * width + x. Every cell is one byte holding the number of the
+ * adjacent mines and the mine, revealed and flag bits. Every action records the cells it changed, see @c changes,
+ * so the observers of the field update only the changed cells. The same cells make the action reversible, see
+ * @c lastDelta.
+ */
+class Minefield
+{
+public:
+	/// The state of the game.
+	enum class State
+	{
+		Playing,
+		Win,
+		Lose,
+	};
+
+	/// Value returned by @c adjacentMines for the cells with a mine, the same as @c Icon::Ocupant::Mine.
+	static constexpr int MINE = 9;
+
+	/// Reversible record of one action, the cells it changed and the states of the game around it.
+	struct Delta
+	{
+		std::vector<int> cells;
+		/// True if the action toggled a flag, false if it revealed the cells.
+		bool flag;
+		State before;
+		State after;
+	};
+
+	/**
+	 * @brief Create an empty field.
+	 *
+	 * The mines are placed by @c generate or @c placeMines once the first cell is clicked.
+	 *
+	 * @param width The number of cells in the horizontal direction.
+	 * @param height The number of cells in the vertical direction.
+	 * @param numberOfMines Number of mines to be placed.
+	 */
+	explicit Minefield(int width, int height, int numberOfMines);
+
+	int width() const { return m_width; }
+	int height() const { return m_height; }
+
+	/// Total number of cells.
+	int size() const { return m_width * m_height; }
+
+	int numberOfMines() const { return m_numberOfMines; }
+	int numberOfFlags() const { return m_numberOfFlags; }
+	int numberOfRevealed() const { return m_numberOfRevealed; }
+	State state() const { return m_state; }
+
+	/// True once the mines are placed.
+	bool initialized() const { return m_initialized; }
+
+	/**
+	 * @brief 3BV of the board, the minimal number of clicks needed to reveal all the safe cells.
+	 *
+	 * Every opening, a connected area of cells without adjacent mines, counts as one click and so does every other
+	 * safe cell that does not border an opening. It is computed when the mines are placed.
+	 */
+	int bbbv() const { return m_bbbv; }
+
+	/// Seed the mines were generated from, zero if they were placed explicitly.
+	uint64_t seed() const { return m_seed; }
+
+	int index(int x, int y) const { return y * m_width + x; }
+	int x(int cell) const { return cell % m_width; }
+	int y(int cell) const { return cell / m_width; }
+	bool contains(int x, int y) const { return x >= 0 && x < m_width && y >= 0 && y < m_height; }
+
+	/**
+	 * @brief Place the mines randomly.
+	 *
+	 * No mine is placed on the first clicked cell or in its vicinity, so the first click always opens a field of
+	 * empty cells. The same seed and first cell always produce the same mines on every platform.
+	 *
+	 * @param first The first clicked cell.
+	 * @param seed Seed of the random generator.
+	 */
+	void generate(int first, uint64_t seed);
+
+	/**
+	 * @brief Place the mines on the given cells.
+	 *
+	 * The number of mines of the field is set to the number of the given cells.
+	 *
+	 * @param mines Indices of the cells with a mine.
+	 */
+	void placeMines(std::span<const int> mines);
+
+	bool isMine(int cell) const { return m_cells[cell] & MINE_BIT; }
+	bool isRevealed(int cell) const { return m_cells[cell] & REVEALED_BIT; }
+	bool isFlagged(int cell) const { return m_cells[cell] & FLAG_BIT; }
+
+	/// Number of the mines around the cell or @c MINE if the cell holds a mine.
+	int adjacentMines(int cell) const { return isMine(cell) ? MINE : m_cells[cell] & COUNT_MASK; }
+
+	/**
+	 * @brief The cell as the player sees it.
+	 *
+	 * Once the game is over the unflagged mines are shown and the flags without a mine are marked wrong, the same
+	 * as the @c Board shows them.
+	 */
+	PackedTile packedTile(int cell) const;
+
+	/**
+	 * @brief All the cells as the player sees them, see @c packedTile.
+	 *
+	 * @param tiles Array of @c size tiles to be filled.
+	 */
+	void packTiles(std::span<PackedTile> tiles) const;
+
+	/**
+	 * @brief Reveal the cell.
+	 *
+	 * Cells without adjacent mines open their neighbours as well. Revealing a mine loses the game, revealing the
+	 * last safe cell wins it. Flagged and revealed cells are not changed.
+	 *
+	 * @return True if any cell was revealed.
+	 */
+	bool reveal(int cell);
+
+	/**
+	 * @brief Reveal the unflagged neighbours of a revealed number with the same number of flags around it.
+	 *
+	 * @return True if any cell was revealed.
+	 */
+	bool chord(int cell);
+
+	/**
+	 * @brief Flag or unflag the hidden cell.
+	 *
+	 * The game is won when all the mines and nothing else are flagged.
+	 *
+	 * @return True if the flag was changed.
+	 */
+	bool toggleFlag(int cell);
+
+	/**
+	 * @brief Copy of what the player sees, the revealed numbers without the mines and the flags.
+	 *
+	 * The view is used to analyse the hypothetical states of the game, see @c assume. The number of mines is kept,
+	 * the actions of the player are not meaningful on it.
+	 */
+	Minefield view() const;
+
+	/**
+	 * @brief Reveal the hidden cell of a view with the assumed number of the adjacent mines.
+	 *
+	 * No area is flooded, only the cell is revealed and recorded in @c changes.
+	 */
+	void assume(int cell, int adjacentMines);
+
+	/// Cells changed by the last action.
+	const std::vector<int> &changes() const { return m_changes; }
+
+	/// The cells in the internal form, one byte per cell, see @c restore.
+	std::span<const uint8_t> cells() const { return m_cells; }
+
+	/**
+	 * @brief Continue the game stored by @c cells.
+	 *
+	 * The mines, the revealed cells and the flags are taken as they are, the counters, the state and the 3BV are
+	 * derived from them in a single pass.
+	 *
+	 * @param cells The cells returned by @c cells of a field with the same dimensions.
+	 * @param seed Seed the mines were generated from.
+	 */
+	void restore(std::span<const uint8_t> cells, uint64_t seed);
+
+	/// Delta of the last action, its cells are empty if the action changed nothing.
+	Delta lastDelta() const;
+
+	/**
+	 * @brief Take the action back.
+	 *
+	 * Only the cells of the delta are touched, the changed cells are recorded in @c changes.
+	 *
+	 * @param delta Delta of the last action performed on the field, or of the last one not taken back yet.
+	 */
+	void undo(const Delta &delta);
+
+	/**
+	 * @brief Perform the action taken back by @c undo again.
+	 *
+	 * @param delta Delta of the last action taken back.
+	 */
+	void redo(const Delta &delta);
+
+	/// Number of the flags around the cell.
+	int adjacentFlags(int cell) const;
+
+	/// Call @c function with the index of every existing neighbour of the cell.
+	template <typename Function>
+	void forEachNeighbour(int cell, Function &&function) const
+	{
+		int cx = x(cell);
+		int cy = y(cell);
+		for (int ny = cy - 1; ny <= cy + 1; ny++) {
+			for (int nx = cx - 1; nx <= cx + 1; nx++) {
+				if ((nx != cx || ny != cy) && contains(nx, ny)) {
+					function(index(nx, ny));
+				}
+			}
+		}
+	}
+
+private:
+	static constexpr uint8_t COUNT_MASK = 0x0f;
+	static constexpr uint8_t MINE_BIT = 0x10;
+	static constexpr uint8_t REVEALED_BIT = 0x20;
+	static constexpr uint8_t FLAG_BIT = 0x40;
+
+	/// Reveal the cell and flood the empty area around it without clearing the @c m_changes.
+	void open(int cell);
+
+	/// Update the state after an action.
+	void checkWin();
+
+	/// Compute the 3BV by labelling the openings, linear in the number of cells.
+	int computeBbbv();
+
+	/// Flip the bit of the delta in its cells and update the counters, the same for both the directions.
+	void flip(const Delta &delta);
+
+private:
+	int m_width;
+	int m_height;
+	int m_numberOfMines;
+	int m_numberOfFlags;
+	int m_numberOfCorrectFlags;
+	int m_numberOfRevealed;
+	int m_bbbv;
+	bool m_initialized;
+	uint64_t m_seed;
+	State m_state;
+	/// State before the last action and whether it toggled a flag, the rest of its delta are the changes.
+	State m_lastState;
+	bool m_lastFlag;
+	std::vector<uint8_t> m_cells;
+	std::vector<int> m_changes;
+	/// Reused stack of the flood fill.
+	std::vector<int> m_stack;
+};
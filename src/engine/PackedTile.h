@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+
+/**
+ * @brief What the player sees on a cell, packed in one byte.
+ *
+ * The values are those of @c Icon::Ocupant with the hidden cell added, so the headless consumers of the field (the
+ * bots, the arena and the observers) and the rendered tiles use one encoding.
+ */
+enum class PackedTile : uint8_t
+{
+	Empty,
+	One,
+	Two,
+	Three,
+	Four,
+	Five,
+	Six,
+	Seven,
+	Eight,
+	Mine,
+	Flag,
+	WrongFlag,
+	Hidden,
+};
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @class TripleBuffer
+ * @brief Lock free hand over of the latest value from one writer thread to one reader thread.
+ *
+ * The writer fills the back buffer and publishes it, the reader takes the latest published buffer. Neither of them
+ * ever waits for the other one: the published buffers are exchanged by a single atomic swap of their index, so the
+ * writer can publish many values between two reads and the reader keeps the last one until a newer one is
+ * published. The buffers are reused, so a value holding containers does not allocate once they are large enough.
+ */
+template <typename T>
+class TripleBuffer
+{
+public:
+	TripleBuffer()
+		: m_buffers()
+		, m_back(0)
+		, m_middle(1)
+		, m_front(2)
+	{
+	}
+
+	/// Buffer of the writer to be filled and published.
+	T &back() { return m_buffers[m_back]; }
+
+	/// Index of the back buffer, the writer can keep its own state of every buffer.
+	size_t backIndex() const { return m_back; }
+
+	/// Hand the back buffer over to the reader, the back buffer is then one of the older values.
+	void publish()
+	{
+		m_back = m_middle.exchange(m_back | FRESH, std::memory_order_acq_rel) & INDEX;
+	}
+
+	/**
+	 * @brief The latest published value.
+	 *
+	 * The value stays valid and unchanged until the next call.
+	 */
+	const T &read()
+	{
+		if (m_middle.load(std::memory_order_relaxed) & FRESH) {
+			m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & INDEX;
+		}
+		return m_buffers[m_front];
+	}
+
+private:
+	/// The middle buffer was published and not read yet.
+	static constexpr uint8_t FRESH = 0x4;
+	static constexpr uint8_t INDEX = 0x3;
+
+	std::array<T, 3> m_buffers;
+	/// Index of the buffer of the writer.
+	uint8_t m_back;
+	/// Index of the buffer exchanged by the writer and the reader, with the @c FRESH bit.
+	std::atomic<uint8_t> m_middle;
+	/// Index of the buffer of the reader.
+	uint8_t m_front;
+};
@@ -0,0 +1,101 @@
+#include "Generator.h"
+
+#include "Minefield.h"
+#include "Solver.h"
+
+#include <atomic>
+
+Generator::Generator(int width, int height, int numberOfMines, Scheduler *scheduler)
+	: m_width(width)
+	, m_height(height)
+	, m_numberOfMines(numberOfMines)
+	, m_scheduler(scheduler)
+{
+}
+
+Generator::Layout Generator::generate(int first, uint64_t seed, std::chrono::milliseconds timeout,
+	const Requirements &requirements) const
+{
+	auto deadline = std::chrono::steady_clock::now() + timeout;
+	std::atomic<bool> found = false;
+	std::atomic<uint64_t> result = seed;
+	std::atomic<uint64_t> attempts = 0;
+
+	// One long task per worker, every task tries its own subsequence of the candidates.
+	size_t tasks = m_scheduler != nullptr ? m_scheduler->size() : 1;
+	auto search = [&](size_t task) {
+		for (uint64_t n = task; !found && std::chrono::steady_clock::now() < deadline; n += tasks) {
+			attempts++;
+			auto current = candidate(seed, n);
+			if (accepts(first, current, requirements) && !found.exchange(true)) {
+				result = current;
+			}
+		}
+	};
+	if (m_scheduler != nullptr) {
+		m_scheduler->parallelFor(tasks, 1, search);
+	}
+	else {
+		search(0);
+	}
+
+	Minefield field(m_width, m_height, m_numberOfMines);
+	field.generate(first, result);
+	return { result, found, field.bbbv(), attempts };
+}
+
+bool Generator::accepts(int first, uint64_t seed, const Requirements &requirements) const
+{
+	Minefield field(m_width, m_height, m_numberOfMines);
+	field.generate(first, seed);
+
+	if (field.bbbv() < requirements.minimumBbbv || field.bbbv() > requirements.maximumBbbv) {
+		return false;
+	}
+
+	return !requirements.noGuess || isNoGuess(field, first);
+}
+
+bool Generator::isNoGuess(int first, uint64_t seed) const
+{
+	Minefield field(m_width, m_height, m_numberOfMines);
+	field.generate(first, seed);
+	return isNoGuess(field, first);
+}
+
+bool Generator::isNoGuess(Minefield &field, int first)
+{
+	Solver solver(field);
+
+	field.reveal(first);
+	solver.update(field.changes());
+
+	while (field.state() == Minefield::State::Playing) {
+		bool progress = false;
+		for (auto [cell, mine] : solver.deductions()) {
+			if (!mine && field.reveal(cell)) {
+				solver.update(field.changes());
+				progress = true;
+			}
+		}
+
+		if (!progress) {
+			return false;
+		}
+	}
+
+	return field.state() == Minefield::State::Win;
+}
+
+uint64_t Generator::candidate(uint64_t seed, uint64_t n)
+{
+	if (n == 0) {
+		return seed;
+	}
+
+	// SplitMix64 of the shifted seed, the neighbouring candidates get unrelated seeds.
+	uint64_t z = seed + n * 0x9e3779b97f4a7c15ull;
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+	return z ^ (z >> 31);
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "Scheduler.h"
+
+#include <chrono>
+#include <cstdint>
+#include <limits>
+
+class Minefield;
+
+/**
+ * @class Generator
+ * @brief Search for the mine layouts meeting the given requirements.
+ *
+ * A layout is identified by the seed passed to @c Minefield::generate, so the generator only searches for a good
+ * seed and the board is placed as usual. A candidate can be required to have its 3BV in a band, so the competitive
+ * boards are comparable, and to be solvable without guessing, i.e. the @c Solver clears the whole board from the
+ * first click using only deductions. The cheap 3BV check runs first.
+ *
+ * The candidates are tried by the workers of a @c Scheduler at once, the first accepted one wins and stops the
+ * others.
+ */
+class Generator
+{
+public:
+	/// Requirements of the accepted layouts.
+	struct Requirements
+	{
+		/// The layout has to be solvable without guessing.
+		bool noGuess = true;
+		/// Inclusive band of the 3BV of the layout.
+		int minimumBbbv = 0;
+		int maximumBbbv = std::numeric_limits<int>::max();
+	};
+
+	/// Result of the search.
+	struct Layout
+	{
+		/// Seed of the layout to be passed to @c Minefield::generate.
+		uint64_t seed;
+		/// False if the search timed out and the layout of the original seed is returned.
+		bool accepted;
+		/// 3BV of the layout.
+		int bbbv;
+		/// Number of the candidates tried by all the workers.
+		uint64_t attempts;
+	};
+
+	/**
+	 * @brief Create the generator of the boards with the given dimensions.
+	 *
+	 * @param width The number of cells in the horizontal direction.
+	 * @param height The number of cells in the vertical direction.
+	 * @param numberOfMines Number of mines on the board.
+	 * @param scheduler Workers trying the candidates, nothing to try them on the calling thread only. The scheduler
+	 *        has to outlive the generator.
+	 */
+	explicit Generator(int width, int height, int numberOfMines, Scheduler *scheduler = nullptr);
+
+	/**
+	 * @brief Find a layout meeting the requirements.
+	 *
+	 * The same seed always produces the same sequence of the candidates, the one returned is the first accepted by
+	 * any of the workers.
+	 *
+	 * @param first The first clicked cell.
+	 * @param seed Seed the candidates are derived from.
+	 * @param timeout Time after which the search gives up and returns the layout of the @c seed.
+	 * @param requirements Requirements of the layout.
+	 * @return The found layout.
+	 */
+	Layout generate(int first, uint64_t seed, std::chrono::milliseconds timeout,
+		const Requirements &requirements) const;
+
+	/// Find a layout solvable without guessing.
+	Layout generate(int first, uint64_t seed, std::chrono::milliseconds timeout) const
+	{
+		return generate(first, seed, timeout, Requirements{});
+	}
+
+	/**
+	 * @brief Check if the layout of the seed meets the requirements.
+	 *
+	 * @param first The first clicked cell.
+	 * @param seed Seed of the layout.
+	 * @param requirements Requirements of the layout.
+	 * @return True if the layout is accepted.
+	 */
+	bool accepts(int first, uint64_t seed, const Requirements &requirements) const;
+
+	/**
+	 * @brief Check if the layout of the seed can be solved without guessing.
+	 *
+	 * @param first The first clicked cell.
+	 * @param seed Seed of the layout.
+	 * @return True if the solver reveals all the safe cells from the first click.
+	 */
+	bool isNoGuess(int first, uint64_t seed) const;
+
+	/// Seed of the n-th candidate derived from the seed, the candidate 0 is the seed itself.
+	static uint64_t candidate(uint64_t seed, uint64_t n);
+
+private:
+	/// True if the solver reveals all the safe cells of the generated field from the first click.
+	static bool isNoGuess(Minefield &field, int first);
+
+private:
+	int m_width;
+	int m_height;
+	int m_numberOfMines;
+	Scheduler *m_scheduler;
+};
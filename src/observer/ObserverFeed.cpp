@@ -0,0 +1,133 @@
+#include "ObserverFeed.h"
+
+#include "Minefield.h"
+
+#include <algorithm>
+#include <bit>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+/// The tiles and the ring start on their own cache lines.
+#define CACHE_LINE 64
+/// The index of a cell has 24 bits in a delta.
+#define MAX_CELLS (1 << 24)
+
+namespace
+{
+
+size_t align(size_t offset)
+{
+	return (offset + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE;
+}
+
+}
+
+ObserverFeed::ObserverFeed(const std::string &name, uint32_t maxCells, uint32_t ringCapacity)
+	: m_name(name)
+	, m_data(nullptr)
+	, m_size(0)
+	, m_header(nullptr)
+	, m_tiles(nullptr)
+	, m_ring(nullptr)
+	, m_head(0)
+{
+	maxCells = std::min<uint32_t>(maxCells, MAX_CELLS);
+	ringCapacity = std::bit_ceil(std::max<uint32_t>(ringCapacity, 1));
+	size_t tilesOffset = align(sizeof(ObserverHeader));
+	size_t ringOffset = align(tilesOffset + maxCells);
+	size_t size = ringOffset + ringCapacity * sizeof(uint64_t);
+
+	// The segment of a game that did not exit cleanly is replaced, its readers keep the old one until they reopen.
+	::shm_unlink(m_name.c_str());
+	int fd = ::shm_open(m_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+	if (fd < 0) {
+		return;
+	}
+	void *data = ::ftruncate(fd, size) == 0 ? ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)
+		: MAP_FAILED;
+	::close(fd);
+	if (data == MAP_FAILED) {
+		::shm_unlink(m_name.c_str());
+		return;
+	}
+
+	// The new segment is zeroed, so the board is empty and the snapshot is consistent.
+	m_data = data;
+	m_size = size;
+	m_header = static_cast<ObserverHeader *>(data);
+	m_tiles = static_cast<uint8_t *>(data) + tilesOffset;
+	m_ring = reinterpret_cast<uint64_t *>(static_cast<uint8_t *>(data) + ringOffset);
+
+	m_header->version = OBSERVER_VERSION;
+	m_header->maxCells = maxCells;
+	m_header->ringCapacity = ringCapacity;
+	m_header->tilesOffset = tilesOffset;
+	m_header->ringOffset = ringOffset;
+	m_header->alive = 1;
+	m_header->game = UINT64_MAX;
+	observerStore(m_header->magic, OBSERVER_MAGIC, std::memory_order_release);
+}
+
+ObserverFeed::~ObserverFeed()
+{
+	if (!m_data) {
+		return;
+	}
+	observerStore(m_header->alive, 0u, std::memory_order_release);
+	::munmap(m_data, m_size);
+	::shm_unlink(m_name.c_str());
+}
+
+void ObserverFeed::publish(uint64_t game, const Minefield &field, std::span<const int> cells)
+{
+	if (!m_header || field.size() > static_cast<int>(m_header->maxCells)) {
+		return;
+	}
+
+	auto version = m_header->snapshotVersion;
+	observerStore(m_header->snapshotVersion, version + 1);
+	// The odd version is visible before any change of the snapshot.
+	std::atomic_thread_fence(std::memory_order_release);
+
+	if (game != m_header->game) {
+		observerStore(m_header->game, game);
+		observerStore(m_header->width, static_cast<uint32_t>(field.width()));
+		observerStore(m_header->height, static_cast<uint32_t>(field.height()));
+		observerStore(m_header->numberOfMines, static_cast<uint32_t>(field.numberOfMines()));
+		push(0, OBSERVER_RESET);
+		for (int cell = 0; cell < field.size(); cell++) {
+			observerStore(m_tiles[cell], static_cast<uint8_t>(field.packedTile(cell)));
+		}
+	}
+	else {
+		for (int cell : cells) {
+			update(field, cell);
+		}
+	}
+	// The mines are counted again once they are placed.
+	observerStore(m_header->numberOfMines, static_cast<uint32_t>(field.numberOfMines()));
+	observerStore(m_header->numberOfFlags, static_cast<uint32_t>(field.numberOfFlags()));
+	observerStore(m_header->state, static_cast<uint32_t>(field.state()));
+	observerStore(m_header->snapshotHead, m_head);
+
+	observerStore(m_header->head, m_head, std::memory_order_release);
+	observerStore(m_header->snapshotVersion, version + 2, std::memory_order_release);
+}
+
+void ObserverFeed::push(uint32_t cell, uint8_t tile)
+{
+	// The slot is published by the release of the head.
+	observerStore(m_ring[m_head & (m_header->ringCapacity - 1)], observerDelta(m_head, cell, tile));
+	m_head++;
+}
+
+void ObserverFeed::update(const Minefield &field, int cell)
+{
+	auto tile = static_cast<uint8_t>(field.packedTile(cell));
+	if (m_tiles[cell] != tile) {
+		observerStore(m_tiles[cell], tile);
+		push(cell, tile);
+	}
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "ObserverLayout.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+
+class Minefield;
+
+/**
+ * @class ObserverFeed
+ * @brief Board of the running game published into POSIX shared memory, see @c ObserverLayout.h.
+ *
+ * The external readers, e.g. a streaming overlay, map the segment and follow the game by its snapshot and its ring of
+ * deltas, see @c ObserverReader. Publishing takes only the changed cells and never waits for the readers, so any
+ * number of them does not slow the game down. There is one writer, the thread of the game.
+ *
+ * The segment is created anew by the constructor and removed by the destructor. A reader of the segment of a game that
+ * exited sees it is not alive anymore.
+ */
+class ObserverFeed
+{
+public:
+	/**
+	 * @brief Create the segment.
+	 *
+	 * If the segment can not be created, the object is created but @c isOpen returns false.
+	 *
+	 * @param name Name of the segment, e.g. "/minesweeper-board".
+	 * @param maxCells Largest board published.
+	 * @param ringCapacity Number of the deltas kept for the readers, rounded up to a power of two.
+	 */
+	explicit ObserverFeed(const std::string &name, uint32_t maxCells = 1 << 16, uint32_t ringCapacity = 1 << 16);
+	ObserverFeed(const ObserverFeed &) = delete;
+	ObserverFeed &operator=(const ObserverFeed &) = delete;
+	~ObserverFeed();
+
+	/// True if the segment was successfully created.
+	bool isOpen() const { return m_header != nullptr; }
+
+	/**
+	 * @brief Publish the changes of the game.
+	 *
+	 * A new game number publishes the whole board and starts the deltas over with an @c OBSERVER_RESET, the cells are
+	 * then not needed.
+	 *
+	 * @param game Number of the game.
+	 * @param field The game.
+	 * @param cells The cells changed since the last call, a cell may be repeated.
+	 */
+	void publish(uint64_t game, const Minefield &field, std::span<const int> cells);
+
+private:
+	/// Append the delta to the ring, it is visible to the readers once the head is stored.
+	void push(uint32_t cell, uint8_t tile);
+
+	/// Update the tile of the snapshot and append its delta if it changed.
+	void update(const Minefield &field, int cell);
+
+private:
+	std::string m_name;
+	void *m_data;
+	size_t m_size;
+	ObserverHeader *m_header;
+	uint8_t *m_tiles;
+	uint64_t *m_ring;
+	/// Sequence number of the next delta, the head the readers see lags behind until the end of @c publish.
+	uint64_t m_head;
+};
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+
+/**
+ * @file ObserverLayout.h
+ * @brief Layout of the shared memory segment the game publishes its board into, see @c ObserverFeed.
+ *
+ * The segment starts with an @c ObserverHeader followed by the snapshot of the tiles, one @c PackedTile per cell in the
+ * rows from the top, and by the ring of the deltas, one @c uint64_t per delta. Their offsets are in the header. All
+ * the fields are accessed atomically, the segment is plain data so the readers need not be written in C++.
+ *
+ * The snapshot is guarded by a sequence lock: the game makes @c ObserverHeader::snapshotVersion odd before it changes
+ * the snapshot and even again afterwards, a reader retries the copy of the snapshot until it reads the same even
+ * version before and after it.
+ *
+ * Every change of a cell is also appended to the ring as a delta with its sequence number. The game writes the ring
+ * without waiting for the readers, so a reader falling behind by more than the capacity of the ring loses the deltas
+ * and takes the snapshot again. A delta is one word: the low 32 bits of its sequence number, the index of the cell and
+ * the tile, so a reader tells an overwritten delta by the sequence number without any lock.
+ */
+
+constexpr uint32_t OBSERVER_MAGIC = 0x4d534f42;
+constexpr uint32_t OBSERVER_VERSION = 1;
+
+/// Tile of the delta starting a new game, the readers take the snapshot again.
+constexpr uint8_t OBSERVER_RESET = 0xff;
+
+struct ObserverHeader
+{
+	/// @c OBSERVER_MAGIC, written last once the segment is ready.
+	uint32_t magic;
+	uint32_t version;
+	/// Capacity of the snapshot, a larger board is not published.
+	uint32_t maxCells;
+	/// Capacity of the ring, a power of two.
+	uint32_t ringCapacity;
+	uint64_t tilesOffset;
+	uint64_t ringOffset;
+	/// Non-zero while the game publishes into the segment.
+	uint32_t alive;
+	uint32_t reserved;
+
+	/// Sequence lock of the snapshot, odd while the game changes it.
+	uint64_t snapshotVersion;
+	/// Sequence number of the next delta, the number of the deltas ever written.
+	uint64_t head;
+	/// Sequence number of the first delta not contained in the snapshot.
+	uint64_t snapshotHead;
+
+	/// Number of the game, a new game starts with an @c OBSERVER_RESET delta.
+	uint64_t game;
+	uint32_t width;
+	uint32_t height;
+	uint32_t numberOfMines;
+	uint32_t numberOfFlags;
+	/// @c Minefield::State of the game.
+	uint32_t state;
+	uint32_t padding;
+};
+
+static_assert(std::is_standard_layout_v<ObserverHeader> && std::is_trivially_copyable_v<ObserverHeader>);
+static_assert(std::atomic_ref<uint64_t>::is_always_lock_free && std::atomic_ref<uint8_t>::is_always_lock_free,
+	"The readers in other processes rely on the lock free atomics");
+
+constexpr uint64_t observerDelta(uint64_t sequence, uint32_t cell, uint8_t tile)
+{
+	return sequence << 32 | static_cast<uint64_t>(cell) << 8 | tile;
+}
+
+constexpr uint32_t observerSequence(uint64_t delta) { return delta >> 32; }
+constexpr uint32_t observerCell(uint64_t delta) { return (delta >> 8) & 0xffffff; }
+constexpr uint8_t observerTile(uint64_t delta) { return delta & 0xff; }
+
+/// Atomic access to a field of the shared segment, the segment may be mapped read only.
+template <typename T>
+T observerLoad(const T &field, std::memory_order order = std::memory_order_relaxed)
+{
+	return std::atomic_ref<T>(const_cast<T &>(field)).load(order);
+}
+
+template <typename T>
+void observerStore(T &field, T value, std::memory_order order = std::memory_order_relaxed)
+{
+	std::atomic_ref<T>(field).store(value, order);
+}
@@ -0,0 +1,89 @@
+#include "ObserverReader.h"
+
+#include <algorithm>
+#include <bit>
+
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+ObserverReader::ObserverReader(const std::string &name)
+	: m_data(nullptr)
+	, m_size(0)
+	, m_header(nullptr)
+	, m_tiles(nullptr)
+	, m_ring(nullptr)
+	, m_mask(0)
+	, m_next(0)
+{
+	int fd = ::shm_open(name.c_str(), O_RDONLY, 0);
+	if (fd < 0) {
+		return;
+	}
+	struct stat status;
+	void *data = ::fstat(fd, &status) == 0 && static_cast<size_t>(status.st_size) >= sizeof(ObserverHeader)
+		? ::mmap(nullptr, status.st_size, PROT_READ, MAP_SHARED, fd, 0)
+		: MAP_FAILED;
+	::close(fd);
+	if (data == MAP_FAILED) {
+		return;
+	}
+
+	// The segment is trusted only as far as its header fits in it.
+	size_t size = status.st_size;
+	const auto *header = static_cast<const ObserverHeader *>(data);
+	if (observerLoad(header->magic, std::memory_order_acquire) != OBSERVER_MAGIC
+		|| header->version != OBSERVER_VERSION || !std::has_single_bit(header->ringCapacity)
+		|| header->tilesOffset + header->maxCells > size
+		|| header->ringOffset + header->ringCapacity * sizeof(uint64_t) > size)
+	{
+		::munmap(data, size);
+		return;
+	}
+
+	m_data = data;
+	m_size = size;
+	m_header = header;
+	m_tiles = static_cast<const uint8_t *>(data) + header->tilesOffset;
+	m_ring = reinterpret_cast<const uint64_t *>(static_cast<const uint8_t *>(data) + header->ringOffset);
+	m_mask = header->ringCapacity - 1;
+}
+
+ObserverReader::~ObserverReader()
+{
+	if (m_data) {
+		::munmap(const_cast<void *>(m_data), m_size);
+	}
+}
+
+void ObserverReader::snapshot(Snapshot &snapshot)
+{
+	while (true) {
+		auto version = observerLoad(m_header->snapshotVersion, std::memory_order_acquire);
+		if (version % 2 == 0) {
+			snapshot.game = observerLoad(m_header->game);
+			snapshot.width = observerLoad(m_header->width);
+			snapshot.height = observerLoad(m_header->height);
+			snapshot.numberOfMines = observerLoad(m_header->numberOfMines);
+			snapshot.numberOfFlags = observerLoad(m_header->numberOfFlags);
+			snapshot.state = observerLoad(m_header->state);
+			auto head = observerLoad(m_header->snapshotHead);
+
+			// A torn size is caught by the version below, it only must not overrun the tiles.
+			size_t cells = std::min<size_t>(static_cast<size_t>(snapshot.width) * snapshot.height, m_header->maxCells);
+			snapshot.tiles.resize(cells);
+			for (size_t cell = 0; cell < cells; cell++) {
+				snapshot.tiles[cell] = static_cast<PackedTile>(observerLoad(m_tiles[cell]));
+			}
+
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (observerLoad(m_header->snapshotVersion) == version) {
+				m_next = head;
+				return;
+			}
+		}
+		::sched_yield();
+	}
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "ObserverLayout.h"
+#include "PackedTile.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @class ObserverReader
+ * @brief Follows the board published by an @c ObserverFeed of a running game.
+ *
+ * The reader maps the segment read only, so it can not disturb the game. It takes a consistent @c Snapshot once and
+ * then reads the deltas in place as the game appends them. When the reader falls behind by more than the ring holds
+ * or a new game starts, it takes the snapshot again.
+ */
+class ObserverReader
+{
+public:
+	/// Copy of the board at a moment.
+	struct Snapshot
+	{
+		uint64_t game = 0;
+		int width = 0;
+		int height = 0;
+		int numberOfMines = 0;
+		int numberOfFlags = 0;
+		/// @c Minefield::State of the game.
+		int state = 0;
+		std::vector<PackedTile> tiles;
+	};
+
+	/**
+	 * @brief Map the segment.
+	 *
+	 * If the segment does not exist or is not a feed of this version, the object is created but @c isOpen returns
+	 * false.
+	 *
+	 * @param name Name of the segment given to the @c ObserverFeed.
+	 */
+	explicit ObserverReader(const std::string &name);
+	ObserverReader(const ObserverReader &) = delete;
+	ObserverReader &operator=(const ObserverReader &) = delete;
+	~ObserverReader();
+
+	/// True if the segment was successfully mapped.
+	bool isOpen() const { return m_header != nullptr; }
+
+	/// False once the game stopped publishing, a new game process creates a new segment to be opened.
+	bool alive() const { return observerLoad(m_header->alive, std::memory_order_acquire) != 0; }
+
+	/**
+	 * @brief Copy the board and follow the deltas after it.
+	 *
+	 * The copy is retried while the game changes the board, it takes about as long as copying the tiles.
+	 */
+	void snapshot(Snapshot &snapshot);
+
+	/**
+	 * @brief Pass the deltas published since the last call to the function.
+	 *
+	 * @param function Called with the index of the cell and its @c PackedTile for every delta in order.
+	 * @return False if the reader fell behind or a new game started, the deltas are then not complete and the snapshot
+	 * is to be taken again.
+	 */
+	template <typename Function>
+	bool poll(Function &&function)
+	{
+		uint64_t head = observerLoad(m_header->head, std::memory_order_acquire);
+		if (head - m_next > m_mask + 1) {
+			return false;
+		}
+
+		for (; m_next < head; m_next++) {
+			uint64_t delta = observerLoad(m_ring[m_next & m_mask], std::memory_order_acquire);
+			// The game overwrote the delta while it was read.
+			if (observerSequence(delta) != static_cast<uint32_t>(m_next)) {
+				return false;
+			}
+			if (observerTile(delta) == OBSERVER_RESET) {
+				m_next++;
+				return false;
+			}
+			function(static_cast<int>(observerCell(delta)), static_cast<PackedTile>(observerTile(delta)));
+		}
+		return true;
+	}
+
+	/// The latest @c Minefield::State of the game, changes of the state are not deltas.
+	int state() const { return observerLoad(m_header->state, std::memory_order_acquire); }
+
+	/// The latest number of the flags of the game.
+	int numberOfFlags() const { return observerLoad(m_header->numberOfFlags, std::memory_order_acquire); }
+
+	/// Sequence number of the next delta to be read.
+	uint64_t next() const { return m_next; }
+
+private:
+	const void *m_data;
+	size_t m_size;
+	const ObserverHeader *m_header;
+	const uint8_t *m_tiles;
+	const uint64_t *m_ring;
+	uint64_t m_mask;
+	uint64_t m_next;
+};
@@ -0,0 +1,114 @@
+#include "BotPlugin.h"
+
+#include "Minefield.h"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+#include <dlfcn.h>
+
+// The tiles are passed to the bots as they are packed by the engine.
+static_assert(MINESWEEPER_TILE_MINE == static_cast<int>(PackedTile::Mine));
+static_assert(MINESWEEPER_TILE_FLAG == static_cast<int>(PackedTile::Flag));
+static_assert(MINESWEEPER_TILE_WRONG_FLAG == static_cast<int>(PackedTile::WrongFlag));
+static_assert(MINESWEEPER_TILE_HIDDEN == static_cast<int>(PackedTile::Hidden));
+static_assert(sizeof(PackedTile) == sizeof(uint8_t));
+
+/// The functions of the first version, a bot can not be used without them.
+#define REQUIRED_API_SIZE (offsetof(MinesweeperBot, act) + sizeof(MinesweeperBot::act))
+
+void BotBatch::clear()
+{
+	m_games.clear();
+	m_tiles.clear();
+}
+
+void BotBatch::add(uint32_t game, const Minefield &field)
+{
+	MinesweeperObservation observation {};
+	observation.game = game;
+	observation.width = field.width();
+	observation.height = field.height();
+	observation.numberOfMines = field.numberOfMines();
+	observation.numberOfFlags = field.numberOfFlags();
+	observation.tiles = m_tiles.size();
+	m_games.push_back(observation);
+
+	m_tiles.resize(m_tiles.size() + field.size());
+	field.packTiles(std::span(m_tiles).subspan(observation.tiles));
+}
+
+BotPlugin::Bot::Bot(const MinesweeperBot *api, void *instance)
+	: m_api(api)
+	, m_instance(instance)
+{
+}
+
+BotPlugin::Bot::Bot(Bot &&other) noexcept
+	: m_api(other.m_api)
+	, m_instance(std::exchange(other.m_instance, nullptr))
+	, m_actions(std::move(other.m_actions))
+{
+}
+
+BotPlugin::Bot &BotPlugin::Bot::operator=(Bot &&other) noexcept
+{
+	std::swap(m_api, other.m_api);
+	std::swap(m_instance, other.m_instance);
+	std::swap(m_actions, other.m_actions);
+	return *this;
+}
+
+BotPlugin::Bot::~Bot()
+{
+	if (m_instance) {
+		m_api->destroy(m_instance);
+	}
+}
+
+std::span<const MinesweeperAction> BotPlugin::Bot::act(const BotBatch &batch)
+{
+	// Every cell can be acted on once, the bot does not have to check the space left for its actions.
+	auto capacity = std::min<size_t>(std::max<size_t>(batch.tiles().size(), 1), std::numeric_limits<uint32_t>::max());
+	if (m_actions.size() < capacity) {
+		m_actions.resize(capacity);
+	}
+	auto tiles = reinterpret_cast<const uint8_t *>(batch.tiles().data());
+	uint32_t count = m_api->act(m_instance, batch.games().data(), batch.games().size(), tiles, m_actions.data(),
+		capacity);
+	return { m_actions.data(), std::min<size_t>(count, capacity) };
+}
+
+BotPlugin::BotPlugin(const std::string &path)
+	: m_library(dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL))
+	, m_api(nullptr)
+{
+	if (!m_library) {
+		throw std::runtime_error("Could not load the bot " + path + ": " + dlerror());
+	}
+
+	auto entry = reinterpret_cast<MinesweeperBotEntry>(dlsym(m_library, MINESWEEPER_BOT_ENTRY));
+	m_api = entry ? entry(MINESWEEPER_BOT_ABI_VERSION) : nullptr;
+	if (!m_api || MINESWEEPER_BOT_ABI_MAJOR(m_api->abiVersion) != MINESWEEPER_BOT_ABI_MAJOR(MINESWEEPER_BOT_ABI_VERSION)
+		|| m_api->size < REQUIRED_API_SIZE || !m_api->create || !m_api->destroy || !m_api->act)
+	{
+		dlclose(m_library);
+		throw std::runtime_error("The bot " + path + " does not support the ABI version of the host");
+	}
+}
+
+BotPlugin::~BotPlugin()
+{
+	dlclose(m_library);
+}
+
+BotPlugin::Bot BotPlugin::create(const std::string &options) const
+{
+	void *instance = m_api->create(options.empty() ? nullptr : options.c_str());
+	if (!instance) {
+		throw std::runtime_error("The bot " + std::string(name()) + " could not be created");
+	}
+	return Bot(m_api, instance);
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "MinesweeperBot.h"
+#include "PackedTile.h"
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class Minefield;
+
+/**
+ * @class BotBatch
+ * @brief Observations of many games passed to a bot in one call, see @c MinesweeperBot::act.
+ *
+ * The tiles of all the games are packed one after another into a single array. The arrays are reused by the next
+ * batch, so a batch of the same games does not allocate.
+ */
+class BotBatch
+{
+public:
+	/// Forget the games, keeping the memory.
+	void clear();
+
+	/**
+	 * @brief Add the game as the player sees it.
+	 *
+	 * @param game Number of the game the actions of the bot refer to.
+	 * @param field The game.
+	 */
+	void add(uint32_t game, const Minefield &field);
+
+	bool empty() const { return m_games.empty(); }
+
+	std::span<const MinesweeperObservation> games() const { return m_games; }
+	std::span<const PackedTile> tiles() const { return m_tiles; }
+
+private:
+	std::vector<MinesweeperObservation> m_games;
+	std::vector<PackedTile> m_tiles;
+};
+
+/**
+ * @class BotPlugin
+ * @brief Bot loaded from a shared library through the C interface of @c MinesweeperBot.h.
+ *
+ * The library stays loaded as long as the plugin exists, so the plugin outlives all of its @c Bot instances.
+ */
+class BotPlugin
+{
+public:
+	/**
+	 * @class Bot
+	 * @brief Instance of the bot, used by one thread at a time.
+	 */
+	class Bot
+	{
+	public:
+		Bot(Bot &&other) noexcept;
+		Bot &operator=(Bot &&other) noexcept;
+		Bot(const Bot &) = delete;
+		Bot &operator=(const Bot &) = delete;
+		~Bot();
+
+		/**
+		 * @brief Let the bot choose the actions in the games of the batch.
+		 *
+		 * @param batch The games in play.
+		 * @return The actions of the bot, valid until the next call.
+		 */
+		std::span<const MinesweeperAction> act(const BotBatch &batch);
+
+	private:
+		friend class BotPlugin;
+
+		Bot(const MinesweeperBot *api, void *instance);
+
+		const MinesweeperBot *m_api;
+		void *m_instance;
+		/// Array the bot writes its actions to, it only grows.
+		std::vector<MinesweeperAction> m_actions;
+	};
+
+	/**
+	 * @brief Load the bot.
+	 *
+	 * @param path Path of the shared library.
+	 * @throws std::runtime_error If the library can not be loaded, does not export the entry point or does not support
+	 * the ABI version of the host.
+	 */
+	explicit BotPlugin(const std::string &path);
+	BotPlugin(const BotPlugin &) = delete;
+	BotPlugin &operator=(const BotPlugin &) = delete;
+	~BotPlugin();
+
+	/// Name the bot gives itself.
+	std::string_view name() const { return m_api->name ? m_api->name : ""; }
+
+	/**
+	 * @brief Create an instance of the bot.
+	 *
+	 * @param options Options of the bot, passed to it as they are.
+	 * @throws std::runtime_error If the bot fails to create the instance.
+	 */
+	Bot create(const std::string &options) const;
+
+private:
+	void *m_library;
+	const MinesweeperBot *m_api;
+};
@@ -0,0 +1,122 @@
+#ifndef MINESWEEPER_BOT_H
+#define MINESWEEPER_BOT_H
+
+/**
+ * @file MinesweeperBot.h
+ * @brief C interface of the bots loaded as shared libraries, see @c BotPlugin.
+ *
+ * A bot is a shared library exporting the function @c MINESWEEPER_BOT_ENTRY of the type @c MinesweeperBotEntry. It is
+ * given the ABI version of the host and returns its @c MinesweeperBot, or NULL if it does not support the version.
+ * The header is plain C, so the bots can be written in any language and built by any compiler with the C calling
+ * convention.
+ *
+ * The host plays many games at once. It passes all the games in play in one call of @c MinesweeperBot::act, every
+ * game is described by a @c MinesweeperObservation and its cells are a run of the flat array of the tiles. The bot
+ * answers with any number of actions for any of the games, so one call replaces thousands of calls per move. The
+ * arrays belong to the host and are valid only during the call.
+ *
+ * Every tile is one byte, the same encoding as the @c PackedTile of the engine and the @c Icon::Ocupant of the
+ * rendered board, see @c MINESWEEPER_TILE_EMPTY and the following values.
+ *
+ * Compatibility: the major version changes with any change of the existing structures and functions, the host
+ * refuses a bot of another major version. A new function is appended to @c MinesweeperBot, so a bot built against an
+ * older header still works, the host tells the functions the bot knows by @c MinesweeperBot::size.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Version of this header, the major version in the high 16 bits and the minor version in the low 16 bits. */
+#define MINESWEEPER_BOT_ABI_VERSION 0x00010000u
+#define MINESWEEPER_BOT_ABI_MAJOR(version) ((version) >> 16)
+
+/** Name of the exported entry point. */
+#define MINESWEEPER_BOT_ENTRY "minesweeper_bot"
+
+/** Tiles 0 to 8 are the revealed cells with their number of the adjacent mines. */
+#define MINESWEEPER_TILE_EMPTY 0
+#define MINESWEEPER_TILE_MINE 9
+#define MINESWEEPER_TILE_FLAG 10
+#define MINESWEEPER_TILE_WRONG_FLAG 11
+#define MINESWEEPER_TILE_HIDDEN 12
+
+/** Types of the actions, the same as @c Replay::Action. */
+#define MINESWEEPER_ACTION_REVEAL 0
+#define MINESWEEPER_ACTION_FLAG 1
+#define MINESWEEPER_ACTION_CHORD 2
+
+/** One game in play. */
+typedef struct MinesweeperObservation
+{
+	/** Number of the game, unique during the life of the bot. */
+	uint32_t game;
+	uint16_t width;
+	uint16_t height;
+	uint32_t numberOfMines;
+	uint32_t numberOfFlags;
+	/** Index of the first tile of the game in the array of the tiles, the tiles are in the rows from the top. */
+	uint64_t tiles;
+} MinesweeperObservation;
+
+/** One action of the bot. */
+typedef struct MinesweeperAction
+{
+	/** Number of the game of the observation. */
+	uint32_t game;
+	/** Index of the cell, y * width + x. */
+	uint32_t cell;
+	/** @c MINESWEEPER_ACTION_REVEAL, @c MINESWEEPER_ACTION_FLAG or @c MINESWEEPER_ACTION_CHORD. */
+	uint8_t type;
+	uint8_t reserved[3];
+} MinesweeperAction;
+
+typedef struct MinesweeperBot
+{
+	/** @c MINESWEEPER_BOT_ABI_VERSION the bot was built with. */
+	uint32_t abiVersion;
+	/** Size of this structure in the header the bot was built with. */
+	uint32_t size;
+	/** Name of the bot shown by the host. */
+	const char *name;
+
+	/**
+	 * Create an instance of the bot, NULL on failure.
+	 *
+	 * The host may create several instances and use them from different threads, one instance is used by one thread
+	 * at a time. The options are given by the user of the host, NULL if there are none.
+	 */
+	void *(*create)(const char *options);
+
+	/** Destroy the instance. */
+	void (*destroy)(void *bot);
+
+	/**
+	 * Choose the actions in the games.
+	 *
+	 * An action without any effect is ignored. A game the bot gives no action with any effect for in several calls is
+	 * given up by the host.
+	 *
+	 * @param bot The instance.
+	 * @param games The games in play.
+	 * @param count Number of the games.
+	 * @param tiles Tiles of all the games.
+	 * @param actions Array to be filled with the actions, performed by the host in its order.
+	 * @param capacity Size of the array of the actions, at least the number of the tiles of all the games.
+	 * @return Number of the actions written.
+	 */
+	uint32_t (*act)(void *bot, const MinesweeperObservation *games, uint32_t count, const uint8_t *tiles,
+		MinesweeperAction *actions, uint32_t capacity);
+} MinesweeperBot;
+
+/** Type of the entry point, given @c MINESWEEPER_BOT_ABI_VERSION of the host. */
+typedef const MinesweeperBot *(*MinesweeperBotEntry)(uint32_t abiVersion);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
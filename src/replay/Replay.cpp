@@ -0,0 +1,199 @@
+#include "Replay.h"
+
+#include "Minefield.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <limits>
+
+#define REPLAY_MAGIC "MSRP"
+#define REPLAY_VERSION 1
+/// Largest dimension of a replayed board, guards the decoding of a corrupted file.
+#define MAX_DIMENSION 65535
+/// Most cells of a replayed board, the cells of a field are indexed by int.
+#define MAX_CELLS std::numeric_limits<int>::max()
+
+namespace
+{
+
+void putVarint(std::string &out, uint64_t value)
+{
+	while (value >= 0x80) {
+		out.push_back(static_cast<char>(value | 0x80));
+		value >>= 7;
+	}
+	out.push_back(static_cast<char>(value));
+}
+
+bool getVarint(std::string_view &in, uint64_t &value)
+{
+	value = 0;
+	for (int shift = 0; shift < 64 && !in.empty(); shift += 7) {
+		auto byte = static_cast<uint8_t>(in.front());
+		in.remove_prefix(1);
+		value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+		if ((byte & 0x80) == 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+uint64_t zigzag(int64_t value)
+{
+	return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+int64_t unzigzag(uint64_t value)
+{
+	return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+}
+
+Replay::Replay()
+	: Replay(0, 0, 0, 0)
+{
+}
+
+Replay::Replay(int width, int height, int numberOfMines, uint64_t seed)
+	: m_width(width)
+	, m_height(height)
+	, m_numberOfMines(numberOfMines)
+	, m_seed(seed)
+{
+}
+
+void Replay::record(int cell, Action action, uint32_t time)
+{
+	m_events.push_back({ cell, action, std::max(time, duration()) });
+}
+
+bool Replay::apply(Minefield &field, const Event &event) const
+{
+	if (!field.initialized()) {
+		field.generate(event.cell, m_seed);
+	}
+
+	switch (event.action) {
+	case Action::Reveal:
+		return field.reveal(event.cell);
+	case Action::Flag:
+		return field.toggleFlag(event.cell);
+	case Action::Chord:
+		return field.chord(event.cell);
+	}
+	return false;
+}
+
+std::string Replay::encode() const
+{
+	std::string out = REPLAY_MAGIC;
+	out.push_back(REPLAY_VERSION);
+	putVarint(out, m_width);
+	putVarint(out, m_height);
+	putVarint(out, m_numberOfMines);
+	putVarint(out, m_seed);
+	putVarint(out, m_events.size());
+
+	int cell = 0;
+	uint32_t time = 0;
+	for (const auto &event : m_events) {
+		putVarint(out, zigzag(event.cell - cell) << 2 | static_cast<uint64_t>(event.action));
+		putVarint(out, event.time - time);
+		cell = event.cell;
+		time = event.time;
+	}
+	return out;
+}
+
+std::optional<Replay> Replay::decode(std::string_view data)
+{
+	std::string_view magic = REPLAY_MAGIC;
+	if (!data.starts_with(magic) || data.size() <= magic.size() || data[magic.size()] != REPLAY_VERSION) {
+		return std::nullopt;
+	}
+	data.remove_prefix(magic.size() + 1);
+
+	uint64_t width;
+	uint64_t height;
+	uint64_t mines;
+	uint64_t seed;
+	uint64_t count;
+	if (!getVarint(data, width) || !getVarint(data, height) || !getVarint(data, mines) || !getVarint(data, seed)
+		|| !getVarint(data, count) || width == 0 || width > MAX_DIMENSION || height == 0 || height > MAX_DIMENSION
+		|| width * height > MAX_CELLS || mines >= width * height)
+	{
+		return std::nullopt;
+	}
+
+	Replay replay(width, height, mines, seed);
+	// Every event takes at least two bytes, a corrupted count can not reserve more than the data.
+	replay.m_events.reserve(std::min<uint64_t>(count, data.size() / 2));
+
+	int64_t cell = 0;
+	uint64_t time = 0;
+	for (uint64_t i = 0; i < count; i++) {
+		uint64_t packed;
+		uint64_t delta;
+		if (!getVarint(data, packed) || !getVarint(data, delta)) {
+			return std::nullopt;
+		}
+
+		cell += unzigzag(packed >> 2);
+		time += delta;
+		auto action = packed & 3;
+		if (cell < 0 || cell >= static_cast<int64_t>(width * height) || action > static_cast<uint64_t>(Action::Chord)
+			|| time > std::numeric_limits<uint32_t>::max())
+		{
+			return std::nullopt;
+		}
+		replay.m_events.push_back({ static_cast<int>(cell), static_cast<Action>(action), static_cast<uint32_t>(time) });
+	}
+
+	if (!data.empty()) {
+		return std::nullopt;
+	}
+	return replay;
+}
+
+bool Replay::save(const std::string &path) const
+{
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	auto data = encode();
+	file.write(data.data(), data.size());
+	return static_cast<bool>(file.flush());
+}
+
+std::optional<Replay> Replay::load(const std::string &path)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file) {
+		return std::nullopt;
+	}
+
+	std::string data(std::istreambuf_iterator<char>(file), {});
+	return decode(data);
+}
+
+ReplayPlayer::ReplayPlayer(Replay replay, double speed)
+	: m_replay(std::move(replay))
+	, m_speed(speed)
+	, m_position(0)
+	, m_index(0)
+{
+}
+
+void ReplayPlayer::advance(double milliseconds)
+{
+	m_position += m_speed > 0 ? milliseconds * m_speed : std::numeric_limits<double>::infinity();
+}
+
+const Replay::Event *ReplayPlayer::next()
+{
+	if (finished() || m_replay.events()[m_index].time > m_position) {
+		return nullptr;
+	}
+	return &m_replay.events()[m_index++];
+}
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class Minefield;
+
+/**
+ * @class Replay
+ * @brief Recording of one game as a compact stream of the player actions.
+ *
+ * The board is identified by its dimensions and the seed of @c Minefield::generate, the first action places the
+ * mines around its cell the same way the @c Board does on the first click. Every action is stored with its cell and
+ * the time since the start of the game, so the game is played back with the original pace.
+ *
+ * Encoded format, every number is an unsigned LEB128 varint:
+ *  - Magic "MSRP" and the format version byte.
+ *  - Width, height, number of mines, seed and the number of the events.
+ *  - Every event is the zigzag encoded difference of its cell from the cell of the previous event shifted left by
+ *    two bits with the @c Action in the low bits, followed by the milliseconds since the previous event.
+ *
+ * The consecutive actions are mostly close to each other and quick, so a typical event takes two or three bytes and
+ * a whole game a few hundred bytes.
+ */
+class Replay
+{
+public:
+	/// The player action, the same as the action of the @c Minefield.
+	enum class Action : uint8_t
+	{
+		Reveal,
+		Flag,
+		Chord,
+	};
+
+	/// One recorded action.
+	struct Event
+	{
+		int cell;
+		Action action;
+		/// Milliseconds since the start of the game.
+		uint32_t time;
+	};
+
+	Replay();
+
+	/**
+	 * @brief Start the recording of a game.
+	 *
+	 * @param width The number of cells in the horizontal direction.
+	 * @param height The number of cells in the vertical direction.
+	 * @param numberOfMines Number of mines on the board.
+	 * @param seed Seed the mines are generated from.
+	 */
+	explicit Replay(int width, int height, int numberOfMines, uint64_t seed);
+
+	int width() const { return m_width; }
+	int height() const { return m_height; }
+	int numberOfMines() const { return m_numberOfMines; }
+	uint64_t seed() const { return m_seed; }
+
+	/// True if no action was recorded.
+	bool empty() const { return m_events.empty(); }
+
+	const std::vector<Event> &events() const { return m_events; }
+
+	/// Milliseconds from the start of the game to the last action.
+	uint32_t duration() const { return m_events.empty() ? 0 : m_events.back().time; }
+
+	/**
+	 * @brief Append an action.
+	 *
+	 * @param cell The cell of the action.
+	 * @param action The action.
+	 * @param time Milliseconds since the start of the game, not lower than the time of the previous action.
+	 */
+	void record(int cell, Action action, uint32_t time);
+
+	/**
+	 * @brief Perform the recorded action on the field.
+	 *
+	 * If the mines are not placed yet, they are generated from the seed around the cell of the action.
+	 *
+	 * @param field Field with the dimensions of the replay.
+	 * @param event One of the events of the replay.
+	 * @return True if the field was changed.
+	 */
+	bool apply(Minefield &field, const Event &event) const;
+
+	/// Encode the replay into the compact binary form.
+	std::string encode() const;
+
+	/**
+	 * @brief Decode the replay from the binary form.
+	 *
+	 * @return The replay, nothing if the data are truncated or malformed.
+	 */
+	static std::optional<Replay> decode(std::string_view data);
+
+	/**
+	 * @brief Write the encoded replay to the file.
+	 *
+	 * @return True if the whole replay was written.
+	 */
+	bool save(const std::string &path) const;
+
+	/// Read and decode the replay file, nothing if it does not exist or is malformed.
+	static std::optional<Replay> load(const std::string &path);
+
+private:
+	int m_width;
+	int m_height;
+	int m_numberOfMines;
+	uint64_t m_seed;
+	std::vector<Event> m_events;
+};
+
+/**
+ * @class ReplayPlayer
+ * @brief Playback position in a replay.
+ *
+ * The position advances by the real time multiplied by the speed, the events up to the position are returned one by
+ * one so every action is rendered by its caller.
+ */
+class ReplayPlayer
+{
+public:
+	/**
+	 * @brief Start the playback from the beginning.
+	 *
+	 * @param replay The replay to be played.
+	 * @param speed Multiple of the original pace, zero or less plays all the events at once.
+	 */
+	explicit ReplayPlayer(Replay replay, double speed);
+
+	const Replay &replay() const { return m_replay; }
+
+	/// Move the position by the real time in milliseconds.
+	void advance(double milliseconds);
+
+	/// The next event up to the position, nothing if the playback has to wait.
+	const Replay::Event *next();
+
+	/// True if all the events were returned.
+	bool finished() const { return m_index == m_replay.events().size(); }
+
+private:
+	Replay m_replay;
+	double m_speed;
+	double m_position;
+	size_t m_index;
+};
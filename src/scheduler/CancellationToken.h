@@ -0,0 +1,64 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+/**
+ * @class CancellationToken
+ * @brief Tells a job whether the state it was started for is still current.
+ *
+ * The token remembers the value of an @c Epoch at its creation and is cancelled as soon as the epoch advances. It
+ * can be checked from any thread.
+ */
+class CancellationToken
+{
+public:
+	/// Token that is never cancelled.
+	CancellationToken() = default;
+
+	/// True if the epoch advanced since the token was created.
+	bool cancelled() const { return m_epoch && m_epoch->load(std::memory_order_acquire) != m_value; }
+
+	/// Value of the epoch the token was created at.
+	uint64_t epoch() const { return m_value; }
+
+private:
+	friend class Epoch;
+
+	CancellationToken(std::shared_ptr<const std::atomic<uint64_t>> epoch, uint64_t value)
+		: m_epoch(std::move(epoch))
+		, m_value(value)
+	{
+	}
+
+	std::shared_ptr<const std::atomic<uint64_t>> m_epoch;
+	uint64_t m_value = 0;
+};
+
+/**
+ * @class Epoch
+ * @brief Counter of the changes of a state, advancing it cancels all the tokens created before.
+ *
+ * Only the owner of the state advances the epoch, the tokens may outlive it.
+ */
+class Epoch
+{
+public:
+	Epoch()
+		: m_value(std::make_shared<std::atomic<uint64_t>>(0))
+	{
+	}
+
+	uint64_t value() const { return m_value->load(std::memory_order_relaxed); }
+
+	/// Cancel all the tokens of the current value.
+	void advance() { m_value->fetch_add(1, std::memory_order_release); }
+
+	/// Token cancelled by the next @c advance.
+	CancellationToken token() const { return CancellationToken(m_value, value()); }
+
+private:
+	std::shared_ptr<std::atomic<uint64_t>> m_value;
+};
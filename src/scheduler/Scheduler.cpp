@@ -0,0 +1,178 @@
+#include "Scheduler.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace
+{
+
+/// Index of the worker of the current thread and the scheduler it belongs to.
+thread_local int t_workerIndex = -1;
+thread_local const Scheduler *t_scheduler = nullptr;
+
+}
+
+Scheduler::Scheduler(unsigned threads)
+	: m_pending(0)
+	, m_queued(0)
+	, m_next(0)
+	, m_tasks(0)
+	, m_steals(0)
+	, m_parallelCalls(0)
+	, m_sequentialCalls(0)
+	, m_stop(false)
+{
+	if (threads == 0) {
+		threads = std::max(1u, std::thread::hardware_concurrency());
+	}
+
+	for (unsigned i = 0; i < threads; i++) {
+		m_workers.push_back(std::make_unique<Worker>());
+	}
+	for (unsigned i = 0; i < threads; i++) {
+		m_threads.emplace_back([this, i] {
+			run(i);
+		});
+	}
+}
+
+Scheduler::~Scheduler()
+{
+	wait();
+	{
+		std::lock_guard lock(m_mutex);
+		m_stop = true;
+	}
+	m_work.notify_all();
+	// The workers use the mutex and the condition variables until they return.
+	m_threads.clear();
+}
+
+int Scheduler::workerIndex()
+{
+	return t_workerIndex;
+}
+
+void Scheduler::submit(Task task)
+{
+	unsigned index = t_scheduler == this ? t_workerIndex : m_next++ % m_workers.size();
+
+	m_pending++;
+	{
+		auto &worker = *m_workers[index];
+		std::lock_guard lock(worker.mutex);
+		worker.tasks.push_back(std::move(task));
+	}
+
+	// The counter is changed under the lock, so a worker going to sleep can not miss the new task.
+	{
+		std::lock_guard lock(m_mutex);
+		m_queued++;
+	}
+	m_work.notify_one();
+}
+
+void Scheduler::wait()
+{
+	// The pending tasks include the task of the calling worker, they would never drop to zero.
+	assert(t_scheduler != this);
+	waitFor(m_pending);
+}
+
+Scheduler::Statistics Scheduler::statistics() const
+{
+	return {
+		.tasks = m_tasks.load(std::memory_order_relaxed),
+		.steals = m_steals.load(std::memory_order_relaxed),
+		.parallelCalls = m_parallelCalls.load(std::memory_order_relaxed),
+		.sequentialCalls = m_sequentialCalls.load(std::memory_order_relaxed),
+	};
+}
+
+void Scheduler::waitFor(const std::atomic<size_t> &remaining)
+{
+	// A worker waiting for the tasks helps with them instead of blocking its queue.
+	if (t_scheduler == this) {
+		Task task;
+		while (remaining > 0) {
+			if (take(t_workerIndex, task)) {
+				runTask(task);
+			}
+			else {
+				std::this_thread::yield();
+			}
+		}
+		return;
+	}
+
+	std::unique_lock lock(m_mutex);
+	m_done.wait(lock, [&remaining] {
+		return remaining == 0;
+	});
+}
+
+void Scheduler::finish(std::atomic<size_t> &remaining)
+{
+	// The waiting thread may destroy the counter as soon as it drops to zero.
+	if (--remaining == 0) {
+		std::lock_guard lock(m_mutex);
+		m_done.notify_all();
+	}
+}
+
+void Scheduler::runTask(Task &task)
+{
+	task();
+	task = nullptr;
+	m_tasks.fetch_add(1, std::memory_order_relaxed);
+	finish(m_pending);
+}
+
+void Scheduler::run(unsigned index)
+{
+	t_workerIndex = index;
+	t_scheduler = this;
+
+	Task task;
+	while (true) {
+		if (take(index, task)) {
+			runTask(task);
+			continue;
+		}
+
+		std::unique_lock lock(m_mutex);
+		m_work.wait(lock, [this] {
+			return m_stop || m_queued > 0;
+		});
+		if (m_stop && m_queued == 0) {
+			return;
+		}
+	}
+}
+
+bool Scheduler::take(unsigned index, Task &task)
+{
+	{
+		auto &own = *m_workers[index];
+		std::lock_guard lock(own.mutex);
+		if (!own.tasks.empty()) {
+			task = std::move(own.tasks.back());
+			own.tasks.pop_back();
+			m_queued--;
+			return true;
+		}
+	}
+
+	for (size_t i = 1; i < m_workers.size(); i++) {
+		auto &victim = *m_workers[(index + i) % m_workers.size()];
+		std::lock_guard lock(victim.mutex);
+		if (!victim.tasks.empty()) {
+			task = std::move(victim.tasks.front());
+			victim.tasks.pop_front();
+			m_queued--;
+			m_steals.fetch_add(1, std::memory_order_relaxed);
+			return true;
+		}
+	}
+	return false;
+}
@@ -0,0 +1,195 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @class Scheduler
+ * @brief Pool of the worker threads balancing the tasks by work stealing.
+ *
+ * Every worker owns a queue of tasks. A worker takes the newest task of its own queue, so the tasks it spawned run
+ * while their data are still in its cache. A worker with an empty queue steals the oldest task of another worker,
+ * the oldest tasks tend to be the largest ones. The tasks submitted from outside of the pool are spread over the
+ * queues round robin.
+ *
+ * The scheduler counts its tasks, steals and the calls of @c parallelFor, so the cost of the parallelism can be
+ * measured, see @c statistics.
+ *
+ * The tasks must not throw.
+ */
+class Scheduler
+{
+public:
+	/// A unit of work.
+	using Task = std::function<void()>;
+
+	/// Counters of the work since the start of the scheduler.
+	struct Statistics
+	{
+		/// Tasks finished by the workers or by the threads waiting for them.
+		uint64_t tasks = 0;
+		/// Tasks taken from the queue of another worker.
+		uint64_t steals = 0;
+		/// Calls of @c parallelFor split into the tasks.
+		uint64_t parallelCalls = 0;
+		/// Calls of @c parallelFor run on the calling thread, their range was below the threshold.
+		uint64_t sequentialCalls = 0;
+	};
+
+	/**
+	 * @brief Start the worker threads.
+	 *
+	 * @param threads Number of the workers, zero for all the cores.
+	 */
+	explicit Scheduler(unsigned threads = 0);
+
+	/// Finish all the submitted tasks and stop the workers.
+	~Scheduler();
+
+	Scheduler(const Scheduler &) = delete;
+	Scheduler &operator=(const Scheduler &) = delete;
+
+	/// Number of the worker threads.
+	unsigned size() const { return m_workers.size(); }
+
+	/// Index of the worker running the calling thread, -1 outside of the pool.
+	static int workerIndex();
+
+	/**
+	 * @brief Queue the task.
+	 *
+	 * A task submitted by a worker goes to its own queue.
+	 */
+	void submit(Task task);
+
+	/**
+	 * @brief Block until all the submitted tasks are finished, including the tasks they submitted.
+	 *
+	 * Only a thread outside of the pool may wait, a task waits for its own tasks by @c parallelFor.
+	 */
+	void wait();
+
+	/// Counters of the work so far.
+	Statistics statistics() const;
+
+	/**
+	 * @brief Call the function for every index of the range and wait for all of them.
+	 *
+	 * The range is split into the chunks of @c grain indices, each chunk is one task. Only the tasks of the call are
+	 * waited for, the other tasks of the scheduler may still run.
+	 *
+	 * @param count Size of the range.
+	 * @param grain Number of the indices of one task.
+	 * @param function Called with every index.
+	 * @param threshold A range smaller than the threshold is run sequentially on the calling thread, handing it over
+	 *        to the workers would take longer than the work itself.
+	 */
+	template <typename Function>
+	void parallelFor(size_t count, size_t grain, Function &&function, size_t threshold = 0)
+	{
+		if (count < threshold) {
+			m_sequentialCalls.fetch_add(1, std::memory_order_relaxed);
+			for (size_t i = 0; i < count; i++) {
+				function(i);
+			}
+			return;
+		}
+
+		m_parallelCalls.fetch_add(1, std::memory_order_relaxed);
+		grain = std::max<size_t>(grain, 1);
+		std::atomic<size_t> remaining((count + grain - 1) / grain);
+		for (size_t begin = 0; begin < count; begin += grain) {
+			size_t end = std::min(begin + grain, count);
+			submit([this, begin, end, &function, &remaining] {
+				for (size_t i = begin; i < end; i++) {
+					function(i);
+				}
+				finish(remaining);
+			});
+		}
+		waitFor(remaining);
+	}
+
+	/**
+	 * @brief Sort the range on the workers.
+	 *
+	 * The range is split into one chunk per worker, the chunks are sorted by the tasks and then merged in pairs, every
+	 * round of the merges is one @c parallelFor. Like @c std::sort the order of the equal elements is not kept.
+	 *
+	 * @param first Iterator to the first element of the range.
+	 * @param last Iterator past the last element of the range.
+	 * @param compare Ordering of the elements, the same as for @c std::sort.
+	 * @param threshold A range smaller than the threshold is sorted on the calling thread.
+	 */
+	template <typename Iterator, typename Compare>
+	void sort(Iterator first, Iterator last, Compare compare, size_t threshold = 0)
+	{
+		size_t count = last - first;
+		if (count < threshold || size() == 1) {
+			std::sort(first, last, compare);
+			return;
+		}
+
+		size_t chunk = std::max<size_t>((count + size() - 1) / size(), 1);
+		parallelFor((count + chunk - 1) / chunk, 1, [first, count, chunk, &compare](size_t i) {
+			std::sort(first + i * chunk, first + std::min((i + 1) * chunk, count), compare);
+		});
+		for (size_t width = chunk; width < count; width *= 2) {
+			parallelFor((count + 2 * width - 1) / (2 * width), 1, [first, count, width, &compare](size_t i) {
+				size_t begin = i * 2 * width;
+				size_t middle = std::min(begin + width, count);
+				std::inplace_merge(first + begin, first + middle, first + std::min(begin + 2 * width, count), compare);
+			});
+		}
+	}
+
+private:
+	/// Queue of one worker.
+	struct Worker
+	{
+		std::mutex mutex;
+		std::deque<Task> tasks;
+	};
+
+	/// Body of the worker thread.
+	void run(unsigned index);
+
+	/// Take a task of the worker or steal one of another worker.
+	bool take(unsigned index, Task &task);
+
+	/// Run the taken task and count it as finished.
+	void runTask(Task &task);
+
+	/// Count down one task of a group, the threads waiting for the groups are woken when it was the last one.
+	void finish(std::atomic<size_t> &remaining);
+
+	/// Block until the counter of the tasks drops to zero, a worker helps with the tasks meanwhile.
+	void waitFor(const std::atomic<size_t> &remaining);
+
+private:
+	std::vector<std::unique_ptr<Worker>> m_workers;
+	std::vector<std::jthread> m_threads;
+
+	/// Tasks submitted and not finished yet.
+	std::atomic<size_t> m_pending;
+	/// Tasks waiting in the queues, the idle workers sleep while there are none.
+	std::atomic<size_t> m_queued;
+	std::atomic<unsigned> m_next;
+	std::atomic<uint64_t> m_tasks;
+	std::atomic<uint64_t> m_steals;
+	std::atomic<uint64_t> m_parallelCalls;
+	std::atomic<uint64_t> m_sequentialCalls;
+	std::mutex m_mutex;
+	std::condition_variable m_work;
+	std::condition_variable m_done;
+	bool m_stop;
+};
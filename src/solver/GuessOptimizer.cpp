@@ -0,0 +1,252 @@
+#include "GuessOptimizer.h"
+
+#include "ProbabilityEngine.h"
+#include "Solver.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#define MAX_DEPTH 3
+#define CANDIDATES 6
+#define PROBABILITY_MARGIN 0.05
+#define TABLE_SIZE (1 << 18)
+#define ZOBRIST_SEED 0x9e3779b97f4a7c15
+
+namespace
+{
+
+/// SplitMix64, the keys are the same in every run so the searches are reproducible.
+uint64_t splitMix(uint64_t &state)
+{
+	uint64_t z = (state += 0x9e3779b97f4a7c15);
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+	return z ^ (z >> 31);
+}
+
+}
+
+GuessOptimizer::GuessOptimizer(const Minefield &field)
+	: m_field(field)
+	, m_expired(false)
+	, m_depth(0)
+{
+	reset();
+}
+
+void GuessOptimizer::reset()
+{
+	m_table.clear();
+	m_keys.resize(m_field.size() * (Minefield::MINE + 1));
+
+	uint64_t state = ZOBRIST_SEED;
+	for (auto &key : m_keys) {
+		key = splitMix(state);
+	}
+}
+
+int GuessOptimizer::guess(std::chrono::milliseconds budget, const CancellationToken &token)
+{
+	m_token = token;
+	auto view = m_field.view();
+	uint64_t hash = 0;
+	for (int cell = 0; cell < view.size(); cell++) {
+		if (view.isRevealed(cell) && !view.isMine(cell)) {
+			hash ^= key(cell, view.adjacentMines(cell));
+		}
+	}
+
+	auto root = analyse(view);
+	if (m_token.cancelled()) {
+		return -1;
+	}
+	if (root.safe != -1) {
+		return root.safe;
+	}
+	if (root.candidates.size() < 2) {
+		return root.candidates.empty() ? -1 : root.candidates.front();
+	}
+
+	if (m_table.size() > TABLE_SIZE) {
+		m_table.clear();
+	}
+
+	// The first iteration evaluates only the leaves, it always finishes unless cancelled. Without it the safest cell
+	// is used.
+	m_deadline = std::chrono::steady_clock::now() + budget;
+	m_depth = 0;
+	int best = root.candidates.front();
+	for (int depth = 1; depth <= MAX_DEPTH; depth++) {
+		m_expired = false;
+
+		int bestOfDepth = -1;
+		double bestValue = -1;
+		for (int cell : root.candidates) {
+			double value = reveal(view, hash, root.logWeight, cell, depth);
+			if (m_expired) {
+				break;
+			}
+			if (value > bestValue) {
+				bestValue = value;
+				bestOfDepth = cell;
+			}
+		}
+
+		if (m_expired) {
+			break;
+		}
+		best = bestOfDepth;
+		m_depth = depth;
+	}
+
+	return best;
+}
+
+GuessOptimizer::Analysis GuessOptimizer::analyse(const Minefield &view) const
+{
+	Solver solver(view);
+	std::vector<int> revealed;
+	for (int cell = 0; cell < view.size(); cell++) {
+		if (view.isRevealed(cell)) {
+			revealed.push_back(cell);
+		}
+	}
+	solver.update(revealed);
+
+	Analysis result { .logWeight = 0, .safe = -1, .safety = 1, .solved = true, .candidates = {} };
+	for (auto [cell, mine] : solver.deductions()) {
+		if (!mine) {
+			result.safe = cell;
+			break;
+		}
+	}
+
+	ProbabilityEngine engine(view, solver);
+	const auto &probabilities = engine.compute(m_token);
+	result.logWeight = engine.logWeight();
+
+	std::vector<int> unknown;
+	double lowest = 1;
+	for (int cell = 0; cell < view.size(); cell++) {
+		if (view.isRevealed(cell) || solver.knowledge(cell) == Solver::Knowledge::Mine) {
+			continue;
+		}
+		result.solved = false;
+		if (solver.knowledge(cell) == Solver::Knowledge::Unknown) {
+			unknown.push_back(cell);
+			lowest = std::min(lowest, probabilities[cell]);
+		}
+	}
+	result.safety = 1 - lowest;
+
+	// The frontier cells close to the safest one and the interior cell most likely to open an area, the one with the
+	// fewest neighbours. All the interior cells share the same probability.
+	int interior = -1;
+	int fewest = Minefield::MINE;
+	for (int cell : unknown) {
+		if (probabilities[cell] > lowest + PROBABILITY_MARGIN) {
+			continue;
+		}
+
+		int neighbours = 0;
+		bool frontier = false;
+		view.forEachNeighbour(cell, [&view, &neighbours, &frontier](int neighbour) {
+			neighbours++;
+			frontier |= view.isRevealed(neighbour);
+		});
+
+		if (frontier) {
+			result.candidates.push_back(cell);
+		}
+		else if (neighbours < fewest) {
+			fewest = neighbours;
+			interior = cell;
+		}
+	}
+
+	std::sort(result.candidates.begin(), result.candidates.end(), [&probabilities](int lhs, int rhs) {
+		return probabilities[lhs] < probabilities[rhs];
+	});
+	if (result.candidates.size() > CANDIDATES) {
+		result.candidates.resize(CANDIDATES);
+	}
+	if (interior != -1) {
+		auto position = std::upper_bound(result.candidates.begin(), result.candidates.end(), interior,
+			[&probabilities](int lhs, int rhs) {
+				return probabilities[lhs] < probabilities[rhs];
+			});
+		result.candidates.insert(position, interior);
+	}
+
+	return result;
+}
+
+GuessOptimizer::Entry GuessOptimizer::evaluate(Minefield &view, uint64_t hash, int depth)
+{
+	if (auto it = m_table.find(hash); it != m_table.end() && it->second.depth >= depth) {
+		return it->second;
+	}
+
+	if (m_token.cancelled() || (depth > 0 && std::chrono::steady_clock::now() >= m_deadline)) {
+		m_expired = true;
+		return { 0, 0, depth };
+	}
+
+	auto analysis = analyse(view);
+	// The analysis stopped by the token is not stored.
+	if (m_token.cancelled()) {
+		m_expired = true;
+		return { 0, 0, depth };
+	}
+	Entry entry { analysis.logWeight, 0, depth };
+	if (analysis.logWeight == -std::numeric_limits<double>::infinity()) {
+		entry.value = 0;
+	}
+	else if (analysis.solved) {
+		entry.value = 1;
+	}
+	else if (depth == 0) {
+		entry.value = analysis.safe != -1 ? 1 : analysis.safety;
+	}
+	else if (analysis.safe != -1) {
+		entry.value = reveal(view, hash, analysis.logWeight, analysis.safe, depth);
+	}
+	else {
+		for (int cell : analysis.candidates) {
+			entry.value = std::max(entry.value, reveal(view, hash, analysis.logWeight, cell, depth));
+			if (m_expired) {
+				break;
+			}
+		}
+	}
+
+	if (!m_expired) {
+		m_table[hash] = entry;
+	}
+	return entry;
+}
+
+double GuessOptimizer::reveal(Minefield &view, uint64_t hash, double logWeight, int cell, int depth)
+{
+	int hidden = 0;
+	view.forEachNeighbour(cell, [&view, &hidden](int neighbour) {
+		hidden += !view.isRevealed(neighbour);
+	});
+
+	// The layouts of the numbers the cell can show together are the layouts with the cell safe.
+	double value = 0;
+	for (int number = 0; number <= hidden; number++) {
+		auto child = view;
+		child.assume(cell, number);
+
+		auto entry = evaluate(child, hash ^ key(cell, number), depth - 1);
+		if (m_expired) {
+			return 0;
+		}
+		if (entry.logWeight != -std::numeric_limits<double>::infinity()) {
+			value += std::exp(entry.logWeight - logWeight) * entry.value;
+		}
+	}
+	return value;
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "CancellationToken.h"
+#include "Minefield.h"
+
+#include <chrono>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @class GuessOptimizer
+ * @brief Choice of the guess when the board can not be solved by deductions.
+ *
+ * The cell with the lowest mine probability is not always the best guess, a cell whose number is likely to unlock
+ * further deductions gives a higher chance to win the game. The optimizer runs a limited depth expectimax over the
+ * hypothetical reveals of the candidate cells:
+ *  - A guess of a cell is a chance node over the numbers the cell can show. The chance of every number is the ratio
+ *    of the mine layouts consistent with it to all the layouts, see @c ProbabilityEngine::logWeight, so the chance
+ *    of hitting a mine is accounted for by the missing layouts.
+ *  - After a reveal the solver makes its deductions. A state with a deduced safe cell continues with its reveal,
+ *    otherwise with the best of the candidate guesses.
+ *  - A leaf is worth 1 if it has a deduced safe cell, otherwise the chance the safest cell is not a mine.
+ *
+ * The candidates are the cells with the mine probability close to the lowest one and the interior cell with the
+ * fewest neighbours. The evaluated states are cached in a transposition table keyed by the Zobrist hash of the
+ * revealed numbers, so the same state reached by guessing the cells in a different order is evaluated once, also
+ * across the guesses of one game. The search deepens iteratively until the time budget runs out and the result of
+ * the deepest finished iteration is used.
+ */
+class GuessOptimizer
+{
+public:
+	/**
+	 * @brief Create the optimizer of the field.
+	 *
+	 * The field has to outlive the optimizer. When the field is replaced by a new game, @c reset has to be called.
+	 */
+	explicit GuessOptimizer(const Minefield &field);
+
+	/// Forget the evaluated states, called when a new game starts.
+	void reset();
+
+	/**
+	 * @brief Choose the cell to be revealed.
+	 *
+	 * The solver should have all its deductions made, the optimizer is meant for the states without a deduced safe
+	 * cell.
+	 *
+	 * @param budget Time after which no deeper search is started.
+	 * @param token Stops the search between the analysed states, the result is then not meaningful.
+	 * @return The hidden cell to be revealed, -1 if there is none.
+	 */
+	int guess(std::chrono::milliseconds budget, const CancellationToken &token = {});
+
+	/// Depth of the last finished search of @c guess.
+	int depth() const { return m_depth; }
+
+private:
+	/// Evaluated state of the transposition table.
+	struct Entry
+	{
+		/// See @c ProbabilityEngine::logWeight.
+		double logWeight;
+		/// Chance to win the game, limited by the depth of the search.
+		double value;
+		int depth;
+	};
+
+	/// Candidate guesses and what the analysis of a state found.
+	struct Analysis
+	{
+		double logWeight;
+		/// Deduced safe cell, -1 if there is none.
+		int safe;
+		/// Chance the safest hidden cell is not a mine.
+		double safety;
+		/// True if all the hidden cells are known mines.
+		bool solved;
+		std::vector<int> candidates;
+	};
+
+	/// Run the solver and the probability engine on the view.
+	Analysis analyse(const Minefield &view) const;
+
+	/**
+	 * @brief Value and the weight of the state, evaluated to the depth.
+	 *
+	 * @param view The state, its cells are revealed by the candidate guesses in the deeper levels.
+	 * @param hash Zobrist hash of the revealed numbers of the @c view.
+	 */
+	Entry evaluate(Minefield &view, uint64_t hash, int depth);
+
+	/// Value of revealing the cell in the state of the given weight, the average over its possible numbers.
+	double reveal(Minefield &view, uint64_t hash, double logWeight, int cell, int depth);
+
+	/// Zobrist key of the cell showing the number.
+	uint64_t key(int cell, int number) const { return m_keys[cell * (Minefield::MINE + 1) + number]; }
+
+private:
+	const Minefield &m_field;
+	std::vector<uint64_t> m_keys;
+	std::unordered_map<uint64_t, Entry> m_table;
+	std::chrono::steady_clock::time_point m_deadline;
+	/// Token of the running @c guess.
+	CancellationToken m_token;
+	/// True once the deadline passed or the token was cancelled, the unfinished iteration is discarded.
+	bool m_expired;
+	int m_depth;
+};
@@ -0,0 +1,212 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+
+/**
+ * @class PatternTable
+ * @brief Compile time lookup tables of the deductions of the local patterns.
+ *
+ * The cells around a revealed number are described by bit masks of a window centred on it, the hidden cells that
+ * are not deduced yet and the deduced mines. Two kinds of patterns are tabulated:
+ *  - Single: the 3x3 neighbourhood of the number, no mine left means all the hidden cells are safe, as many mines
+ *    left as hidden cells means all of them are mines.
+ *  - Pair: the number and another one at most @c PAIR_RANGE cells away, whose neighbourhoods span a window of up to
+ *    7x7 cells. The deduction is exact for the two numbers, it covers the subset, superset and difference rules and
+ *    the 1-2-1 and 1-2-2-1 patterns along the walls.
+ *
+ * The hidden cells of a pair split into three regions, around the first number only, around both and around the
+ * second only. The cells of a region are interchangeable, so the table is indexed by the number of the hidden cells
+ * per region and the mines left around both numbers and stores whether a whole region is safe or all mines. The
+ * masks of the regions for every position of the second number are computed at compile time as well, so a pattern
+ * costs a few population counts and one table load.
+ */
+class PatternTable
+{
+public:
+	/// What the pattern forces on the cells of a region.
+	enum class Forced : uint8_t
+	{
+		Nothing,
+		Safe,
+		Mine,
+	};
+
+	/// Regions of a pair.
+	enum Region
+	{
+		First,
+		Shared,
+		Second,
+	};
+
+	/// Region masks of a pair.
+	struct Pair
+	{
+		std::array<uint64_t, 3> regions;
+		/// Neighbourhood of the second number.
+		uint64_t second;
+	};
+
+	/// Largest distance of the numbers forming a pair.
+	static constexpr int PAIR_RANGE = 2;
+	/// Distance of the window border from its centre.
+	static constexpr int RADIUS = PAIR_RANGE + 1;
+	static constexpr int WINDOW = 2 * RADIUS + 1;
+	/// Mines left around a number are at most the number of its neighbours.
+	static constexpr int MINES = 9;
+
+	/// Bit of the cell of the window at the offset from the centre.
+	static constexpr int bit(int dx, int dy) { return (dy + RADIUS) * WINDOW + dx + RADIUS; }
+
+	/// Horizontal offset of the cell of the bit from the centre.
+	static constexpr int offsetX(int bit) { return bit % WINDOW - RADIUS; }
+
+	/// Vertical offset of the cell of the bit from the centre.
+	static constexpr int offsetY(int bit) { return bit / WINDOW - RADIUS; }
+
+	/// Mask of the neighbours of the cell at the offset from the centre.
+	static constexpr uint64_t neighbours(int dx, int dy)
+	{
+		uint64_t mask = 0;
+		for (int y = dy - 1; y <= dy + 1; y++) {
+			for (int x = dx - 1; x <= dx + 1; x++) {
+				if (x != dx || y != dy) {
+					mask |= uint64_t(1) << bit(x, y);
+				}
+			}
+		}
+		return mask;
+	}
+
+	/// Region masks of the pair with the second number at the offset, both offsets at most @c PAIR_RANGE.
+	static const Pair &regions(int dx, int dy)
+	{
+		return s_pairs[(dy + PAIR_RANGE) * (2 * PAIR_RANGE + 1) + dx + PAIR_RANGE];
+	}
+
+	/**
+	 * @brief Deduction of the single pattern.
+	 *
+	 * @param hidden Number of the hidden neighbours.
+	 * @param mines Mines left around the number.
+	 * @return What is forced on all the hidden neighbours.
+	 */
+	static Forced single(int hidden, int mines)
+	{
+		if (mines < 0 || mines >= MINES) {
+			return Forced::Nothing;
+		}
+		return s_single[hidden * MINES + mines];
+	}
+
+	/**
+	 * @brief Deduction of the pair pattern.
+	 *
+	 * @param first Number of the hidden cells around the first number only.
+	 * @param shared Number of the hidden cells around both numbers.
+	 * @param second Number of the hidden cells around the second number only.
+	 * @param firstMines Mines left around the first number.
+	 * @param secondMines Mines left around the second number.
+	 * @return What is forced on the hidden cells of each region, two bits per @c Region.
+	 */
+	static uint8_t pair(int first, int shared, int second, int firstMines, int secondMines)
+	{
+		if (firstMines < 0 || firstMines >= MINES || secondMines < 0 || secondMines >= MINES) {
+			return 0;
+		}
+		return s_pair[pairIndex(first, shared, second, firstMines, secondMines)];
+	}
+
+	/// What is forced on the region by the result of @c pair.
+	static Forced forced(uint8_t pair, Region region) { return static_cast<Forced>((pair >> (2 * region)) & 3); }
+
+private:
+	static constexpr int CELLS = 9;
+	/// Two distinct neighbourhoods share at most two rows of two cells.
+	static constexpr int SHARED_CELLS = 5;
+	static constexpr int SINGLE_ENTRIES = CELLS * MINES;
+	static constexpr int PAIR_ENTRIES = CELLS * SHARED_CELLS * CELLS * MINES * MINES;
+	static constexpr int PAIRS = (2 * PAIR_RANGE + 1) * (2 * PAIR_RANGE + 1);
+
+	static constexpr int pairIndex(int first, int shared, int second, int firstMines, int secondMines)
+	{
+		return (((first * SHARED_CELLS + shared) * CELLS + second) * MINES + firstMines) * MINES + secondMines;
+	}
+
+	static constexpr std::array<Forced, SINGLE_ENTRIES> makeSingle()
+	{
+		std::array<Forced, SINGLE_ENTRIES> table {};
+		for (int hidden = 1; hidden < CELLS; hidden++) {
+			table[hidden * MINES] = Forced::Safe;
+			table[hidden * MINES + hidden] = Forced::Mine;
+		}
+		return table;
+	}
+
+	/// What is forced on a region of the @c size cells holding from @c fewest to @c most mines.
+	static constexpr Forced region(int size, int fewest, int most)
+	{
+		if (size == 0) {
+			return Forced::Nothing;
+		}
+		return most == 0 ? Forced::Safe : fewest == size ? Forced::Mine : Forced::Nothing;
+	}
+
+	static constexpr std::array<uint8_t, PAIR_ENTRIES> makePair()
+	{
+		std::array<uint8_t, PAIR_ENTRIES> table {};
+		for (int first = 0; first < CELLS; first++) {
+			for (int shared = 0; shared < SHARED_CELLS; shared++) {
+				for (int second = 0; second < CELLS; second++) {
+					for (int firstMines = 0; firstMines < MINES; firstMines++) {
+						for (int secondMines = 0; secondMines < MINES; secondMines++) {
+							// Range of the mines in the shared cells allowed by both numbers, empty if they contradict.
+							int low = std::max(0, std::max(firstMines - first, secondMines - second));
+							int high = std::min(shared, std::min(firstMines, secondMines));
+							if (low > high) {
+								continue;
+							}
+
+							table[pairIndex(first, shared, second, firstMines, secondMines)] =
+								static_cast<uint8_t>(region(first, firstMines - high, firstMines - low))
+								| static_cast<uint8_t>(region(shared, low, high)) << (2 * Shared)
+								| static_cast<uint8_t>(region(second, secondMines - high, secondMines - low)) << (2 * Second);
+						}
+					}
+				}
+			}
+		}
+		return table;
+	}
+
+	static constexpr std::array<Pair, PAIRS> makePairs()
+	{
+		std::array<Pair, PAIRS> pairs {};
+		for (int dy = -PAIR_RANGE; dy <= PAIR_RANGE; dy++) {
+			for (int dx = -PAIR_RANGE; dx <= PAIR_RANGE; dx++) {
+				uint64_t first = neighbours(0, 0);
+				uint64_t second = neighbours(dx, dy);
+				pairs[(dy + PAIR_RANGE) * (2 * PAIR_RANGE + 1) + dx + PAIR_RANGE] = {
+					.regions = { first & ~second, first & second, second & ~first },
+					.second = second,
+				};
+			}
+		}
+		return pairs;
+	}
+
+	static const std::array<Forced, SINGLE_ENTRIES> s_single;
+	static const std::array<uint8_t, PAIR_ENTRIES> s_pair;
+	static const std::array<Pair, PAIRS> s_pairs;
+};
+
+inline constexpr std::array<PatternTable::Forced, PatternTable::SINGLE_ENTRIES> PatternTable::s_single =
+	PatternTable::makeSingle();
+
+inline constexpr std::array<uint8_t, PatternTable::PAIR_ENTRIES> PatternTable::s_pair = PatternTable::makePair();
+
+inline constexpr std::array<PatternTable::Pair, PatternTable::PAIRS> PatternTable::s_pairs =
+	PatternTable::makePairs();
@@ -0,0 +1,475 @@
+#include "ProbabilityEngine.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <unordered_map>
+
+/// A single component is counted on the calling thread, there is nothing to run in parallel with it.
+#define PARALLEL_COMPONENTS 2
+
+namespace
+{
+
+/// Discrete convolution of two distributions by the number of mines.
+std::vector<double> convolve(const std::vector<double> &lhs, const std::vector<double> &rhs)
+{
+	std::vector<double> result(lhs.size() + rhs.size() - 1, 0.0);
+	for (size_t i = 0; i < lhs.size(); i++) {
+		if (lhs[i] == 0) {
+			continue;
+		}
+		for (size_t j = 0; j < rhs.size(); j++) {
+			result[i + j] += lhs[i] * rhs[j];
+		}
+	}
+	return result;
+}
+
+/// Scale the values so the largest one is 1 and return the logarithm of the factor.
+double normalize(std::vector<double> &values)
+{
+	auto largest = *std::max_element(values.begin(), values.end());
+	if (largest <= 0) {
+		return 0;
+	}
+	for (auto &value : values) {
+		value /= largest;
+	}
+	return std::log(largest);
+}
+
+double logBinomial(int n, int k)
+{
+	return std::lgamma(n + 1.0) - std::lgamma(k + 1.0) - std::lgamma(n - k + 1.0);
+}
+
+/// One layer of the memoized backtracking, the states are the missing mines of the open constraints.
+struct Layer
+{
+	std::unordered_map<std::string, int> index;
+	std::vector<std::string> states;
+	/// Number of the assignments of the previous cells leading to the state, by their number of mines.
+	std::vector<std::vector<double>> forward;
+	/// Number of the assignments of the following cells completing the state, by their number of mines.
+	std::vector<std::vector<double>> backward;
+	/// State of the next layer after placing no mine and a mine to the cell, -1 if it breaks a constraint.
+	std::vector<std::array<int, 2>> next;
+	/// Logarithm of the factor the forward and backward counts were divided by.
+	double forwardScale = 0;
+	double backwardScale = 0;
+
+	int add(const std::string &state, size_t width)
+	{
+		auto [it, inserted] = index.emplace(state, states.size());
+		if (inserted) {
+			states.push_back(state);
+			forward.emplace_back(width, 0.0);
+			next.push_back({ -1, -1 });
+		}
+		return it->second;
+	}
+};
+
+/// Scale the counts of the layer so the largest one is 1 and return the logarithm of the factor.
+double rescale(std::vector<std::vector<double>> &counts)
+{
+	double largest = 0;
+	for (auto &count : counts) {
+		for (auto value : count) {
+			largest = std::max(largest, value);
+		}
+	}
+	if (largest == 0) {
+		return 0;
+	}
+	for (auto &count : counts) {
+		for (auto &value : count) {
+			value /= largest;
+		}
+	}
+	return std::log(largest);
+}
+
+}
+
+ProbabilityEngine::ProbabilityEngine(const Minefield &field, const Solver &solver, Scheduler *scheduler)
+	: m_field(field)
+	, m_solver(solver)
+	, m_scheduler(scheduler)
+	, m_logWeight(0)
+{
+}
+
+const std::vector<double> &ProbabilityEngine::compute(const CancellationToken &token)
+{
+	m_probabilities.assign(m_field.size(), 0.0);
+
+	int knownMines = 0;
+	for (int cell = 0; cell < m_field.size(); cell++) {
+		if (m_solver.knowledge(cell) == Solver::Knowledge::Mine) {
+			m_probabilities[cell] = 1.0;
+			knownMines++;
+		}
+	}
+
+	// A hypothetical state, see Minefield::assume, may contradict itself. The numbers without a hidden cell left
+	// around them are not a part of any component, so they are checked here.
+	for (int cell = 0; cell < m_field.size(); cell++) {
+		if (!m_field.isRevealed(cell) || m_field.isMine(cell)) {
+			continue;
+		}
+
+		int mines = 0;
+		int unknown = 0;
+		m_field.forEachNeighbour(cell, [this, &mines, &unknown](int neighbour) {
+			mines += m_solver.knowledge(neighbour) == Solver::Knowledge::Mine;
+			unknown += isUnknown(neighbour);
+		});
+		if (mines > m_field.adjacentMines(cell) || mines + unknown < m_field.adjacentMines(cell)) {
+			m_logWeight = -std::numeric_limits<double>::infinity();
+			return m_probabilities;
+		}
+	}
+
+	std::vector<int> interior;
+	auto parts = components(interior);
+	forEachComponent(parts.size(), [this, &parts, &token](size_t i) {
+		if (!token.cancelled()) {
+			enumerate(parts[i], token);
+		}
+	});
+	// The components left uncounted can not be combined.
+	if (token.cancelled()) {
+		return m_probabilities;
+	}
+
+	int remaining = m_field.numberOfMines() - knownMines;
+	int size = interior.size();
+
+	// Weight of a frontier configuration with the given number of mines.
+	int frontierSize = 0;
+	for (auto &component : parts) {
+		frontierSize += component.variables.size();
+	}
+	std::vector<double> weights(frontierSize + 1, 0.0);
+	double largest = -std::numeric_limits<double>::infinity();
+	for (int mines = 0; mines <= frontierSize; mines++) {
+		int rest = remaining - mines;
+		if (rest >= 0 && rest <= size) {
+			weights[mines] = logBinomial(size, rest);
+			largest = std::max(largest, weights[mines]);
+		}
+	}
+	for (int mines = 0; mines <= frontierSize; mines++) {
+		int rest = remaining - mines;
+		weights[mines] = rest >= 0 && rest <= size ? std::exp(weights[mines] - largest) : 0.0;
+	}
+
+	// Distributions of all the components before and after every component.
+	std::vector<std::vector<double>> prefix(parts.size() + 1, { 1.0 });
+	std::vector<std::vector<double>> suffix(parts.size() + 1, { 1.0 });
+	double scale = largest;
+	for (size_t i = 0; i < parts.size(); i++) {
+		prefix[i + 1] = convolve(prefix[i], parts[i].solutions);
+		scale += parts[i].scale + normalize(prefix[i + 1]);
+	}
+	for (size_t i = parts.size(); i-- > 0;) {
+		suffix[i] = convolve(parts[i].solutions, suffix[i + 1]);
+		normalize(suffix[i]);
+	}
+
+	forEachComponent(parts.size(), [&](size_t i) {
+		auto &component = parts[i];
+		auto others = convolve(prefix[i], suffix[i + 1]);
+
+		// Weight of the component having k mines combined with everything else.
+		std::vector<double> weight(component.solutions.size(), 0.0);
+		for (size_t k = 0; k < weight.size(); k++) {
+			for (size_t other = 0; other < others.size(); other++) {
+				weight[k] += others[other] * weights[k + other];
+			}
+		}
+
+		double total = 0;
+		for (size_t k = 0; k < weight.size(); k++) {
+			total += component.solutions[k] * weight[k];
+		}
+
+		for (size_t v = 0; v < component.variables.size(); v++) {
+			double mine = 0;
+			for (size_t k = 0; k < weight.size(); k++) {
+				mine += component.mines[v][k] * weight[k];
+			}
+			m_probabilities[component.variables[v]] = total > 0 ? mine / total : 0.5;
+		}
+	});
+
+	double total = 0;
+	double mines = 0;
+	auto &all = prefix.back();
+	for (size_t frontier = 0; frontier < all.size(); frontier++) {
+		total += all[frontier] * weights[frontier];
+		mines += all[frontier] * weights[frontier] * (remaining - static_cast<int>(frontier));
+	}
+	m_logWeight = total > 0 ? scale + std::log(total) : -std::numeric_limits<double>::infinity();
+
+	if (size > 0) {
+		double probability = total > 0 ? mines / total / size : static_cast<double>(remaining) / size;
+		for (int cell : interior) {
+			m_probabilities[cell] = probability;
+		}
+	}
+
+	return m_probabilities;
+}
+
+int ProbabilityEngine::safestCell() const
+{
+	int best = -1;
+	for (int cell = 0; cell < static_cast<int>(m_probabilities.size()); cell++) {
+		if (m_field.isRevealed(cell) || m_solver.knowledge(cell) == Solver::Knowledge::Mine) {
+			continue;
+		}
+		if (best == -1 || m_probabilities[cell] < m_probabilities[best]) {
+			best = cell;
+		}
+	}
+	return best;
+}
+
+bool ProbabilityEngine::isUnknown(int cell) const
+{
+	return !m_field.isRevealed(cell) && m_solver.knowledge(cell) == Solver::Knowledge::Unknown;
+}
+
+std::vector<ProbabilityEngine::Component> ProbabilityEngine::components(std::vector<int> &interior)
+{
+	std::vector<Component> result;
+	std::vector<uint8_t> visited(m_field.size(), 0);
+
+	auto isConstraint = [this](int cell) {
+		return m_field.isRevealed(cell) && !m_field.isMine(cell);
+	};
+
+	for (int start = 0; start < m_field.size(); start++) {
+		if (!isConstraint(start) || visited[start]) {
+			continue;
+		}
+
+		bool frontier = false;
+		m_field.forEachNeighbour(start, [this, &frontier](int neighbour) {
+			frontier |= isUnknown(neighbour);
+		});
+		if (!frontier) {
+			continue;
+		}
+
+		// Breadth first search alternating the constraints and their hidden cells keeps the cells of one
+		// constraint close together in the order of the backtracking.
+		Component component;
+		std::vector<int> queue { start };
+		visited[start] = 1;
+		for (size_t head = 0; head < queue.size(); head++) {
+			int constraint = queue[head];
+			component.constraints.push_back(constraint);
+
+			m_field.forEachNeighbour(constraint, [&](int variable) {
+				if (!isUnknown(variable) || visited[variable]) {
+					return;
+				}
+				visited[variable] = 1;
+				component.variables.push_back(variable);
+
+				m_field.forEachNeighbour(variable, [&](int next) {
+					if (isConstraint(next) && !visited[next]) {
+						visited[next] = 1;
+						queue.push_back(next);
+					}
+				});
+			});
+		}
+
+		result.push_back(std::move(component));
+	}
+
+	for (int cell = 0; cell < m_field.size(); cell++) {
+		if (isUnknown(cell) && !visited[cell]) {
+			interior.push_back(cell);
+		}
+	}
+
+	return result;
+}
+
+void ProbabilityEngine::enumerate(Component &component, const CancellationToken &token) const
+{
+	int count = component.variables.size();
+
+	std::unordered_map<int, int> position;
+	for (int i = 0; i < count; i++) {
+		position[component.variables[i]] = i;
+	}
+
+	// Every constraint: mines still to be placed, the positions of its cells and the span of the positions.
+	struct Constraint
+	{
+		int mines;
+		std::vector<int> positions;
+	};
+	std::vector<Constraint> constraints;
+	std::vector<std::vector<int>> constraintsOf(count);
+	for (int cell : component.constraints) {
+		Constraint constraint { m_field.adjacentMines(cell), {} };
+		m_field.forEachNeighbour(cell, [&](int neighbour) {
+			if (m_solver.knowledge(neighbour) == Solver::Knowledge::Mine) {
+				constraint.mines--;
+			}
+			else if (isUnknown(neighbour)) {
+				constraint.positions.push_back(position[neighbour]);
+			}
+		});
+		if (constraint.positions.empty()) {
+			continue;
+		}
+		std::sort(constraint.positions.begin(), constraint.positions.end());
+		for (int p : constraint.positions) {
+			constraintsOf[p].push_back(constraints.size());
+		}
+		constraints.push_back(std::move(constraint));
+	}
+
+	// Constraints open between the layers p - 1 and p, their missing mines are the state of the layer p.
+	std::vector<std::vector<int>> open(count + 1);
+	for (size_t c = 0; c < constraints.size(); c++) {
+		for (int p = constraints[c].positions.front() + 1; p <= constraints[c].positions.back(); p++) {
+			open[p].push_back(c);
+		}
+	}
+
+	// Cells of the constraint at the positions after p, i.e. the room left for its missing mines.
+	auto roomAfter = [&constraints](int c, int p) {
+		auto &positions = constraints[c].positions;
+		return static_cast<int>(positions.end() - std::upper_bound(positions.begin(), positions.end(), p));
+	};
+
+	// Forward pass, every layer keeps the distinct states reachable from the start.
+	std::vector<Layer> layers(count + 1);
+	layers[0].add({}, count + 1);
+	layers[0].forward[0][0] = 1.0;
+	std::vector<int> missing(constraints.size());
+	for (int p = 0; p < count; p++) {
+		if (token.cancelled()) {
+			return;
+		}
+
+		auto &layer = layers[p];
+		auto &nextLayer = layers[p + 1];
+
+		for (size_t s = 0; s < layer.states.size(); s++) {
+			// Restore the missing mines of the constraints touching the cell.
+			for (int c : constraintsOf[p]) {
+				missing[c] = constraints[c].mines;
+			}
+			for (size_t i = 0; i < open[p].size(); i++) {
+				missing[open[p][i]] = static_cast<int8_t>(layer.states[s][i]);
+			}
+
+			for (int mine = 0; mine < 2; mine++) {
+				bool valid = true;
+				for (int c : constraintsOf[p]) {
+					int left = missing[c] - mine;
+					valid &= left >= 0 && left <= roomAfter(c, p);
+				}
+				if (!valid) {
+					continue;
+				}
+
+				std::string state;
+				for (int c : open[p + 1]) {
+					bool touched = std::find(constraintsOf[p].begin(), constraintsOf[p].end(), c) != constraintsOf[p].end();
+					state.push_back(static_cast<char>(touched ? missing[c] - mine : missing[c]));
+				}
+
+				int target = nextLayer.add(state, count + 1);
+				layer.next[s][mine] = target;
+				auto &from = layer.forward[s];
+				auto &to = nextLayer.forward[target];
+				for (int k = 0; k + mine <= count; k++) {
+					to[k + mine] += from[k];
+				}
+			}
+		}
+
+		nextLayer.forwardScale = layer.forwardScale + rescale(nextLayer.forward);
+	}
+
+	// Backward pass from the single final state.
+	for (auto &layer : layers) {
+		layer.backward.assign(layer.states.size(), std::vector<double>(count + 1, 0.0));
+	}
+	for (auto &completion : layers[count].backward) {
+		completion[0] = 1.0;
+	}
+	for (int p = count - 1; p >= 0; p--) {
+		if (token.cancelled()) {
+			return;
+		}
+
+		auto &layer = layers[p];
+		auto &nextLayer = layers[p + 1];
+		for (size_t s = 0; s < layer.states.size(); s++) {
+			for (int mine = 0; mine < 2; mine++) {
+				int target = layer.next[s][mine];
+				if (target == -1) {
+					continue;
+				}
+				for (int k = 0; k + mine <= count; k++) {
+					layer.backward[s][k + mine] += nextLayer.backward[target][k];
+				}
+			}
+		}
+		layer.backwardScale = nextLayer.backwardScale + rescale(layer.backward);
+	}
+
+	component.solutions = layers[0].backward.empty() ? std::vector<double>(count + 1, 0.0) : layers[0].backward[0];
+	component.scale = layers[0].backwardScale;
+	component.mines.assign(count, std::vector<double>(count + 1, 0.0));
+
+	// A mine in the cell p splits every solution into the assignment before it and the completion after it.
+	for (int p = 0; p < count; p++) {
+		auto &layer = layers[p];
+		auto &nextLayer = layers[p + 1];
+		double scale = std::exp(layer.forwardScale + nextLayer.backwardScale - layers[0].backwardScale);
+
+		for (size_t s = 0; s < layer.states.size(); s++) {
+			int target = layer.next[s][1];
+			if (target == -1) {
+				continue;
+			}
+			auto &before = layer.forward[s];
+			auto &after = nextLayer.backward[target];
+			for (int a = 0; a <= p; a++) {
+				if (before[a] == 0) {
+					continue;
+				}
+				for (int b = 0; a + 1 + b <= count; b++) {
+					component.mines[p][a + 1 + b] += before[a] * after[b] * scale;
+				}
+			}
+		}
+	}
+}
+
+void ProbabilityEngine::forEachComponent(size_t count, const std::function<void(size_t)> &function) const
+{
+	if (m_scheduler != nullptr) {
+		m_scheduler->parallelFor(count, 1, function, PARALLEL_COMPONENTS);
+		return;
+	}
+
+	for (size_t i = 0; i < count; i++) {
+		function(i);
+	}
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "CancellationToken.h"
+#include "Minefield.h"
+#include "Scheduler.h"
+#include "Solver.h"
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+/**
+ * @class ProbabilityEngine
+ * @brief Exact mine probability of every hidden cell.
+ *
+ * The hidden cells around the revealed numbers, the frontier, are split into independent components of the
+ * constraints sharing a cell. The solutions of every component are counted by their number of mines with a
+ * backtracking over the cells of the component, memoized by the mines still missing around the numbers the
+ * backtracking is in the middle of. With a @c Scheduler the components are counted in parallel.
+ *
+ * The components are then combined with the cells away from the frontier: a configuration of the frontier with F
+ * mines is weighted by the binomial coefficient C(I, R - F), the number of ways to place the remaining R - F mines
+ * to the I other hidden cells. All the cells away from the frontier share the same probability.
+ *
+ * The engine works with what the @c Solver knows, the deduced cells have the probability 0 or 1.
+ */
+class ProbabilityEngine
+{
+public:
+	/**
+	 * @brief Create the engine of the field.
+	 *
+	 * Both the field and the solver have to outlive the engine.
+	 *
+	 * @param scheduler Workers counting the components, nothing to count them on the calling thread, e.g. when the
+	 *        caller is already one of many parallel tasks.
+	 */
+	explicit ProbabilityEngine(const Minefield &field, const Solver &solver, Scheduler *scheduler = nullptr);
+
+	/**
+	 * @brief Compute the probabilities of the current state of the field.
+	 *
+	 * The solver should have all its deductions made, see @c Solver::deductions.
+	 *
+	 * @param token Stops the computation between the components and between the layers of their backtracking, the
+	 *        probabilities are then not meaningful.
+	 * @return The mine probability of every cell, zero for the revealed cells.
+	 */
+	const std::vector<double> &compute(const CancellationToken &token = {});
+
+	/// The probabilities of the last @c compute.
+	const std::vector<double> &probabilities() const { return m_probabilities; }
+
+	/// Hidden cell with the lowest mine probability of the last @c compute, -1 if there is none.
+	int safestCell() const;
+
+	/**
+	 * @brief Logarithm of the number of the mine layouts consistent with the field of the last @c compute.
+	 *
+	 * Negative infinity if the revealed numbers contradict each other. The ratio of the counts of two states tells
+	 * how likely one of them is, e.g. the chance a hidden cell shows a given number once revealed.
+	 */
+	double logWeight() const { return m_logWeight; }
+
+private:
+	/// Independent part of the frontier.
+	struct Component
+	{
+		/// Hidden cells in the order of the backtracking.
+		std::vector<int> variables;
+		/// Revealed numbers constraining the cells.
+		std::vector<int> constraints;
+		/// Number of the solutions by their number of mines, scaled by a common factor.
+		std::vector<double> solutions;
+		/// Logarithm of the factor the @c solutions were divided by.
+		double scale = 0;
+		/// Number of the solutions with a mine in the cell by their number of mines, scaled like @c solutions.
+		std::vector<std::vector<double>> mines;
+	};
+
+	/// Hidden cell the solver knows nothing about.
+	bool isUnknown(int cell) const;
+
+	/// Split the frontier into the components, the hidden cells away from the frontier are stored in @c interior.
+	std::vector<Component> components(std::vector<int> &interior);
+
+	/// Count the solutions of the component, nothing is counted once the token is cancelled.
+	void enumerate(Component &component, const CancellationToken &token) const;
+
+	/// Call the function with the index of every component, on the workers of the scheduler if there is one.
+	void forEachComponent(size_t count, const std::function<void(size_t)> &function) const;
+
+private:
+	const Minefield &m_field;
+	const Solver &m_solver;
+	Scheduler *m_scheduler;
+	std::vector<double> m_probabilities;
+	double m_logWeight;
+};
@@ -0,0 +1,434 @@
+#include "Solver.h"
+
+#include "PatternTable.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+#define EPSILON 1e-9
+
+Solver::Solver(const Minefield &field)
+	: m_field(field)
+	, m_eliminated(true)
+{
+	reset();
+}
+
+void Solver::reset()
+{
+	m_knowledge.assign(m_field.size(), Knowledge::Unknown);
+	m_queued.assign(m_field.size(), 0);
+	m_dirty.assign(m_field.size(), 0);
+	m_visited.assign(m_field.size(), 0);
+	m_column.assign(m_field.size(), -1);
+	m_queue.clear();
+	m_dirtyCells.clear();
+	m_deduced.clear();
+	m_eliminated = true;
+}
+
+void Solver::update(std::span<const int> changed)
+{
+	for (int cell : changed) {
+		if (!isConstraint(cell)) {
+			continue;
+		}
+
+		m_knowledge[cell] = Knowledge::Safe;
+		enqueue(cell);
+		m_field.forEachNeighbour(cell, [this](int neighbour) {
+			enqueue(neighbour);
+		});
+	}
+}
+
+void Solver::retract(std::span<const int> hidden)
+{
+	// The walk goes from the hidden cells to the constraints around them and back, so the revealed area inside the
+	// frontier is not visited. The cells hidden again were constraints, the walk starts from their neighbours too.
+	std::vector<int> stack;
+	std::vector<int> visited;
+	auto visit = [this, &stack, &visited](int cell) {
+		if (!m_visited[cell]) {
+			m_visited[cell] = 1;
+			visited.push_back(cell);
+			stack.push_back(cell);
+		}
+	};
+
+	for (int cell : hidden) {
+		m_dirty[cell] = 0;
+		visit(cell);
+		m_field.forEachNeighbour(cell, [this, &visit](int neighbour) {
+			if (!m_field.isRevealed(neighbour)) {
+				visit(neighbour);
+			}
+		});
+	}
+
+	while (!stack.empty()) {
+		int cell = stack.back();
+		stack.pop_back();
+
+		if (isConstraint(cell)) {
+			enqueue(cell);
+			m_field.forEachNeighbour(cell, [this, &visit](int neighbour) {
+				if (!m_field.isRevealed(neighbour)) {
+					visit(neighbour);
+				}
+			});
+			continue;
+		}
+
+		m_knowledge[cell] = Knowledge::Unknown;
+		m_field.forEachNeighbour(cell, [this, &visit](int neighbour) {
+			if (isConstraint(neighbour)) {
+				visit(neighbour);
+			}
+		});
+	}
+
+	for (int cell : visited) {
+		m_visited[cell] = 0;
+	}
+	std::erase_if(m_deduced, [this](int cell) {
+		return m_knowledge[cell] == Knowledge::Unknown;
+	});
+}
+
+std::vector<Solver::Deduction> Solver::deductions()
+{
+	do {
+		propagate();
+	} while (!m_eliminated && eliminate());
+
+	std::erase_if(m_deduced, [this](int cell) {
+		return m_field.isRevealed(cell);
+	});
+
+	std::vector<Deduction> result;
+	for (int cell : m_deduced) {
+		bool mine = m_knowledge[cell] == Knowledge::Mine;
+		if (!mine || !m_field.isFlagged(cell)) {
+			result.push_back({ cell, mine });
+		}
+	}
+	return result;
+}
+
+std::optional<Solver::Deduction> Solver::hint()
+{
+	auto all = deductions();
+	auto safe = std::find_if(all.begin(), all.end(), [](const Deduction &deduction) {
+		return !deduction.mine;
+	});
+
+	if (safe != all.end()) {
+		return *safe;
+	}
+	if (!all.empty()) {
+		return all.front();
+	}
+	return std::nullopt;
+}
+
+void Solver::propagate()
+{
+	while (!m_queue.empty()) {
+		int cell = m_queue.back();
+		m_queue.pop_back();
+		m_queued[cell] = 0;
+		// The cell was hidden again by an undo after it was queued.
+		if (!isConstraint(cell)) {
+			continue;
+		}
+
+		// The deductions may enable more patterns around the same constraint.
+		if (patterns(cell)) {
+			enqueue(cell);
+		}
+	}
+}
+
+bool Solver::patterns(int cell)
+{
+	int cx = m_field.x(cell);
+	int cy = m_field.y(cell);
+
+	auto current = constraint(cell);
+	if (current.size == 0) {
+		return false;
+	}
+
+	auto forced = PatternTable::single(current.size, current.mines);
+	if (forced != PatternTable::Forced::Nothing) {
+		for (int i = 0; i < current.size; i++) {
+			mark(current.cells[i], forced == PatternTable::Forced::Safe ? Knowledge::Safe : Knowledge::Mine);
+		}
+		return true;
+	}
+
+	// The window of all the pairs of the constraint, the hidden cells and the deduced mines.
+	uint64_t hidden = 0;
+	uint64_t mines = 0;
+	for (int y = cy - PatternTable::RADIUS; y <= cy + PatternTable::RADIUS; y++) {
+		for (int x = cx - PatternTable::RADIUS; x <= cx + PatternTable::RADIUS; x++) {
+			if (!m_field.contains(x, y)) {
+				continue;
+			}
+
+			auto knowledge = m_knowledge[m_field.index(x, y)];
+			uint64_t bit = uint64_t(1) << PatternTable::bit(x - cx, y - cy);
+			hidden |= knowledge == Knowledge::Unknown ? bit : 0;
+			mines |= knowledge == Knowledge::Mine ? bit : 0;
+		}
+	}
+
+	for (int y = cy - PatternTable::PAIR_RANGE; y <= cy + PatternTable::PAIR_RANGE; y++) {
+		for (int x = cx - PatternTable::PAIR_RANGE; x <= cx + PatternTable::PAIR_RANGE; x++) {
+			if (!m_field.contains(x, y) || (x == cx && y == cy) || !isConstraint(m_field.index(x, y))) {
+				continue;
+			}
+
+			const auto &pair = PatternTable::regions(x - cx, y - cy);
+			auto result = PatternTable::pair(
+				std::popcount(hidden & pair.regions[PatternTable::First]),
+				std::popcount(hidden & pair.regions[PatternTable::Shared]),
+				std::popcount(hidden & pair.regions[PatternTable::Second]),
+				current.mines,
+				m_field.adjacentMines(m_field.index(x, y)) - std::popcount(mines & pair.second));
+			if (result == 0) {
+				continue;
+			}
+
+			for (auto region : { PatternTable::First, PatternTable::Shared, PatternTable::Second }) {
+				auto knowledge = PatternTable::forced(result, region);
+				if (knowledge == PatternTable::Forced::Nothing) {
+					continue;
+				}
+
+				for (uint64_t cells = hidden & pair.regions[region]; cells; cells &= cells - 1) {
+					int bit = std::countr_zero(cells);
+					mark(m_field.index(cx + PatternTable::offsetX(bit), cy + PatternTable::offsetY(bit)),
+						knowledge == PatternTable::Forced::Safe ? Knowledge::Safe : Knowledge::Mine);
+				}
+			}
+			return true;
+		}
+	}
+	return false;
+}
+
+bool Solver::eliminate()
+{
+	m_eliminated = true;
+
+	std::vector<int> rows;
+	std::vector<int> variables;
+	std::vector<int> stack;
+	bool found = false;
+
+	// Only the components with a changed constraint are eliminated again, the others can not yield anything new.
+	// The deductions of this pass mark the constraints around them dirty again in a new list.
+	auto dirty = std::move(m_dirtyCells);
+	m_dirtyCells.clear();
+	for (int start : dirty) {
+		if (!m_dirty[start]) {
+			continue;
+		}
+
+		// Collect the component of the constraint, the constraints sharing a hidden cell belong together.
+		rows.clear();
+		variables.clear();
+		stack.assign(1, start);
+		m_dirty[start] = 0;
+		m_visited[start] = 1;
+		while (!stack.empty()) {
+			int row = stack.back();
+			stack.pop_back();
+
+			auto current = constraint(row);
+			if (current.size == 0) {
+				continue;
+			}
+
+			rows.push_back(row);
+			for (int i = 0; i < current.size; i++) {
+				int variable = current.cells[i];
+				if (m_column[variable] != -1) {
+					continue;
+				}
+
+				m_column[variable] = variables.size();
+				variables.push_back(variable);
+				m_field.forEachNeighbour(variable, [this, &stack](int neighbour) {
+					if (isConstraint(neighbour) && !m_visited[neighbour]) {
+						m_visited[neighbour] = 1;
+						m_dirty[neighbour] = 0;
+						stack.push_back(neighbour);
+					}
+				});
+			}
+		}
+
+		for (int row : rows) {
+			m_visited[row] = 0;
+		}
+		m_visited[start] = 0;
+
+		found |= eliminate(rows, variables);
+
+		for (int variable : variables) {
+			m_column[variable] = -1;
+		}
+	}
+
+	return found;
+}
+
+bool Solver::eliminate(const std::vector<int> &rows, const std::vector<int> &variables)
+{
+	// A single constraint is fully handled by the single cell rule.
+	if (rows.size() < 2) {
+		return false;
+	}
+
+	int width = variables.size() + 1;
+	std::vector<double> matrix(rows.size() * width, 0.0);
+
+	for (size_t row = 0; row < rows.size(); row++) {
+		auto current = constraint(rows[row]);
+		for (int i = 0; i < current.size; i++) {
+			matrix[row * width + m_column[current.cells[i]]] = 1.0;
+		}
+		matrix[row * width + width - 1] = current.mines;
+	}
+
+	// Reduced row echelon form with partial pivoting.
+	std::vector<int> nonzero;
+	size_t pivotRow = 0;
+	for (int column = 0; column < width - 1 && pivotRow < rows.size(); column++) {
+		size_t best = pivotRow;
+		for (size_t row = pivotRow + 1; row < rows.size(); row++) {
+			if (std::abs(matrix[row * width + column]) > std::abs(matrix[best * width + column])) {
+				best = row;
+			}
+		}
+		if (std::abs(matrix[best * width + column]) < EPSILON) {
+			continue;
+		}
+
+		if (best != pivotRow) {
+			std::swap_ranges(matrix.begin() + best * width, matrix.begin() + (best + 1) * width,
+				matrix.begin() + pivotRow * width);
+		}
+
+		double *pivot = &matrix[pivotRow * width];
+		double scale = pivot[column];
+		for (int i = column; i < width; i++) {
+			pivot[i] /= scale;
+		}
+
+		// The frontier equations are sparse, only the nonzero entries of the pivot row are subtracted.
+		nonzero.clear();
+		for (int i = column; i < width; i++) {
+			if (std::abs(pivot[i]) >= EPSILON) {
+				nonzero.push_back(i);
+			}
+		}
+
+		for (size_t row = 0; row < rows.size(); row++) {
+			double *current = &matrix[row * width];
+			double factor = current[column];
+			if (row == pivotRow || std::abs(factor) < EPSILON) {
+				continue;
+			}
+			for (int i : nonzero) {
+				current[i] -= factor * pivot[i];
+			}
+			current[column] = 0;
+		}
+		pivotRow++;
+	}
+
+	// Every variable is 0 or 1. A row whose right side equals the smallest or the largest possible value of its
+	// left side determines all its variables.
+	bool found = false;
+	for (size_t row = 0; row < pivotRow; row++) {
+		const double *current = &matrix[row * width];
+		double low = 0;
+		double high = 0;
+		for (int column = 0; column < width - 1; column++) {
+			(current[column] < 0 ? low : high) += current[column];
+		}
+
+		double value = current[width - 1];
+		bool atLow = std::abs(value - low) < EPSILON;
+		bool atHigh = std::abs(value - high) < EPSILON;
+		if (!atLow && !atHigh) {
+			continue;
+		}
+
+		for (int column = 0; column < width - 1; column++) {
+			if (std::abs(current[column]) < EPSILON) {
+				continue;
+			}
+			bool mine = (current[column] > 0) == atHigh;
+			if (m_knowledge[variables[column]] == Knowledge::Unknown) {
+				mark(variables[column], mine ? Knowledge::Mine : Knowledge::Safe);
+				found = true;
+			}
+		}
+	}
+	return found;
+}
+
+Solver::Constraint Solver::constraint(int cell) const
+{
+	Constraint result;
+	result.mines = m_field.adjacentMines(cell);
+	m_field.forEachNeighbour(cell, [this, &result](int neighbour) {
+		switch (m_knowledge[neighbour]) {
+		case Knowledge::Unknown:
+			result.cells[result.size++] = neighbour;
+			break;
+		case Knowledge::Mine:
+			result.mines--;
+			break;
+		case Knowledge::Safe:
+			break;
+		}
+	});
+	return result;
+}
+
+void Solver::mark(int cell, Knowledge knowledge)
+{
+	if (m_knowledge[cell] != Knowledge::Unknown) {
+		return;
+	}
+
+	m_knowledge[cell] = knowledge;
+	m_deduced.push_back(cell);
+	m_field.forEachNeighbour(cell, [this](int neighbour) {
+		enqueue(neighbour);
+	});
+}
+
+void Solver::enqueue(int cell)
+{
+	if (!isConstraint(cell)) {
+		return;
+	}
+
+	if (!m_dirty[cell]) {
+		m_dirty[cell] = 1;
+		m_dirtyCells.push_back(cell);
+	}
+	m_eliminated = false;
+	if (!m_queued[cell]) {
+		m_queued[cell] = 1;
+		m_queue.push_back(cell);
+	}
+}
@@ -0,0 +1,160 @@
+#pragma once
+
+#include "Minefield.h"
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+
+/**
+ * @class Solver
+ * @brief Deterministic deduction of the safe cells and the mines from the revealed numbers.
+ *
+ * The solver sees only what the player sees, the revealed numbers of the @c Minefield. The flags of the player are
+ * ignored, because they may be wrong. Every revealed number is a constraint: the hidden cells around it hold exactly
+ * the number of mines that were not deduced yet. The constraints are resolved by three rules, the cheaper rules run
+ * first:
+ *  - Single cell rule: no mine left around a number means all its hidden neighbours are safe, as many mines left
+ *    as hidden neighbours means all of them are mines.
+ *  - Pair rule: two overlapping constraints, if the difference of their mines equals the number of cells only the
+ *    first one covers, those cells are mines and the cells only the second one covers are safe. It includes the
+ *    subset and superset rules. Both rules are looked up in the compile time @c PatternTable.
+ *  - Gaussian elimination over the equations of the whole frontier, split into independent components. It runs only
+ *    when the first two rules get stuck and only on the components that changed since the last elimination.
+ *
+ * The solver is incremental. The constraints are revisited only when a cell around them was revealed or deduced,
+ * see @c update, so solving after a click costs time proportional to the area the click opened.
+ */
+class Solver
+{
+public:
+	/// What the solver knows about a cell.
+	enum class Knowledge : uint8_t
+	{
+		Unknown,
+		Safe,
+		Mine,
+	};
+
+	/// Deduced cell.
+	struct Deduction
+	{
+		int cell;
+		bool mine;
+	};
+
+	/**
+	 * @brief Create the solver of the field.
+	 *
+	 * The field has to outlive the solver. When the field is replaced by a new game, @c reset has to be called.
+	 */
+	explicit Solver(const Minefield &field);
+
+	/// Forget everything, called when a new game starts.
+	void reset();
+
+	/**
+	 * @brief Take the changed cells of the field into account.
+	 *
+	 * @param changed Cells changed by the last action, see @c Minefield::changes.
+	 */
+	void update(std::span<const int> changed);
+
+	/**
+	 * @brief Forget what was deduced from the cells hidden again by an undo.
+	 *
+	 * Every rule relates only the constraints sharing hidden cells, so a deduction depends only on the frontier
+	 * component it was made in. The components around the hidden cells are walked, their deductions are forgotten
+	 * and their constraints queued again. It costs time proportional to the components, not to the board.
+	 *
+	 * @param hidden Cells revealed by the action taken back, they are hidden again in the field.
+	 */
+	void retract(std::span<const int> hidden);
+
+	/**
+	 * @brief Run all the rules until nothing more can be deduced.
+	 *
+	 * @return The deduced cells the player did not act on yet, safe cells to be revealed and mines to be flagged.
+	 */
+	std::vector<Deduction> deductions();
+
+	/**
+	 * @brief The next move the player can make without guessing.
+	 *
+	 * A safe cell is preferred to a mine.
+	 *
+	 * @return The deduced cell or nothing if a guess is needed.
+	 */
+	std::optional<Deduction> hint();
+
+	/// What is known about the cell, the revealed cells are safe.
+	Knowledge knowledge(int cell) const { return m_knowledge[cell]; }
+
+private:
+	/// Hidden cells around a revealed number that are not deduced yet.
+	struct Constraint
+	{
+		std::array<int, 8> cells;
+		int size = 0;
+		/// Mines among the @c cells.
+		int mines = 0;
+	};
+
+	/// Run the single cell and pair rules over the queued constraints.
+	void propagate();
+
+	/**
+	 * @brief Look up the single cell rule and the pair rule of the constraint in the @c PatternTable.
+	 *
+	 * @return True if a cell was deduced.
+	 */
+	bool patterns(int cell);
+
+	/**
+	 * @brief Gaussian elimination over the frontier components that changed since the last elimination.
+	 *
+	 * @return True if a cell was deduced.
+	 */
+	bool eliminate();
+
+	/**
+	 * @brief Eliminate one component, true if a cell was deduced.
+	 *
+	 * @param rows The constraints of the component.
+	 * @param variables The hidden cells of the component, their columns are stored in @c m_column.
+	 */
+	bool eliminate(const std::vector<int> &rows, const std::vector<int> &variables);
+
+	/// The constraint of the revealed cell.
+	Constraint constraint(int cell) const;
+
+	/// True if the cell is a revealed number, i.e. a constraint.
+	bool isConstraint(int cell) const { return m_field.isRevealed(cell) && !m_field.isMine(cell); }
+
+	/// Store the deduction and queue the constraints around the cell.
+	void mark(int cell, Knowledge knowledge);
+
+	/// Queue the constraint of the cell if it is one.
+	void enqueue(int cell);
+
+private:
+	const Minefield &m_field;
+	std::vector<Knowledge> m_knowledge;
+
+	/// Constraints to be revisited by @c propagate.
+	std::vector<int> m_queue;
+	std::vector<uint8_t> m_queued;
+	/// Constraints changed since the last elimination.
+	std::vector<uint8_t> m_dirty;
+	std::vector<int> m_dirtyCells;
+	/// Constraints already collected into the eliminated component.
+	std::vector<uint8_t> m_visited;
+	bool m_eliminated;
+
+	/// Deduced cells in the order they were found. The revealed safe cells are dropped lazily.
+	std::vector<int> m_deduced;
+	/// Column of the frontier cell in the eliminated matrix, reused between the eliminations.
+	std::vector<int> m_column;
+};
@@ -0,0 +1,70 @@
+#include "NamePool.h"
+
+#include <algorithm>
+#include <mutex>
+#include <numeric>
+
+NamePool::NamePool()
+{
+	intern("");
+}
+
+uint32_t NamePool::intern(std::string_view name)
+{
+	{
+		std::shared_lock lock(m_mutex);
+		auto it = m_ids.find(name);
+		if (it != m_ids.end()) {
+			return it->second;
+		}
+	}
+
+	std::unique_lock lock(m_mutex);
+	auto it = m_ids.find(name);
+	if (it != m_ids.end()) {
+		return it->second;
+	}
+
+	auto id = static_cast<uint32_t>(m_names.size());
+	auto &stored = m_names.emplace_back(name);
+	m_ids.emplace(stored, id);
+	return id;
+}
+
+std::optional<uint32_t> NamePool::find(std::string_view name) const
+{
+	std::shared_lock lock(m_mutex);
+	auto it = m_ids.find(name);
+	if (it == m_ids.end()) {
+		return std::nullopt;
+	}
+	return it->second;
+}
+
+std::string_view NamePool::name(uint32_t id) const
+{
+	std::shared_lock lock(m_mutex);
+	return id < m_names.size() ? std::string_view(m_names[id]) : std::string_view();
+}
+
+std::vector<uint32_t> NamePool::ranks() const
+{
+	std::shared_lock lock(m_mutex);
+	std::vector<uint32_t> order(m_names.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::sort(order.begin(), order.end(), [this](uint32_t lhs, uint32_t rhs) {
+		return m_names[lhs] < m_names[rhs];
+	});
+
+	std::vector<uint32_t> ranks(order.size());
+	for (uint32_t rank = 0; rank < order.size(); rank++) {
+		ranks[order[rank]] = rank;
+	}
+	return ranks;
+}
+
+size_t NamePool::size() const
+{
+	std::shared_lock lock(m_mutex);
+	return m_names.size();
+}
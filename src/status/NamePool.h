@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @class NamePool
+ * @brief Interned player names.
+ *
+ * Every distinct name is stored only once and is identified by a 32 bit ID. The records of the leaderboard keep
+ * only the ID, which keeps them small and trivially copyable even if the same player appears thousands of times.
+ * The IDs are valid only during the lifetime of the pool, the files store the names next to the IDs they use.
+ *
+ * The pool can be filled from several threads at once, e.g. when the score files are loaded in the background.
+ */
+class NamePool
+{
+public:
+	/// ID of the empty name, which is always present in the pool.
+	static constexpr uint32_t EMPTY = 0;
+
+	NamePool();
+	NamePool(const NamePool &) = delete;
+	NamePool &operator=(const NamePool &) = delete;
+
+	/**
+	 * @brief Get the ID of the name, the name is added to the pool if it is not present yet.
+	 *
+	 * @param name The name to be interned.
+	 * @return ID of the name.
+	 */
+	uint32_t intern(std::string_view name);
+
+	/**
+	 * @brief Get the ID of the name without adding it to the pool.
+	 *
+	 * @return ID of the name or nothing if the name is not in the pool.
+	 */
+	std::optional<uint32_t> find(std::string_view name) const;
+
+	/**
+	 * @brief Get the name of the given ID.
+	 *
+	 * The returned view stays valid as long as the pool exists. Unknown IDs return an empty name.
+	 */
+	std::string_view name(uint32_t id) const;
+
+	/**
+	 * @brief Rank the names alphabetically.
+	 *
+	 * The pool is locked once, so the ranks are compared by a sort without any locking.
+	 *
+	 * @return Alphabetical position of every name indexed by its ID.
+	 */
+	std::vector<uint32_t> ranks() const;
+
+	/// Number of the distinct names in the pool.
+	size_t size() const;
+
+private:
+	mutable std::shared_mutex m_mutex;
+	/// Deque keeps the strings in place, so the views in the @c m_ids stay valid.
+	std::deque<std::string> m_names;
+	std::unordered_map<std::string_view, uint32_t> m_ids;
+};
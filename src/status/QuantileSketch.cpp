@@ -0,0 +1,99 @@
+#include "QuantileSketch.h"
+
+#include <algorithm>
+#include <cmath>
+
+QuantileSketch::QuantileSketch(double quantile)
+	: m_quantile(quantile)
+	, m_count(0)
+	, m_heights()
+	, m_positions({ 1, 2, 3, 4, 5 })
+	, m_desired({ 1, 1 + 2 * quantile, 1 + 4 * quantile, 3 + 2 * quantile, 5 })
+	, m_increments({ 0, quantile / 2, quantile, (1 + quantile) / 2, 1 })
+{
+}
+
+void QuantileSketch::add(double value)
+{
+	// The first five values are the initial marker heights.
+	if (m_count < m_heights.size()) {
+		m_heights[m_count++] = value;
+		if (m_count == m_heights.size()) {
+			std::sort(m_heights.begin(), m_heights.end());
+		}
+		return;
+	}
+	m_count++;
+
+	int cell;
+	if (value < m_heights[0]) {
+		m_heights[0] = value;
+		cell = 0;
+	}
+	else if (value >= m_heights[4]) {
+		m_heights[4] = value;
+		cell = 3;
+	}
+	else {
+		cell = std::upper_bound(m_heights.begin() + 1, m_heights.end(), value) - m_heights.begin() - 1;
+	}
+
+	for (int i = cell + 1; i < 5; i++) {
+		m_positions[i]++;
+	}
+	for (int i = 0; i < 5; i++) {
+		m_desired[i] += m_increments[i];
+	}
+
+	// Move the middle markers towards their desired positions.
+	for (int i = 1; i < 4; i++) {
+		double difference = m_desired[i] - m_positions[i];
+		if ((difference >= 1 && m_positions[i + 1] - m_positions[i] > 1)
+			|| (difference <= -1 && m_positions[i - 1] - m_positions[i] < -1))
+		{
+			int direction = difference > 0 ? 1 : -1;
+			double height = parabolic(i, direction);
+			if (m_heights[i - 1] < height && height < m_heights[i + 1]) {
+				m_heights[i] = height;
+			}
+			else {
+				m_heights[i] = linear(i, direction);
+			}
+			m_positions[i] += direction;
+		}
+	}
+}
+
+double QuantileSketch::value() const
+{
+	if (m_count == 0) {
+		return 0;
+	}
+
+	if (m_count < m_heights.size()) {
+		auto sorted = m_heights;
+		std::sort(sorted.begin(), sorted.begin() + m_count);
+		return sorted[std::lround(m_quantile * (m_count - 1))];
+	}
+
+	return m_heights[2];
+}
+
+double QuantileSketch::parabolic(int marker, int direction) const
+{
+	const auto &q = m_heights;
+	const auto &n = m_positions;
+	int i = marker;
+	double d = direction;
+
+	return q[i] + d / (n[i + 1] - n[i - 1])
+		* ((n[i] - n[i - 1] + d) * (q[i + 1] - q[i]) / (n[i + 1] - n[i])
+			+ (n[i + 1] - n[i] - d) * (q[i] - q[i - 1]) / (n[i] - n[i - 1]));
+}
+
+double QuantileSketch::linear(int marker, int direction) const
+{
+	int i = marker;
+	int d = direction;
+	return m_heights[i] + d * (m_heights[i + d] - m_heights[i]) / (m_positions[i + d] - m_positions[i]);
+}
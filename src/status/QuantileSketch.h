@@ -0,0 +1,46 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+/**
+ * @class QuantileSketch
+ * @brief Streaming estimate of a single quantile.
+ *
+ * The sketch implements the P-square algorithm of Jain and Chlamtac. It keeps only five markers, so adding a value
+ * and reading the estimate take constant time and memory regardless of the number of values seen.
+ */
+class QuantileSketch
+{
+public:
+	/**
+	 * @brief Create the sketch.
+	 *
+	 * @param quantile The estimated quantile in the range (0, 1), e.g. 0.9 for the 90th percentile.
+	 */
+	explicit QuantileSketch(double quantile);
+
+	/// Add a value to the sketch.
+	void add(double value);
+
+	/// Current estimate of the quantile, zero if no value was added.
+	double value() const;
+
+	/// Number of the values added to the sketch.
+	uint64_t count() const { return m_count; }
+
+private:
+	/// Piecewise parabolic prediction of the marker height after moving it by @c direction.
+	double parabolic(int marker, int direction) const;
+
+	/// Linear prediction used when the parabolic one breaks the order of the markers.
+	double linear(int marker, int direction) const;
+
+private:
+	double m_quantile;
+	uint64_t m_count;
+	std::array<double, 5> m_heights;
+	std::array<double, 5> m_positions;
+	std::array<double, 5> m_desired;
+	std::array<double, 5> m_increments;
+};
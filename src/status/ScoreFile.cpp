@@ -0,0 +1,145 @@
+#include "ScoreFile.h"
+
+#include <array>
+#include <charconv>
+
+namespace
+{
+
+template <typename T>
+bool toNumber(std::string_view token, T &value)
+{
+	auto [end, error] = std::from_chars(token.data(), token.data() + token.size(), value);
+	return error == std::errc() && end == token.data() + token.size();
+}
+
+}
+
+ScoreFile::ScoreFile(const std::string &path)
+	: m_file(path)
+{
+}
+
+ScoreFile::Contents ScoreFile::parse(NamePool &names, Scheduler *scheduler) const
+{
+	Contents contents { .sortOrder = 0, .sections = {} };
+	if (!isOpen()) {
+		return contents;
+	}
+
+	auto text = m_file.data();
+	toNumber(nextLine(text), contents.sortOrder);
+
+	auto parts = sections(text);
+	std::vector<DifficultyTab> tabs(parts.size());
+	auto parseOne = [&names, &parts, &tabs](size_t i) {
+		tabs[i] = parseSection(parts[i].body, names);
+	};
+	if (scheduler != nullptr) {
+		scheduler->parallelFor(parts.size(), 1, parseOne);
+	}
+	else {
+		for (size_t i = 0; i < parts.size(); i++) {
+			parseOne(i);
+		}
+	}
+
+	for (size_t i = 0; i < parts.size(); i++) {
+		auto &target = contents.sections[parts[i].difficulty];
+		target.push(tabs[i].begin(), tabs[i].end());
+	}
+
+	return contents;
+}
+
+std::vector<ScoreFile::Section> ScoreFile::sections(std::string_view text)
+{
+	std::vector<Section> result;
+
+	while (!text.empty()) {
+		auto line = nextLine(text);
+
+		long difficulty;
+		if (line.find(' ') != std::string_view::npos || !toNumber(line, difficulty)) {
+			// Record line, extend the body of the current section.
+			if (!result.empty()) {
+				auto &body = result.back().body;
+				body = std::string_view(body.data(), text.data() - body.data());
+			}
+			continue;
+		}
+
+		result.push_back({ difficulty, std::string_view(text.data(), 0) });
+	}
+
+	return result;
+}
+
+std::string_view ScoreFile::nextLine(std::string_view &text)
+{
+	auto end = text.find('\n');
+	auto line = text.substr(0, end);
+	text.remove_prefix(end == std::string_view::npos ? text.size() : end + 1);
+
+	if (!line.empty() && line.back() == '\r') {
+		line.remove_suffix(1);
+	}
+	return line;
+}
+
+bool ScoreFile::parseRecord(std::string_view line, ScoreRecord &record, NamePool &names)
+{
+	// score, name, number of mines, hash and optionally width and height.
+	std::array<std::string_view, 6> parts;
+	size_t count = 0;
+
+	while (count < parts.size()) {
+		auto end = line.find(' ');
+		parts[count++] = line.substr(0, end);
+		if (end == std::string_view::npos) {
+			break;
+		}
+		line.remove_prefix(end + 1);
+	}
+
+	if (count != 4 && count != 6) {
+		return false;
+	}
+
+	record.width = 0;
+	record.height = 0;
+	if (!toNumber(parts[0], record.score)
+		|| !toNumber(parts[2], record.numberOfMines)
+		|| !toNumber(parts[3], record.hash))
+	{
+		return false;
+	}
+
+	if (count == 6 && (!toNumber(parts[4], record.width) || !toNumber(parts[5], record.height))) {
+		return false;
+	}
+
+	// Older versions wrote the whole zero padded name buffer.
+	auto name = parts[1];
+	name = name.substr(0, name.find('\0'));
+	record.name = names.intern(name);
+
+	return true;
+}
+
+DifficultyTab ScoreFile::parseSection(std::string_view body, NamePool &names)
+{
+	std::vector<ScoreRecord> records;
+	records.reserve(body.size() / 24);
+
+	ScoreRecord record {};
+	while (!body.empty()) {
+		if (parseRecord(nextLine(body), record, names)) {
+			records.push_back(record);
+		}
+	}
+
+	DifficultyTab tab;
+	tab.push(records.begin(), records.end());
+	return tab;
+}
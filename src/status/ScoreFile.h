@@ -0,0 +1,102 @@
+#pragma once
+
+#include "MappedFile.h"
+#include "NamePool.h"
+#include "Scheduler.h"
+#include "ScoreRecord.h"
+
+#include <map>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/**
+ * @class ScoreFile
+ * @brief Read only, memory mapped view of the score file in the legacy text format.
+ *
+ * The text file is only read to import the scores of older versions into the @c ScoreJournal. It is mapped into
+ * memory once and parsed in place. Every line is split into @c std::string_view fields and the numbers are
+ * converted with @c std::from_chars, so no intermediate strings are allocated. The player names are interned
+ * straight from the mapped memory.
+ *
+ * The file consists of the sort order on the first line followed by sections. Every section starts with a line
+ * holding only the difficulty and continues with one record per line. The sections are independent and are
+ * parsed in parallel.
+ */
+class ScoreFile
+{
+public:
+	/// Records grouped by the difficulty.
+	using Sections = std::map<long, DifficultyTab>;
+
+	/// Number of the lost games keyed by the difficulty and the player name ID.
+	using Losses = std::map<std::pair<long, uint32_t>, uint64_t>;
+
+	/// Parsed content of the whole file.
+	struct Contents
+	{
+		int sortOrder;
+		Sections sections;
+		/// Lost games, the legacy file does not store them.
+		Losses losses = {};
+	};
+
+	/**
+	 * @brief Map the file into memory.
+	 *
+	 * If the file does not exist or is empty, the object is created but @c isOpen returns false.
+	 *
+	 * @param path Path to the score file.
+	 */
+	explicit ScoreFile(const std::string &path);
+
+	/// True if the file was successfully mapped.
+	bool isOpen() const { return m_file.isOpen(); }
+
+	/**
+	 * @brief Parse the mapped file.
+	 *
+	 * Every difficulty section is parsed by its own task. Malformed lines are skipped.
+	 *
+	 * @param names Pool the player names are interned to.
+	 * @param scheduler Workers parsing the sections, nothing to parse them on the calling thread.
+	 * @return The sort order and the records of all the sections.
+	 */
+	Contents parse(NamePool &names, Scheduler *scheduler = nullptr) const;
+
+private:
+	/// Unparsed section of the file.
+	struct Section
+	{
+		long difficulty;
+		std::string_view body;
+	};
+
+	/**
+	 * @brief Split the text after the header into the difficulty sections.
+	 *
+	 * @param text The mapped file without the sort order line.
+	 * @return The sections in the order of appearance.
+	 */
+	static std::vector<Section> sections(std::string_view text);
+
+	/// Remove the first line from the @c text and return it without the line break.
+	static std::string_view nextLine(std::string_view &text);
+
+	/**
+	 * @brief Parse one record line in the format "score name mines hash [width height]".
+	 *
+	 * @param line The line to be parsed.
+	 * @param record Output record. The name is interned only if the line is valid.
+	 * @param names Pool the player name is interned to.
+	 * @return True if the line is a valid record, false otherwise.
+	 */
+	static bool parseRecord(std::string_view line, ScoreRecord &record, NamePool &names);
+
+	/// Parse all the records of one section.
+	static DifficultyTab parseSection(std::string_view body, NamePool &names);
+
+private:
+	MappedFile m_file;
+};
@@ -0,0 +1,746 @@
+#include "ScoreJournal.h"
+
+#include "MappedFile.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <filesystem>
+#include <tuple>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define JOURNAL_MAGIC 0x314a534du // "MSJ1"
+#define JOURNAL_VERSION 2u
+#define ENTRY_MARKER 0x21454d53u // "SME!"
+#define COMPACTION_THRESHOLD 256
+
+namespace
+{
+
+constexpr std::array<uint32_t, 256> crcTable()
+{
+	std::array<uint32_t, 256> table {};
+	for (uint32_t i = 0; i < table.size(); i++) {
+		uint32_t crc = i;
+		for (int bit = 0; bit < 8; bit++) {
+			crc = (crc & 1) ? (crc >> 1) ^ 0xedb88320u : crc >> 1;
+		}
+		table[i] = crc;
+	}
+	return table;
+}
+
+uint32_t crc32(std::string_view data)
+{
+	static constexpr auto table = crcTable();
+
+	uint32_t crc = 0xffffffffu;
+	for (unsigned char byte : data) {
+		crc = table[(crc ^ byte) & 0xff] ^ (crc >> 8);
+	}
+	return crc ^ 0xffffffffu;
+}
+
+template <typename T>
+void put(std::string &buffer, T value)
+{
+	buffer.append(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template <typename T>
+bool take(std::string_view &data, T &value)
+{
+	if (data.size() < sizeof(T)) {
+		return false;
+	}
+	std::memcpy(&value, data.data(), sizeof(T));
+	data.remove_prefix(sizeof(T));
+	return true;
+}
+
+/// Write the whole buffer, returns false on an error.
+bool writeAll(int fd, std::string_view data)
+{
+	while (!data.empty()) {
+		auto written = ::write(fd, data.data(), data.size());
+		if (written <= 0) {
+			return false;
+		}
+		data.remove_prefix(written);
+	}
+	return true;
+}
+
+/// True if the descriptor refers to the file currently linked at the path.
+bool sameFile(int fd, const std::string &path)
+{
+	struct stat opened;
+	struct stat linked;
+	return ::fstat(fd, &opened) == 0 && ::stat(path.c_str(), &linked) == 0
+		&& opened.st_dev == linked.st_dev && opened.st_ino == linked.st_ino;
+}
+
+/// Temporary file next to the path, unique for the process.
+std::string temporaryPath(const std::string &path)
+{
+	return path + "." + std::to_string(::getpid()) + ".tmp";
+}
+
+/// Advisory lock of the file held for the lifetime of the object.
+class FileLock
+{
+public:
+	FileLock(int fd, int operation)
+		: m_fd(fd)
+		, m_locked(fd != -1 && ::flock(fd, operation) == 0)
+	{
+	}
+
+	~FileLock()
+	{
+		if (m_locked) {
+			::flock(m_fd, LOCK_UN);
+		}
+	}
+
+private:
+	int m_fd;
+	bool m_locked;
+};
+
+}
+
+ScoreJournal::ScoreJournal(const std::string &name, NamePool &names, Scheduler *scheduler)
+	: m_snapshotPath(name + ".snapshot")
+	, m_journalPath(name + ".journal")
+	, m_compactingPath(name + ".compacting")
+	, m_lockPath(name + ".lock")
+	, m_compactorPath(name + ".compactor")
+	, m_names(names)
+	, m_scheduler(scheduler)
+	, m_lock(-1)
+	, m_journal(-1)
+	, m_journalVersion(JOURNAL_VERSION)
+	, m_journalEntries(0)
+	, m_tail(-1)
+	, m_tailOffset(0)
+	, m_tailVersion(0)
+	, m_compacting(false)
+{
+}
+
+ScoreJournal::~ScoreJournal()
+{
+	{
+		std::unique_lock lock(m_mutex);
+		m_compacted.wait(lock, [this] {
+			return !m_compacting;
+		});
+	}
+
+	for (int fd : { m_journal, m_tail, m_lock }) {
+		if (fd != -1) {
+			::close(fd);
+		}
+	}
+}
+
+ScoreFile::Contents ScoreJournal::load(const std::string &legacyFile)
+{
+	ScoreFile::Contents contents { .sortOrder = 0, .sections = {} };
+	Replay replay;
+	uint32_t version = 0;
+	size_t size = 0;
+	size_t compacted = 0;
+	int tail = -1;
+
+	{
+		// The files are read without the mutex, so the records earned meanwhile are appended right away. The lock file
+		// is opened again, the lock of the appending descriptor would be released by the first append.
+		int fd = ::open(m_lockPath.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+		FileLock shared(fd, LOCK_SH);
+
+		// The journal may already be created by a record earned while loading, the import is decided by the snapshot.
+		if (!std::filesystem::exists(m_snapshotPath) && !std::filesystem::exists(m_compactingPath)) {
+			// Another instance importing at the same time writes the same snapshot.
+			auto temporary = writeSnapshot(ScoreFile(legacyFile).parse(m_names, m_scheduler));
+			std::error_code error;
+			if (!temporary.empty()) {
+				std::filesystem::rename(temporary, m_snapshotPath, error);
+			}
+		}
+
+		createJournal();
+
+		this->replay(m_snapshotPath, replay);
+		this->replay(m_compactingPath, replay);
+
+		compacted = replay.entries;
+		std::tie(version, size) = this->replay(m_journalPath, replay);
+
+		// Follow the journal from the point it was read to.
+		tail = ::open(m_journalPath.c_str(), O_RDONLY | O_CLOEXEC);
+
+		if (fd != -1) {
+			::close(fd);
+		}
+	}
+
+	std::lock_guard lock(m_mutex);
+	m_journalEntries = replay.entries - compacted;
+	m_tail = tail;
+	m_tailOffset = size;
+	m_tailVersion = version;
+	m_tailIds = replay.ids;
+
+	// Records appended by this instance before the journal was read, the later ones are dropped by the poll.
+	dropPending(replay);
+
+	contents.sortOrder = replay.sortOrder;
+	contents.losses = std::move(replay.losses);
+	collect(replay.records, contents);
+
+	if (needsCompaction() || version < JOURNAL_VERSION || std::filesystem::exists(m_compactingPath)) {
+		startCompaction();
+	}
+
+	return contents;
+}
+
+void ScoreJournal::append(long difficulty, const ScoreRecord &record)
+{
+	std::lock_guard lock(m_mutex);
+	{
+		FileLock shared(lockFile(), LOCK_SH);
+
+		write({ encodeName(record.name, m_names.name(record.name)), encode(difficulty, record) });
+		m_pending.insert(record.hash);
+	}
+
+	if (needsCompaction()) {
+		startCompaction();
+	}
+}
+
+void ScoreJournal::appendLoss(long difficulty, uint32_t name)
+{
+	std::lock_guard lock(m_mutex);
+	{
+		FileLock shared(lockFile(), LOCK_SH);
+
+		write({ encodeName(name, m_names.name(name)), encodeLoss(difficulty, name, 1) });
+		m_pendingLosses[{ difficulty, name }]++;
+	}
+
+	if (needsCompaction()) {
+		startCompaction();
+	}
+}
+
+void ScoreJournal::appendSortOrder(int sortOrder)
+{
+	std::lock_guard lock(m_mutex);
+	FileLock shared(lockFile(), LOCK_SH);
+
+	write({ encode(sortOrder) });
+}
+
+ScoreFile::Contents ScoreJournal::poll()
+{
+	ScoreFile::Contents contents { .sortOrder = 0, .sections = {} };
+
+	std::lock_guard lock(m_mutex);
+	if (m_tail == -1) {
+		return contents;
+	}
+
+	Replay replay;
+	{
+		FileLock shared(lockFile(), LOCK_SH);
+
+		bool rotated = !sameFile(m_tail, m_journalPath);
+		readTail(replay);
+
+		if (rotated) {
+			// Nobody appends to the rotated journal anymore, it was read completely.
+			::close(m_tail);
+			m_tail = ::open(m_journalPath.c_str(), O_RDONLY | O_CLOEXEC);
+			m_tailOffset = 0;
+			m_tailIds.clear();
+			// The entries of the rotated journal are compacted by the instance that rotated it.
+			m_journalEntries = 0;
+			readTail(replay);
+		}
+	}
+
+	dropPending(replay);
+	for (auto &[difficulty, section] : replay.records) {
+		m_journalEntries += section.size();
+	}
+	m_journalEntries += replay.losses.size();
+	if (needsCompaction()) {
+		startCompaction();
+	}
+
+	contents.losses = std::move(replay.losses);
+	collect(replay.records, contents);
+	return contents;
+}
+
+void ScoreJournal::compact()
+{
+	std::lock_guard lock(m_mutex);
+	startCompaction();
+}
+
+bool ScoreJournal::needsCompaction() const
+{
+	// The compaction is started only once the journal is followed, it would race the import of the loading.
+	return m_tail != -1 && m_journalEntries > COMPACTION_THRESHOLD;
+}
+
+void ScoreJournal::startCompaction()
+{
+	if (m_compacting || m_scheduler == nullptr) {
+		return;
+	}
+
+	m_compacting = true;
+	m_scheduler->submit([this] {
+		runCompaction();
+
+		// The journal may be destroyed as soon as the mutex is released.
+		std::lock_guard lock(m_mutex);
+		m_compacting = false;
+		m_compacted.notify_all();
+	});
+}
+
+std::pair<uint32_t, size_t> ScoreJournal::replay(const std::string &path, Replay &replay)
+{
+	MappedFile file(path);
+	if (!file.isOpen()) {
+		return { 0, 0 };
+	}
+
+	auto data = file.data();
+	uint32_t magic;
+	uint32_t version;
+	if (!take(data, magic) || !take(data, version)
+		|| magic != JOURNAL_MAGIC || version == 0 || version > JOURNAL_VERSION)
+	{
+		return { 0, 0 };
+	}
+
+	replay.ids.clear();
+	auto read = parse(data, version, replay);
+
+	return { version, file.size() - data.size() + read };
+}
+
+size_t ScoreJournal::parse(std::string_view data, uint32_t version, Replay &replay)
+{
+	static constexpr uint32_t marker = ENTRY_MARKER;
+	static const std::string_view markerBytes(reinterpret_cast<const char *>(&marker), sizeof(marker));
+
+	bool framed = version >= 2;
+	size_t offset = 0;
+
+	while (offset < data.size()) {
+		auto remaining = data.substr(offset);
+		uint32_t entryMarker = ENTRY_MARKER;
+		uint32_t size;
+		uint32_t checksum;
+
+		if ((framed && !take(remaining, entryMarker)) || !take(remaining, size) || !take(remaining, checksum)) {
+			break;
+		}
+
+		bool valid = entryMarker == ENTRY_MARKER;
+		if (valid && remaining.size() < size) {
+			// The entry is not complete yet, it may still be being written.
+			break;
+		}
+
+		auto payload = remaining.substr(0, size);
+		if (!valid || crc32(payload) != checksum) {
+			if (!framed) {
+				break;
+			}
+
+			// Torn entry, continue with the next one.
+			auto next = data.find(markerBytes, offset + 1);
+			if (next == std::string_view::npos) {
+				break;
+			}
+			offset = next;
+			continue;
+		}
+
+		apply(payload, replay);
+		offset = data.size() - remaining.size() + size;
+		replay.entries++;
+	}
+
+	return offset;
+}
+
+void ScoreJournal::apply(std::string_view payload, Replay &replay)
+{
+	EntryType type;
+	if (!take(payload, type)) {
+		return;
+	}
+
+	switch (type) {
+	case EntryType::PackedRecord: {
+		int32_t difficulty;
+		ScoreRecord record {};
+		if (!take(payload, difficulty)
+			|| (payload.size() != sizeof(ScoreRecord) && payload.size() != SCORE_RECORD_V1_SIZE))
+		{
+			return;
+		}
+
+		// The fields missing in the older records stay zero.
+		std::memcpy(&record, payload.data(), payload.size());
+
+		auto id = replay.ids.find(record.name);
+		record.name = id != replay.ids.end() ? id->second : NamePool::EMPTY;
+		replay.records[difficulty].push_back(record);
+		break;
+	}
+	case EntryType::Loss: {
+		int32_t difficulty;
+		uint32_t name;
+		uint64_t count;
+		if (!take(payload, difficulty) || !take(payload, name) || !take(payload, count) || !payload.empty()) {
+			return;
+		}
+
+		auto id = replay.ids.find(name);
+		replay.losses[{ difficulty, id != replay.ids.end() ? id->second : NamePool::EMPTY }] += count;
+		break;
+	}
+	case EntryType::Name: {
+		uint32_t id;
+		if (take(payload, id)) {
+			replay.ids[id] = m_names.intern(payload);
+		}
+		break;
+	}
+	case EntryType::Record: {
+		int32_t difficulty;
+		int64_t score;
+		int32_t width;
+		int32_t height;
+		int32_t numberOfMines;
+		uint64_t hash;
+		uint16_t nameSize;
+
+		if (!take(payload, difficulty) || !take(payload, score) || !take(payload, width)
+			|| !take(payload, height) || !take(payload, numberOfMines) || !take(payload, hash)
+			|| !take(payload, nameSize) || payload.size() != nameSize)
+		{
+			return;
+		}
+
+		replay.records[difficulty].push_back({
+			.score = score,
+			.hash = hash,
+			.name = m_names.intern(payload),
+			.width = static_cast<uint16_t>(width),
+			.height = static_cast<uint16_t>(height),
+			.numberOfMines = static_cast<uint32_t>(numberOfMines),
+			.time = 0,
+			.bbbv = 0,
+			.clicks = 0,
+		});
+		break;
+	}
+	case EntryType::SortOrder: {
+		int32_t order;
+		if (take(payload, order)) {
+			replay.sortOrder = order;
+		}
+		break;
+	}
+	}
+}
+
+void ScoreJournal::collect(Records &records, ScoreFile::Contents &contents)
+{
+	std::unordered_set<size_t> seen;
+
+	for (auto &[difficulty, section] : records) {
+		std::erase_if(section, [&seen](const ScoreRecord &record) {
+			return !seen.insert(record.hash).second;
+		});
+		contents.sections[difficulty].push(section.begin(), section.end());
+	}
+}
+
+std::string ScoreJournal::encode(long difficulty, const ScoreRecord &record)
+{
+	std::string payload;
+	payload.reserve(sizeof(EntryType) + sizeof(int32_t) + sizeof(ScoreRecord));
+
+	put(payload, EntryType::PackedRecord);
+	put(payload, static_cast<int32_t>(difficulty));
+	put(payload, record);
+
+	return payload;
+}
+
+std::string ScoreJournal::encodeName(uint32_t id, std::string_view name)
+{
+	std::string payload;
+	payload.reserve(sizeof(EntryType) + sizeof(uint32_t) + name.size());
+
+	put(payload, EntryType::Name);
+	put(payload, id);
+	payload.append(name);
+
+	return payload;
+}
+
+std::string ScoreJournal::encodeLoss(long difficulty, uint32_t name, uint64_t count)
+{
+	std::string payload;
+	put(payload, EntryType::Loss);
+	put(payload, static_cast<int32_t>(difficulty));
+	put(payload, name);
+	put(payload, count);
+	return payload;
+}
+
+std::string ScoreJournal::encode(int sortOrder)
+{
+	std::string payload;
+	put(payload, EntryType::SortOrder);
+	put(payload, static_cast<int32_t>(sortOrder));
+	return payload;
+}
+
+std::string ScoreJournal::entry(std::string_view payload, uint32_t version)
+{
+	std::string data;
+	data.reserve(3 * sizeof(uint32_t) + payload.size());
+
+	if (version >= 2) {
+		put(data, ENTRY_MARKER);
+	}
+	put(data, static_cast<uint32_t>(payload.size()));
+	put(data, crc32(payload));
+	data.append(payload);
+
+	return data;
+}
+
+std::string ScoreJournal::header()
+{
+	std::string data;
+	put(data, JOURNAL_MAGIC);
+	put(data, JOURNAL_VERSION);
+	return data;
+}
+
+int ScoreJournal::lockFile()
+{
+	if (m_lock == -1) {
+		m_lock = ::open(m_lockPath.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+	}
+	return m_lock;
+}
+
+void ScoreJournal::createJournal()
+{
+	if (std::filesystem::exists(m_journalPath)) {
+		return;
+	}
+
+	auto temporary = temporaryPath(m_journalPath);
+	int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (fd == -1) {
+		return;
+	}
+
+	bool written = writeAll(fd, header()) && ::fsync(fd) == 0;
+	::close(fd);
+
+	// Fails if another instance created the journal in the meantime, which is fine.
+	if (written) {
+		::link(temporary.c_str(), m_journalPath.c_str());
+	}
+	::unlink(temporary.c_str());
+}
+
+std::string ScoreJournal::writeSnapshot(const ScoreFile::Contents &contents)
+{
+	std::string data = header();
+	data += entry(encode(contents.sortOrder), JOURNAL_VERSION);
+
+	std::unordered_set<uint32_t> names;
+	for (auto &[difficulty, section] : contents.sections) {
+		for (auto &record : section) {
+			if (names.insert(record.name).second) {
+				data += entry(encodeName(record.name, m_names.name(record.name)), JOURNAL_VERSION);
+			}
+			data += entry(encode(difficulty, record), JOURNAL_VERSION);
+		}
+	}
+
+	for (auto &[key, count] : contents.losses) {
+		auto [difficulty, name] = key;
+		if (names.insert(name).second) {
+			data += entry(encodeName(name, m_names.name(name)), JOURNAL_VERSION);
+		}
+		data += entry(encodeLoss(difficulty, name, count), JOURNAL_VERSION);
+	}
+
+	auto temporary = temporaryPath(m_snapshotPath);
+	int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (fd == -1) {
+		return {};
+	}
+
+	bool written = writeAll(fd, data) && ::fsync(fd) == 0;
+	::close(fd);
+
+	if (!written) {
+		::unlink(temporary.c_str());
+		return {};
+	}
+	return temporary;
+}
+
+void ScoreJournal::write(std::initializer_list<std::string> payloads)
+{
+	if (m_journal == -1 || !sameFile(m_journal, m_journalPath)) {
+		if (m_journal != -1) {
+			::close(m_journal);
+		}
+
+		createJournal();
+		m_journal = ::open(m_journalPath.c_str(), O_RDWR | O_APPEND | O_CLOEXEC);
+		if (m_journal == -1) {
+			return;
+		}
+
+		uint32_t head[2] = {};
+		m_journalVersion = ::pread(m_journal, head, sizeof(head), 0) == sizeof(head) ? head[1] : JOURNAL_VERSION;
+	}
+
+	std::string data;
+	for (auto &payload : payloads) {
+		data += entry(payload, m_journalVersion);
+	}
+
+	// One write per call, entries of other instances can not end up in the middle.
+	writeAll(m_journal, data);
+	::fdatasync(m_journal);
+	m_journalEntries += payloads.size();
+}
+
+void ScoreJournal::readTail(Replay &replay)
+{
+	struct stat info;
+	if (m_tail == -1 || ::fstat(m_tail, &info) != 0 || static_cast<size_t>(info.st_size) <= m_tailOffset) {
+		return;
+	}
+
+	std::string buffer(info.st_size - m_tailOffset, '\0');
+	auto count = ::pread(m_tail, buffer.data(), buffer.size(), m_tailOffset);
+	if (count <= 0) {
+		return;
+	}
+
+	std::string_view data(buffer.data(), count);
+	if (m_tailOffset == 0) {
+		uint32_t magic;
+		if (!take(data, magic) || !take(data, m_tailVersion) || magic != JOURNAL_MAGIC) {
+			return;
+		}
+		m_tailOffset = 2 * sizeof(uint32_t);
+	}
+
+	replay.ids = std::move(m_tailIds);
+	m_tailOffset += parse(data, m_tailVersion, replay);
+	m_tailIds = std::move(replay.ids);
+}
+
+void ScoreJournal::dropPending(Replay &replay)
+{
+	for (auto &[difficulty, section] : replay.records) {
+		std::erase_if(section, [this](const ScoreRecord &record) {
+			return m_pending.erase(record.hash) > 0;
+		});
+	}
+
+	for (auto it = replay.losses.begin(); it != replay.losses.end();) {
+		auto pending = m_pendingLosses.find(it->first);
+		if (pending != m_pendingLosses.end()) {
+			auto own = std::min(pending->second, it->second);
+			it->second -= own;
+			pending->second -= own;
+			if (pending->second == 0) {
+				m_pendingLosses.erase(pending);
+			}
+		}
+		it = it->second == 0 ? replay.losses.erase(it) : std::next(it);
+	}
+}
+
+void ScoreJournal::runCompaction()
+{
+	int compactor = ::open(m_compactorPath.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+	if (compactor == -1 || ::flock(compactor, LOCK_EX | LOCK_NB) != 0) {
+		// Another instance is compacting.
+		if (compactor != -1) {
+			::close(compactor);
+		}
+		return;
+	}
+
+	{
+		std::lock_guard lock(m_mutex);
+		FileLock exclusive(lockFile(), LOCK_EX);
+
+		// A leftover from an interrupted compaction is merged first, the journal waits for the next one.
+		if (!std::filesystem::exists(m_compactingPath)) {
+			std::error_code error;
+			std::filesystem::rename(m_journalPath, m_compactingPath, error);
+			if (!error) {
+				createJournal();
+				m_journalEntries = 0;
+			}
+		}
+	}
+
+	// Only the holder of the compactor lock changes the snapshot and the compacted journal.
+	Replay replay;
+	this->replay(m_snapshotPath, replay);
+	this->replay(m_compactingPath, replay);
+
+	ScoreFile::Contents contents { .sortOrder = replay.sortOrder, .sections = {}, .losses = std::move(replay.losses) };
+	collect(replay.records, contents);
+
+	auto temporary = writeSnapshot(contents);
+	if (!temporary.empty()) {
+		std::lock_guard lock(m_mutex);
+		FileLock exclusive(lockFile(), LOCK_EX);
+
+		std::error_code error;
+		std::filesystem::rename(temporary, m_snapshotPath, error);
+		if (!error) {
+			std::filesystem::remove(m_compactingPath, error);
+		}
+	}
+
+	::flock(compactor, LOCK_UN);
+	::close(compactor);
+}
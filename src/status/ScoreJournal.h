@@ -0,0 +1,266 @@
+#pragma once
+
+#include "NamePool.h"
+#include "Scheduler.h"
+#include "ScoreFile.h"
+#include "ScoreRecord.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <initializer_list>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+/**
+ * @class ScoreJournal
+ * @brief Crash safe persistent storage of the leaderboard shared by all the running instances.
+ *
+ * Every new record is appended to the journal file as soon as it is earned. An entry is written with a single
+ * @c write call to a file opened with @c O_APPEND, so entries of several processes never interleave and no
+ * process waits for another one to append. Every entry starts with a marker and carries its own checksum, so a
+ * torn entry left behind by a crash is skipped and the entries behind it are still read.
+ *
+ * Records are stored in their binary form. Every record is preceded by the entry mapping its name ID to the name,
+ * because the processes sharing the journal do not share the IDs.
+ *
+ * Each instance follows the journal from the position it loaded it to, see @c poll, so the records of the other
+ * instances show up without reloading the files.
+ *
+ * Once the journal grows past a threshold by the appends of any instance, it is compacted by a task of the
+ * @c Scheduler into a snapshot file holding all the records sorted by difficulty and score. The state of the
+ * leaderboard is the snapshot followed by the journal.
+ *
+ * Files used by the journal with the base name "scores":
+ *  - scores.snapshot   Compacted and sorted records.
+ *  - scores.journal    Records appended since the last compaction.
+ *  - scores.compacting Journal being merged into the snapshot. It is removed when the compaction finishes.
+ *  - scores.lock       Taken shared to append and read, exclusively to rotate the journal or replace the snapshot.
+ *  - scores.compactor  Held by the only process running the compaction.
+ */
+class ScoreJournal
+{
+public:
+	/**
+	 * @brief Create the journal.
+	 *
+	 * No file is touched until @c load or @c append is called.
+	 *
+	 * @param name Base name of the journal files.
+	 * @param names Pool of the player names used by the records.
+	 * @param scheduler Workers parsing the legacy file and compacting the journal, it has to outlive the journal.
+	 *        Without it the legacy file is parsed on the calling thread and this instance never compacts the
+	 *        journal, e.g. in the tools only reading it.
+	 */
+	explicit ScoreJournal(const std::string &name, NamePool &names, Scheduler *scheduler = nullptr);
+	ScoreJournal(const ScoreJournal &) = delete;
+	ScoreJournal &operator=(const ScoreJournal &) = delete;
+
+	/// Wait for the running compaction and close the journal.
+	~ScoreJournal();
+
+	/**
+	 * @brief Replay the snapshot and the journal.
+	 *
+	 * If neither of them exists, the records are imported from the @c legacyFile in the text format and stored
+	 * in a new snapshot. If the journal grew too large, a background compaction is started.
+	 *
+	 * The files are read without blocking @c append, so a record earned while loading is stored right away.
+	 *
+	 * @param legacyFile Path to the score file written by older versions.
+	 * @return The sort order and all the records grouped by the difficulty.
+	 */
+	ScoreFile::Contents load(const std::string &legacyFile);
+
+	/**
+	 * @brief Append a record to the journal.
+	 *
+	 * @param difficulty Difficulty the record belongs to.
+	 * @param record The record to be stored.
+	 */
+	void append(long difficulty, const ScoreRecord &record);
+
+	/**
+	 * @brief Append a lost game to the journal.
+	 *
+	 * @param difficulty Difficulty of the lost game.
+	 * @param name Name ID of the player.
+	 */
+	void appendLoss(long difficulty, uint32_t name);
+
+	/// Append a change of the sort order to the journal.
+	void appendSortOrder(int sortOrder);
+
+	/**
+	 * @brief Read the records and losses appended by the other instances since the last call.
+	 *
+	 * Only the part of the journal that was not read yet is read. The records and losses appended by this instance
+	 * and the sort order changes are skipped.
+	 *
+	 * @return The new records grouped by the difficulty and the new losses.
+	 */
+	ScoreFile::Contents poll();
+
+	/**
+	 * @brief Start merging the journal into the snapshot on a worker of the scheduler.
+	 *
+	 * New records are appended to a fresh journal while the compaction runs. If a compaction is already running
+	 * in this or another process or the journal has no scheduler, this call does nothing.
+	 */
+	void compact();
+
+private:
+	/// Records read from the files before they are deduplicated and sorted.
+	using Records = std::map<long, std::vector<ScoreRecord>>;
+
+	/// Type of the journal entry.
+	enum class EntryType : uint8_t
+	{
+		/// Record with the name stored inline, written only by the first version of the journal.
+		Record,
+		SortOrder,
+		/// Mapping of the name ID used in the file to the name.
+		Name,
+		/// Difficulty followed by the binary @c ScoreRecord, the records of older versions are shorter.
+		PackedRecord,
+		/// Difficulty, name ID and the number of the lost games.
+		Loss,
+	};
+
+	/// State of reading one file.
+	struct Replay
+	{
+		Records records;
+		ScoreFile::Losses losses;
+		int sortOrder = 0;
+		size_t entries = 0;
+		/// Name IDs used in the file mapped to the IDs of the pool.
+		std::unordered_map<uint32_t, uint32_t> ids;
+	};
+
+	/**
+	 * @brief Read all the valid entries of the file.
+	 *
+	 * @param path Path to the snapshot or journal file.
+	 * @param replay State updated by the entries of the file.
+	 * @return The version of the file, zero if the file does not exist or is not valid, and the size of the
+	 * read part of the file in bytes.
+	 */
+	std::pair<uint32_t, size_t> replay(const std::string &path, Replay &replay);
+
+	/**
+	 * @brief Read the entries from the data following the file header.
+	 *
+	 * Reading stops at the first incomplete entry. Corrupted entries are skipped in the files with the entry
+	 * markers, the first version of the format stops at them.
+	 *
+	 * @return Number of bytes read.
+	 */
+	size_t parse(std::string_view data, uint32_t version, Replay &replay);
+
+	/// Apply one entry to the replay state. Unknown and malformed entries are ignored.
+	void apply(std::string_view payload, Replay &replay);
+
+	/**
+	 * @brief Drop the duplicates and sort the records.
+	 *
+	 * A record can be read twice if the application stopped after the snapshot was written but before
+	 * the compacted journal was removed. The records are identified by their hash.
+	 */
+	static void collect(Records &records, ScoreFile::Contents &contents);
+
+	/// Serialize the record entry.
+	static std::string encode(long difficulty, const ScoreRecord &record);
+
+	/// Serialize the name entry.
+	static std::string encodeName(uint32_t id, std::string_view name);
+
+	/// Serialize the loss entry.
+	static std::string encodeLoss(long difficulty, uint32_t name, uint64_t count);
+
+	/// Serialize the sort order entry.
+	static std::string encode(int sortOrder);
+
+	/// Wrap the payload into an entry with its size and checksum, the entry marker is added since the version 2.
+	static std::string entry(std::string_view payload, uint32_t version);
+
+	/// Header written at the beginning of both the snapshot and the journal.
+	static std::string header();
+
+	/// Open the lock file. Called with the @c m_mutex locked.
+	int lockFile();
+
+	/**
+	 * @brief Create an empty journal with the header unless it already exists.
+	 *
+	 * The journal is created under a temporary name and linked to its path, so other processes never see it
+	 * without the header.
+	 */
+	void createJournal();
+
+	/**
+	 * @brief Write the snapshot to a temporary file.
+	 *
+	 * @return Path to the synced temporary file, empty on an error.
+	 */
+	std::string writeSnapshot(const ScoreFile::Contents &contents);
+
+	/**
+	 * @brief Write the entries to the journal in a single write.
+	 *
+	 * The journal is reopened if it was rotated by a compaction. Called with the @c m_mutex and the shared file
+	 * lock held.
+	 *
+	 * @param payloads Payloads of the entries.
+	 */
+	void write(std::initializer_list<std::string> payloads);
+
+	/// Read the new part of the followed journal. Called with the @c m_mutex and the shared file lock held.
+	void readTail(Replay &replay);
+
+	/// Drop the records and losses appended by this instance from the replay. Called with the @c m_mutex locked.
+	void dropPending(Replay &replay);
+
+	/// True if the followed journal grew too large. Called with the @c m_mutex locked.
+	bool needsCompaction() const;
+
+	/// Start the compaction unless it is already running. Called with the @c m_mutex locked.
+	void startCompaction();
+
+	/// Body of the compaction task.
+	void runCompaction();
+
+private:
+	std::string m_snapshotPath;
+	std::string m_journalPath;
+	std::string m_compactingPath;
+	std::string m_lockPath;
+	std::string m_compactorPath;
+	NamePool &m_names;
+	Scheduler *m_scheduler;
+
+	std::mutex m_mutex;
+	int m_lock;
+	int m_journal;
+	uint32_t m_journalVersion;
+	size_t m_journalEntries;
+
+	/// Descriptor of the followed journal, it stays valid when the journal is rotated.
+	int m_tail;
+	size_t m_tailOffset;
+	uint32_t m_tailVersion;
+	std::unordered_map<uint32_t, uint32_t> m_tailIds;
+	/// Hashes of the records appended by this instance that were not read back from the journal yet.
+	std::unordered_set<uint64_t> m_pending;
+	/// Losses appended by this instance that were not read back from the journal yet.
+	ScoreFile::Losses m_pendingLosses;
+
+	/// The compaction task was submitted and did not finish yet, guarded by the @c m_mutex.
+	bool m_compacting;
+	std::condition_variable m_compacted;
+};
@@ -0,0 +1,55 @@
+#include "ScoreRecord.h"
+
+#define FNV_OFFSET 0xcbf29ce484222325
+#define FNV_PRIME 0x100000001b3
+
+namespace
+{
+
+void fnv(uint64_t &hash, std::string_view data)
+{
+	for (unsigned char byte : data) {
+		hash = (hash ^ byte) * FNV_PRIME;
+	}
+}
+
+template <typename T>
+void fnv(uint64_t &hash, T value)
+{
+	fnv(hash, std::string_view(reinterpret_cast<const char *>(&value), sizeof(T)));
+}
+
+}
+
+uint64_t recordHash(const ScoreRecord &record, std::string_view name, std::string_view replay)
+{
+	uint64_t hash = FNV_OFFSET;
+	fnv(hash, replay);
+	// The sizes keep the name apart from the replay.
+	fnv(hash, static_cast<uint64_t>(replay.size()));
+	fnv(hash, name);
+	fnv(hash, static_cast<uint64_t>(name.size()));
+	fnv(hash, record.score);
+	fnv(hash, record.width);
+	fnv(hash, record.height);
+	fnv(hash, record.numberOfMines);
+	fnv(hash, record.time);
+	fnv(hash, record.bbbv);
+	fnv(hash, record.clicks);
+	return hash;
+}
+
+bool operator==(const ScoreRecord &lhs, const ScoreRecord &rhs)
+{
+	return lhs.hash == rhs.hash;
+}
+
+bool operator>(const ScoreRecord &lhs, const ScoreRecord &rhs)
+{
+	return lhs.score > rhs.score;
+}
+
+bool operator<(const ScoreRecord &lhs, const ScoreRecord &rhs)
+{
+	return lhs.score < rhs.score;
+}
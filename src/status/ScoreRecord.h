@@ -0,0 +1,71 @@
+#pragma once
+
+#include "records/DynamicPriorityQueue.h"
+
+#include <cstdint>
+#include <format>
+#include <string_view>
+#include <type_traits>
+
+/**
+ * @brief One record of the leaderboard.
+ *
+ * The record is a fixed size POD, so it can be written to and read from the files directly and large leaderboards
+ * are sorted by moving 40 byte blocks. New fields are only appended, so the older records are a prefix of it. The
+ * player name is stored as an ID of the @c NamePool.
+ */
+struct ScoreRecord {
+	int64_t score;
+	uint64_t hash;
+	/// ID of the player name in the @c NamePool.
+	uint32_t name;
+	uint16_t width;
+	uint16_t height;
+	uint32_t numberOfMines;
+	/// Time taken to solve the board in seconds, zero in the records of older versions.
+	uint32_t time;
+	/// 3BV of the board, zero in the records of older versions.
+	uint32_t bbbv;
+	/// Clicks made to solve the board, zero in the records of older versions.
+	uint32_t clicks;
+
+	/// 3BV solved per second.
+	double bbbvPerSecond() const { return time ? static_cast<double>(bbbv) / time : 0; }
+
+	/// Ratio of the 3BV to the clicks made, 1 means no click was wasted.
+	double efficiency() const { return clicks ? static_cast<double>(bbbv) / clicks : 0; }
+};
+
+static_assert(std::is_trivially_copyable_v<ScoreRecord> && std::is_standard_layout_v<ScoreRecord>);
+static_assert(sizeof(ScoreRecord) == 40);
+
+/// Size of the records written before the 3BV was added, they are the prefix of the current layout.
+#define SCORE_RECORD_V1_SIZE 32
+
+using DifficultyTab = DynamicPriorityQueue<ScoreRecord>;
+
+/**
+ * @brief Hash identifying the record, derived from the replay of the game and the result.
+ *
+ * The replay file of the record is named by the hash, so the verifier recomputes it from the file and a replay can
+ * not pass for the record of another game. FNV-1a is used, so the hash is the same in every build.
+ *
+ * @param record The record, its own hash is not used.
+ * @param name Name of the player of the record.
+ * @param replay The encoded replay of the game, see @c Replay::encode.
+ */
+uint64_t recordHash(const ScoreRecord &record, std::string_view name, std::string_view replay);
+
+bool operator==(const ScoreRecord &lhs, const ScoreRecord &rhs);
+bool operator>(const ScoreRecord &lhs, const ScoreRecord &rhs);
+bool operator<(const ScoreRecord &lhs, const ScoreRecord &rhs);
+
+template <>
+struct std::formatter<ScoreRecord> {
+	constexpr auto parse(std::format_parse_context& ctx) { return ctx.begin(); }
+
+	template <typename FormatContext>
+	auto format(const ScoreRecord& record, FormatContext& ctx) const {
+		return std::format_to(ctx.out(), "{} {} {} {}", record.score, record.name, record.numberOfMines, record.hash);
+	}
+};
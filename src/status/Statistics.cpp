@@ -0,0 +1,61 @@
+#include "Statistics.h"
+
+#include <algorithm>
+
+namespace
+{
+
+const Statistics::Aggregate EMPTY_AGGREGATE;
+
+}
+
+Statistics::Summary::Summary()
+	: m_count(0)
+	, m_sum(0)
+	, m_min(std::numeric_limits<double>::max())
+	, m_max(std::numeric_limits<double>::lowest())
+	, m_p50(0.5)
+	, m_p90(0.9)
+	, m_p99(0.99)
+{
+}
+
+void Statistics::Summary::add(double value)
+{
+	m_count++;
+	m_sum += value;
+	m_min = std::min(m_min, value);
+	m_max = std::max(m_max, value);
+	m_p50.add(value);
+	m_p90.add(value);
+	m_p99.add(value);
+}
+
+void Statistics::addWin(long difficulty, const ScoreRecord &record)
+{
+	for (auto *aggregate : { &m_difficulties[difficulty], &m_players[record.name] }) {
+		aggregate->wins++;
+		aggregate->score.add(record.score);
+		if (record.time != 0) {
+			aggregate->time.add(record.time);
+		}
+	}
+}
+
+void Statistics::addLosses(long difficulty, uint32_t name, uint64_t count)
+{
+	m_difficulties[difficulty].losses += count;
+	m_players[name].losses += count;
+}
+
+const Statistics::Aggregate &Statistics::difficulty(long difficulty) const
+{
+	auto it = m_difficulties.find(difficulty);
+	return it != m_difficulties.end() ? it->second : EMPTY_AGGREGATE;
+}
+
+const Statistics::Aggregate &Statistics::player(uint32_t name) const
+{
+	auto it = m_players.find(name);
+	return it != m_players.end() ? it->second : EMPTY_AGGREGATE;
+}
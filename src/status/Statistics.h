@@ -0,0 +1,90 @@
+#pragma once
+
+#include "QuantileSketch.h"
+#include "ScoreRecord.h"
+
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <unordered_map>
+
+/**
+ * @class Statistics
+ * @brief Aggregated statistics of the leaderboard per difficulty and per player.
+ *
+ * The aggregates are updated incrementally as the games are added, every update and every query takes constant
+ * time regardless of the number of the games played. The percentiles are estimated by @c QuantileSketch.
+ */
+class Statistics
+{
+public:
+	/// Streaming summary of one measured value.
+	class Summary
+	{
+	public:
+		Summary();
+
+		/// Add a value to the summary.
+		void add(double value);
+
+		uint64_t count() const { return m_count; }
+		double min() const { return m_count ? m_min : 0; }
+		double max() const { return m_count ? m_max : 0; }
+		double mean() const { return m_count ? m_sum / m_count : 0; }
+		double p50() const { return m_p50.value(); }
+		double p90() const { return m_p90.value(); }
+		double p99() const { return m_p99.value(); }
+
+	private:
+		uint64_t m_count;
+		double m_sum;
+		double m_min;
+		double m_max;
+		QuantileSketch m_p50;
+		QuantileSketch m_p90;
+		QuantileSketch m_p99;
+	};
+
+	/// Aggregate of a group of games.
+	struct Aggregate
+	{
+		uint64_t wins = 0;
+		uint64_t losses = 0;
+		/// Scores of the won games, the best score is the maximum.
+		Summary score;
+		/// Times of the won games in seconds, the best time is the minimum.
+		Summary time;
+
+		uint64_t games() const { return wins + losses; }
+		double winRate() const { return games() ? static_cast<double>(wins) / games() : 0; }
+	};
+
+	/**
+	 * @brief Add a won game.
+	 *
+	 * Records written by older versions do not carry the time, they are left out of the time summary.
+	 *
+	 * @param difficulty Difficulty of the game.
+	 * @param record The record of the game.
+	 */
+	void addWin(long difficulty, const ScoreRecord &record);
+
+	/**
+	 * @brief Add lost games.
+	 *
+	 * @param difficulty Difficulty of the games.
+	 * @param name Name ID of the player.
+	 * @param count Number of the lost games.
+	 */
+	void addLosses(long difficulty, uint32_t name, uint64_t count = 1);
+
+	/// Aggregate of all the games of the difficulty.
+	const Aggregate &difficulty(long difficulty) const;
+
+	/// Aggregate of all the games of the player.
+	const Aggregate &player(uint32_t name) const;
+
+private:
+	std::map<long, Aggregate> m_difficulties;
+	std::unordered_map<uint32_t, Aggregate> m_players;
+};
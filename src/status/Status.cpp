@@ -3,47 +3,48 @@
 #include "Status.h"
 #include "imgui.h"
 
-#include <execution>
+#include <cinttypes>
+#include <cstdio>
 #include <filesystem>
-#include <iostream>
-#include <print>
 
 #define RED_COLOR ImVec4(1.0f, 0.0f, 0.0f, 1.0f)
 #define DEFAULT_COLOR ImVec4(1.0f, 1.0f, 1.0f, 1.0f)
 #define SCORE_FILE_NAME "scores.txt"
+#define SCORE_JOURNAL_NAME "scores"
+#define REPLAY_DIRECTORY "replays"
+#define MIN_REPLAY_SPEED 1.0f
+#define MAX_REPLAY_SPEED 1000.0f
 #define INDENT_CUSTOM_SIZE 25
 #define MAX_WIDTH 50
 #define MAX_HEIGHT 40
 #define MIN_SIZE 9
 #define CUSTOM_DIFFICULTY 3
 #define MAX_NAME_SIZE 32
-#define COLUMN_SIZE(dif) (dif == CUSTOM_DIFFICULTY ? 4 : 3)
+#define JOURNAL_POLL_INTERVAL std::chrono::milliseconds(500)
+#define COLUMN_SIZE(dif) (dif == CUSTOM_DIFFICULTY ? 6 : 5)
+#define STATISTICS_COLUMN_SIZE 13
+/// Smaller leaderboards are sorted on the calling thread, they are sorted quicker than handed over to the workers.
+#define PARALLEL_SORT_RECORDS 65536
 
 Status::Status()
 	: Layer("Status")
 	, m_difficulty(0)
 	, m_numberOfMines()
-	, m_scoreFile(SCORE_FILE_NAME, std::ios::in)
+	, m_score()
+	, m_names()
+	, m_journal(nullptr)
 	, m_scores()
+	, m_statistics()
 	, m_name("User")
 	, m_sortOrder(SortOrder::Score)
+	, m_rankedNames(0)
+	, m_localHeight(MIN_SIZE)
+	, m_localWidth(MIN_SIZE)
+	, m_bbbvBand{ 0, 100 }
+	, m_lastReplay()
+	, m_replaySpeed(MIN_REPLAY_SPEED)
+	, m_instantReplay(false)
 {
-	if (!m_scoreFile.is_open()) {
-		std::cout << "Creating new score file" << std::endl;
-		m_scoreFile.open(SCORE_FILE_NAME, std::ios::out);
-		m_scoreFile << (int)m_sortOrder << '\n' << "0\n1\n2\n3" << std::endl;
-		m_scoreFile.close();
-	}
-
-	std::filesystem::path scoreFilePath(SCORE_FILE_NAME);
-	if (std::filesystem::is_empty(SCORE_FILE_NAME)) {
-		m_scoreFile.close();
-		m_scoreFile.open(SCORE_FILE_NAME, std::ios::out);
-		m_scoreFile << m_sortOrder << "\n0\n1\n2\n3" << std::endl;
-		m_scoreFile.close();
-	}
-
-	loadScoreFile();
 	m_name.resize(MAX_NAME_SIZE);
 }
 
@@ -54,19 +55,54 @@ void Status::render()
 		throw std::runtime_error("Could not find board layer");
 	}
 
-	if (board->gameState() == Board::GameState::Win) {
+	if (board->gameState() == Board::GameState::Win && board->assisted()) {
+		// The solver helped, the game is neither scored nor counted, its replay is only kept for the menu.
 		board->ackGameOver();
-		m_score.score = (board->totalNumberOfTiles() * m_numberOfMines - board->elapsedTime()) / board->numberOfClicks();
-		m_score.name = m_name;
-		m_score.width = m_localWidth;
-		m_score.height = m_localHeight;
-		m_score.numberOfMines = m_numberOfMines;
-
-		auto now = std::chrono::system_clock::now();
-		auto time = now.time_since_epoch().count();
-		m_score.hash = std::hash<std::string>()(m_name) ^ std::hash<long>()(time) ^ std::hash<long>()(m_score.score);
+		m_lastReplay = board->recording();
+	}
+	else if (board->gameState() == Board::GameState::Win) {
+		board->ackGameOver();
+		// The fields of the menu may already describe the next game, the record is taken from the finished one.
+		m_score.score =
+			(board->totalNumberOfTiles() * board->totalNumberOfMines() - board->elapsedTime()) / board->numberOfClicks();
+		m_score.name = m_names.intern(m_name.c_str());
+		m_score.width = board->width();
+		m_score.height = board->height();
+		m_score.numberOfMines = board->totalNumberOfMines();
+		m_score.time = std::max(board->elapsedTime(), 0l);
+		m_score.bbbv = board->bbbv();
+		m_score.clicks = board->numberOfClicks();
+
+		// The verifier recomputes the hash from the replay file named by it.
+		m_score.hash = recordHash(m_score, m_names.name(m_score.name), board->recording().encode());
 
 		m_scores[m_difficulty].push(m_score);
+		m_statistics.addWin(m_difficulty, m_score);
+		m_journal->append(m_difficulty, m_score);
+		saveReplay(m_score.hash, board->recording());
+	}
+	else if (board->gameState() == Board::GameState::Lose && board->assisted()) {
+		board->ackGameOver();
+		m_lastReplay = board->recording();
+	}
+	else if (board->gameState() == Board::GameState::Lose) {
+		board->ackGameOver();
+		auto name = m_names.intern(m_name.c_str());
+		m_statistics.addLosses(m_difficulty, name);
+		m_journal->appendLoss(m_difficulty, name);
+
+		// The lost games have no record, they are told apart by the time only.
+		auto time = std::chrono::system_clock::now().time_since_epoch().count();
+		saveReplay(std::hash<std::string>()(m_name) ^ std::hash<long>()(time), board->recording());
+	}
+
+	if (scoreFileLoaded()) {
+		pollScoreJournal();
+
+		// The records of new players are placed by their names.
+		if (m_sortOrder == SortOrder::Alphabetically && m_names.size() > m_rankedNames) {
+			setSortingOrder(m_sortOrder);
+		}
 	}
 
 	ImGui::Begin("Game Status", NULL, m_windowFlags);
@@ -79,19 +115,78 @@ void Status::render()
 
 		if (ImGui::MenuItem("Score", "", m_sortOrder == Status::SortOrder::Score)) {
 			setSortingOrder(Status::SortOrder::Score);
+			m_journal->appendSortOrder(m_sortOrder);
 		}
 		if (ImGui::MenuItem("Alphabetically", "", m_sortOrder == Status::SortOrder::Alphabetically)) {
 			setSortingOrder(Status::SortOrder::Alphabetically);
+			m_journal->appendSortOrder(m_sortOrder);
 		}
 		if (ImGui::MenuItem("Number of mines", "", m_sortOrder == Status::SortOrder::NumberOfMines)) {
 			setSortingOrder(Status::SortOrder::NumberOfMines);
+			m_journal->appendSortOrder(m_sortOrder);
 		}
 		if (ImGui::MenuItem("Board size", "", m_sortOrder == Status::SortOrder::BoardSize)) {
 			setSortingOrder(Status::SortOrder::BoardSize);
+			m_journal->appendSortOrder(m_sortOrder);
+		}
+		ImGui::EndMenu();
+	}
+
+	if (ImGui::BeginMenu("Solver")) {
+		if (ImGui::MenuItem("Hint")) {
+			board->hint();
+		}
+		if (ImGui::MenuItem("Auto-solve", "", board->autoSolve())) {
+			board->setAutoSolve(!board->autoSolve());
+		}
+		if (ImGui::MenuItem("Probability heatmap", "", board->heatmap())) {
+			board->setHeatmap(!board->heatmap());
+		}
+		if (ImGui::MenuItem("No-guess boards", "", board->noGuess())) {
+			board->setNoGuess(!board->noGuess());
+		}
+		if (ImGui::MenuItem("Target 3BV", "", board->hasBbbvBand())) {
+			if (board->hasBbbvBand()) {
+				board->clearBbbvBand();
+			}
+			else {
+				board->setBbbvBand(m_bbbvBand[0], m_bbbvBand[1]);
+			}
+		}
+		if (board->hasBbbvBand() && ImGui::InputInt2("3BV band", m_bbbvBand)) {
+			board->setBbbvBand(m_bbbvBand[0], m_bbbvBand[1]);
+		}
+		ImGui::EndMenu();
+	}
+
+	if (ImGui::BeginMenu("Practice")) {
+		if (ImGui::MenuItem("Practice mode", "", board->practice())) {
+			board->setPractice(!board->practice());
+		}
+		if (ImGui::MenuItem("Undo", "Ctrl+Z", false, board->canUndo())) {
+			board->undo();
+		}
+		if (ImGui::MenuItem("Redo", "Ctrl+Y", false, board->canRedo())) {
+			board->redo();
 		}
 		ImGui::EndMenu();
 	}
 
+	if (ImGui::BeginMenu("Replay")) {
+		if (ImGui::MenuItem("Last game", "", false, !m_lastReplay.empty())) {
+			playReplay(m_lastReplay);
+		}
+		if (ImGui::MenuItem("Instant", "", m_instantReplay)) {
+			m_instantReplay = !m_instantReplay;
+		}
+		if (!m_instantReplay) {
+			ImGui::SliderFloat("Speed", &m_replaySpeed, MIN_REPLAY_SPEED, MAX_REPLAY_SPEED, "%.0fx",
+				ImGuiSliderFlags_Logarithmic);
+		}
+		ImGui::TextDisabled("Double-click a leaderboard row to replay it");
+		ImGui::EndMenu();
+	}
+
 	ImGui::EndMainMenuBar();
 
 	ImGui::InputText("Player name", m_name.data(), MAX_NAME_SIZE);
@@ -138,10 +233,7 @@ void Status::render()
 		if (ImGui::Button("Apply")) {
 
 			// Limit the width and height
-			board->width() = m_localWidth;
-			board->height() = m_localHeight;
-
-			board->setupEmptyTiles();
+			board->resize(m_localWidth, m_localHeight);
 			m_numberOfMines = (m_localWidth * m_localHeight) / 5;
 			board->setNumberOfMines(m_numberOfMines);
 			board->resetTimer();
@@ -170,7 +262,23 @@ void Status::render()
 			if (!ImGui::BeginTabItem(difficultyString(i).c_str()))
 				continue;
 
-			createTabTable(i);
+			if (scoreFileLoaded()) {
+				createTabTable(i);
+			}
+			else {
+				ImGui::TextDisabled("Loading leaderboard...");
+			}
+
+			ImGui::EndTabItem();
+		}
+
+		if (ImGui::BeginTabItem("Statistics")) {
+			if (scoreFileLoaded()) {
+				createStatisticsTable();
+			}
+			else {
+				ImGui::TextDisabled("Loading leaderboard...");
+			}
 
 			ImGui::EndTabItem();
 		}
@@ -198,6 +306,9 @@ void Status::onAttach()
 {
 	auto board = app().getLayer<Board>("Board");
 	m_numberOfMines = board->totalNumberOfMines();
+
+	m_journal = std::make_unique<ScoreJournal>(SCORE_JOURNAL_NAME, m_names, &app().scheduler());
+	loadScoreFile();
 }
 
 void Status::setSortingOrder(SortOrder order)
@@ -209,15 +320,21 @@ void Status::setSortingOrder(SortOrder order)
 		case SortOrder::Score:
 			compare = std::greater<ScoreRecord>();
 			break;
-		case SortOrder::Alphabetically:
-			compare = [](const ScoreRecord &lhs, const ScoreRecord &rhs) {
+		case SortOrder::Alphabetically: {
+			// The names interned after the ranking sort behind the ranked ones until the names are ranked again.
+			auto ranks = std::make_shared<const std::vector<uint32_t>>(m_names.ranks());
+			m_rankedNames = ranks->size();
+			compare = [ranks](const ScoreRecord &lhs, const ScoreRecord &rhs) {
 				if (lhs.name == rhs.name) {
 					return lhs.score > rhs.score;
 				}
 
-				return lhs.name < rhs.name;
+				auto lhsRank = lhs.name < ranks->size() ? (*ranks)[lhs.name] : lhs.name;
+				auto rhsRank = rhs.name < ranks->size() ? (*ranks)[rhs.name] : rhs.name;
+				return lhsRank < rhsRank;
 			};
 			break;
+		}
 		case SortOrder::NumberOfMines:
 			compare = [](const ScoreRecord &lhs, const ScoreRecord &rhs) {
 				if (lhs.numberOfMines == rhs.numberOfMines) {
@@ -241,36 +358,18 @@ void Status::setSortingOrder(SortOrder order)
 			break;
 	}
 
-	std::for_each(std::execution::par_unseq, m_scores.begin(), m_scores.end(), [compare](auto &score) {
-		score.second.setSorter(compare);
-	});
+	for (auto &[difficulty, tab] : m_scores) {
+		tab.setSorter(compare, /*invoke*/ false);
+		app().scheduler().sort(tab.begin(), tab.end(), compare, PARALLEL_SORT_RECORDS);
+	}
 }
 
 Status::~Status()
 {
-	m_scoreFile.close();
-	m_scoreFile.open(SCORE_FILE_NAME, std::ios::out);
-
-	std::println(m_scoreFile, "{}", (int)m_sortOrder);
-
-	for (auto &score : m_scores) {
-		// Printing difficulty
-		m_scoreFile << score.first << '\n';
-		for (auto &record : score.second) {
-			// printing score, name, numebr of mines and hash
-			std::print(m_scoreFile, "{} {} {} {}", record.score, record.name, record.numberOfMines, record.hash);
-
-			if (score.first == CUSTOM_DIFFICULTY) {
-				// printing width and height
-				std::print(m_scoreFile, " {} {}", record.width, record.height);
-			}
-
-			std::print(m_scoreFile, "\n");
-		}
+	// Every record is already in the journal, only the loader has to be stopped.
+	if (m_scoreLoader.valid()) {
+		m_scoreLoader.wait();
 	}
-
-	m_scoreFile.flush();
-	m_scoreFile.close();
 }
 
 std::string Status::difficultyString(int difficulty) const
@@ -308,6 +407,8 @@ void Status::createTabTable(int difficulty)
 	ImGui::TableSetupColumn("User name");
 	ImGui::TableSetupColumn("Score");
 	ImGui::TableSetupColumn("Mines");
+	ImGui::TableSetupColumn("3BV/s");
+	ImGui::TableSetupColumn("Efficiency");
 
 	if (difficulty == CUSTOM_DIFFICULTY) {
 		ImGui::TableSetupColumn("Size");
@@ -329,15 +430,29 @@ void Status::createTabTable(int difficulty)
 			ImGui::TableSetColumnIndex(column);
 			switch (column) {
 			case 0:
-				ImGui::Text("%s", diffGrade.name.c_str());
+				ImGui::PushID(&diffGrade);
+				ImGui::Selectable(m_names.name(diffGrade.name).data(), false,
+					ImGuiSelectableFlags_SpanAllColumns | ImGuiSelectableFlags_AllowDoubleClick);
+				if (ImGui::IsItemHovered() && ImGui::IsMouseDoubleClicked(ImGuiMouseButton_Left)) {
+					if (auto replay = Replay::load(replayPath(diffGrade.hash))) {
+						playReplay(*replay);
+					}
+				}
+				ImGui::PopID();
 				break;
 			case 1:
-				ImGui::Text("%ld", diffGrade.score);
+				ImGui::Text("%ld", (long)diffGrade.score);
 				break;
 			case 2:
-				ImGui::Text("%d", diffGrade.numberOfMines);
+				ImGui::Text("%u", diffGrade.numberOfMines);
 				break;
 			case 3:
+				ImGui::Text("%.2f", diffGrade.bbbvPerSecond());
+				break;
+			case 4:
+				ImGui::Text("%.0f%%", diffGrade.efficiency() * 100);
+				break;
+			case 5:
 				ImGui::Text("%dx%d", diffGrade.width, diffGrade.height);
 				break;
 			}
@@ -348,68 +463,195 @@ void Status::createTabTable(int difficulty)
 	ImGui::EndTable();
 }
 
-std::vector<std::string> Status::split(const std::string &s, char delim)
+void Status::createStatisticsTable()
 {
-	std::vector<std::string> elems;
-	std::stringstream ss(s);
-	std::string item;
+	static ImGuiTableFlags flags = ImGuiTableFlags_ScrollX
+		| ImGuiTableFlags_ScrollY
+		| ImGuiTableFlags_BordersOuter
+		| ImGuiTableFlags_BordersV
+		| ImGuiTableFlags_Hideable
+		| ImGuiTableFlags_Resizable
+		| ImGuiTableFlags_RowBg;
+
+	if (!ImGui::BeginTable("Statistics", STATISTICS_COLUMN_SIZE, flags))
+		return;
 
-	while (std::getline(ss, item, delim)) {
-		elems.push_back(item);
+	ImGui::TableSetupScrollFreeze(1, 1);
+	ImGui::TableSetupColumn("");
+	ImGui::TableSetupColumn("Games");
+	ImGui::TableSetupColumn("Win rate");
+	ImGui::TableSetupColumn("Best score");
+	ImGui::TableSetupColumn("Mean score");
+	ImGui::TableSetupColumn("p50 score");
+	ImGui::TableSetupColumn("p90 score");
+	ImGui::TableSetupColumn("p99 score");
+	ImGui::TableSetupColumn("Best time");
+	ImGui::TableSetupColumn("Mean time");
+	ImGui::TableSetupColumn("p50 time");
+	ImGui::TableSetupColumn("p90 time");
+	ImGui::TableSetupColumn("p99 time");
+	ImGui::TableHeadersRow();
+
+	for (int i = 0; i <= CUSTOM_DIFFICULTY; i++) {
+		statisticsRow(difficultyString(i), m_statistics.difficulty(i));
 	}
 
-	return elems;
+	// The player is looked up without interning, so typing the name does not fill the pool.
+	auto player = m_names.find(m_name.c_str());
+	if (player.has_value()) {
+		ImGui::PushStyleColor(ImGuiCol_Text, RED_COLOR);
+		statisticsRow(m_name.c_str(), m_statistics.player(*player));
+		ImGui::PopStyleColor();
+	}
+
+	ImGui::EndTable();
 }
 
-void Status::loadScoreFile()
+void Status::statisticsRow(const std::string &label, const Statistics::Aggregate &aggregate)
+{
+	auto &score = aggregate.score;
+	auto &time = aggregate.time;
+
+	ImGui::TableNextRow();
+	for (int column = 0; column < STATISTICS_COLUMN_SIZE; column++) {
+		ImGui::TableSetColumnIndex(column);
+		switch (column) {
+		case 0:
+			ImGui::Text("%s", label.c_str());
+			break;
+		case 1:
+			ImGui::Text("%lu", (unsigned long)aggregate.games());
+			break;
+		case 2:
+			ImGui::Text("%.1f%%", aggregate.winRate() * 100);
+			break;
+		case 3:
+			ImGui::Text("%.0f", score.max());
+			break;
+		case 4:
+			ImGui::Text("%.1f", score.mean());
+			break;
+		case 5:
+			ImGui::Text("%.0f", score.p50());
+			break;
+		case 6:
+			ImGui::Text("%.0f", score.p90());
+			break;
+		case 7:
+			ImGui::Text("%.0f", score.p99());
+			break;
+		case 8:
+			ImGui::Text("%.0fs", time.min());
+			break;
+		case 9:
+			ImGui::Text("%.1fs", time.mean());
+			break;
+		case 10:
+			ImGui::Text("%.0fs", time.p50());
+			break;
+		case 11:
+			ImGui::Text("%.0fs", time.p90());
+			break;
+		case 12:
+			ImGui::Text("%.0fs", time.p99());
+			break;
+		}
+	}
+}
+
+std::string Status::replayPath(uint64_t hash) const
 {
-	std::string line;
-	int difficulty = 0;
+	char name[32];
+	snprintf(name, sizeof(name), "%016" PRIx64 ".replay", hash);
+	return (std::filesystem::path(REPLAY_DIRECTORY) / name).string();
+}
 
-	if (!m_scoreFile.is_open()) {
-		m_scoreFile.open(SCORE_FILE_NAME, std::ios::in);
+void Status::saveReplay(uint64_t hash, const Replay &replay)
+{
+	m_lastReplay = replay;
+	if (replay.empty()) {
+		return;
 	}
 
-	std::getline(m_scoreFile, line);
-	auto order = static_cast<SortOrder>(std::stoi(line));
+	std::error_code error;
+	std::filesystem::create_directories(REPLAY_DIRECTORY, error);
+	replay.save(replayPath(hash));
+}
 
-	while (std::getline(m_scoreFile, line)) {
-		auto parts = split(line, ' ');
-		if (parts.size() == 1) {
-			difficulty = std::stoi(parts[0]);
-			m_scores[difficulty].reserve(100);
-			continue;
-		}
+void Status::playReplay(const Replay &replay)
+{
+	auto board = app().getLayer<Board>("Board");
+	board->playReplay(replay, m_instantReplay ? 0.0 : m_replaySpeed);
+}
 
-		ScoreRecord record {
-			.score = std::stoi(parts[0]),
-			.name = std::move(parts[1]),
-			.numberOfMines = std::stoi(parts[2]),
-			.hash = std::stoul(parts[3]),
-		};
+void Status::loadScoreFile()
+{
+	// The tabs are shown right away, the records are filled in once the file is parsed.
+	for (int i = 0; i <= CUSTOM_DIFFICULTY; i++) {
+		m_scores[i];
+	}
 
-		if (difficulty == CUSTOM_DIFFICULTY) {
-			record.width = std::stoi(parts[4]);
-			record.height = std::stoi(parts[5]);
-		}
+	auto loaded = std::make_shared<std::promise<ScoreFile::Contents>>();
+	m_scoreLoader = loaded->get_future();
+	app().scheduler().submit([this, loaded] {
+		loaded->set_value(m_journal->load(SCORE_FILE_NAME));
+	});
+}
+
+bool Status::scoreFileLoaded()
+{
+	if (!m_scoreLoader.valid()) {
+		return true;
+	}
 
-		m_scores[difficulty].push(record);
+	if (m_scoreLoader.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+		return false;
 	}
 
-	setSortingOrder(order);
+	finishScoreFileLoading();
+	return true;
 }
 
-bool operator==(const ScoreRecord &lhs, const ScoreRecord &rhs)
+void Status::pollScoreJournal()
 {
-	return lhs.hash == rhs.hash;
+	auto now = std::chrono::steady_clock::now();
+	if (now - m_lastJournalPoll < JOURNAL_POLL_INTERVAL) {
+		return;
+	}
+	m_lastJournalPoll = now;
+
+	// Records won in the other running instances.
+	auto contents = m_journal->poll();
+	addToStatistics(contents);
+	for (auto &[difficulty, tab] : contents.sections) {
+		m_scores[difficulty].push(tab.begin(), tab.end());
+	}
 }
 
-bool operator>(const ScoreRecord &lhs, const ScoreRecord &rhs)
+void Status::addToStatistics(const ScoreFile::Contents &contents)
 {
-	return lhs.score > rhs.score;
+	for (auto &[difficulty, tab] : contents.sections) {
+		for (auto &record : tab) {
+			m_statistics.addWin(difficulty, record);
+		}
+	}
+
+	for (auto &[key, count] : contents.losses) {
+		m_statistics.addLosses(key.first, key.second, count);
+	}
 }
 
-bool operator<(const ScoreRecord &lhs, const ScoreRecord &rhs)
+void Status::finishScoreFileLoading()
 {
-	return lhs.score < rhs.score;
+	auto contents = m_scoreLoader.get();
+	// The games finished while loading are already counted.
+	addToStatistics(contents);
+
+	// Keep the records won while the file was still loading.
+	for (auto &[difficulty, tab] : m_scores) {
+		contents.sections[difficulty].push(tab.begin(), tab.end());
+	}
+
+	m_scores = std::move(contents.sections);
+	setSortingOrder(static_cast<SortOrder>(contents.sortOrder));
 }
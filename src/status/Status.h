@@ -1,23 +1,18 @@
 #pragma once
 
-#include "records/DynamicPriorityQueue.h"
 #include "Layer.h"
-
+#include "NamePool.h"
+#include "Replay.h"
+#include "ScoreFile.h"
+#include "ScoreJournal.h"
+#include "ScoreRecord.h"
+#include "Statistics.h"
+
+#include <chrono>
 #include <cstddef>
-#include <fstream>
+#include <future>
 #include <map>
-#include <print>
-
-struct ScoreRecord {
-	long score;
-	std::string name;
-	int width;
-	int height;
-	int numberOfMines;
-	size_t hash;
-};
-
-using DifficultyTab = DynamicPriorityQueue<ScoreRecord>;
+#include <memory>
 
 class Status
 	: public Layer
@@ -43,37 +38,50 @@ public:
 
 	void setSortingOrder(SortOrder order);
 
+	/// True once the scores are loaded, the loaded records are taken over by the first call after the loading.
+	bool scoreFileLoaded();
+
 	~Status();
 
 private:
 	std::string difficultyString(int difficulty = -1) const;
 	void createTabTable(int difficulty = -1);
-	std::vector<std::string> split(const std::string &s, char delim);
 	void loadScoreFile();
+	void finishScoreFileLoading();
+	void pollScoreJournal();
+	void addToStatistics(const ScoreFile::Contents &contents);
+	void createStatisticsTable();
+	void statisticsRow(const std::string &label, const Statistics::Aggregate &aggregate);
+
+	/// Path of the replay file of the game identified by the hash.
+	std::string replayPath(uint64_t hash) const;
+
+	/// Keep the finished game for the replay and write it next to the scores.
+	void saveReplay(uint64_t hash, const Replay &replay);
+
+	/// Play the replay on the board with the speed chosen in the menu.
+	void playReplay(const Replay &replay);
 
 private:
 	int m_difficulty;
 	int m_numberOfMines;
 	ScoreRecord m_score;
 	SortOrder m_sortOrder;
+	/// Number of the names ranked for the alphabetical order.
+	size_t m_rankedNames;
 
 	int m_localHeight;
 	int m_localWidth;
-	std::fstream m_scoreFile;
+	NamePool m_names;
+	/// Created once the layer is attached, it runs on the scheduler of the application.
+	std::unique_ptr<ScoreJournal> m_journal;
 	std::map<long, DifficultyTab> m_scores;
+	Statistics m_statistics;
+	std::future<ScoreFile::Contents> m_scoreLoader;
+	std::chrono::steady_clock::time_point m_lastJournalPoll;
 	std::string m_name;
-};
-
-bool operator==(const ScoreRecord &lhs, const ScoreRecord &rhs);
-bool operator>(const ScoreRecord &lhs, const ScoreRecord &rhs);
-bool operator<(const ScoreRecord &lhs, const ScoreRecord &rhs);
-
-template <>
-struct std::formatter<ScoreRecord> {
-	constexpr auto parse(std::format_parse_context& ctx) { return ctx.begin(); }
-
-	template <typename FormatContext>
-	auto format(const ScoreRecord& record, FormatContext& ctx) const {
-		return std::format_to(ctx.out(), "{} {} {} {}", record.score, record.name, record.numberOfMines, record.hash);
-	}
+	int m_bbbvBand[2];
+	Replay m_lastReplay;
+	float m_replaySpeed;
+	bool m_instantReplay;
 };
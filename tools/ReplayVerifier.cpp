@@ -0,0 +1,247 @@
+#include "ReplayVerifier.h"
+
+#include "Minefield.h"
+#include "NamePool.h"
+#include "Replay.h"
+#include "Scheduler.h"
+#include "ScoreJournal.h"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <memory>
+
+/// Replays verified by one task, the files are small so a task is mostly the file system calls.
+#define REPLAYS_PER_TASK 32
+#define REPLAY_EXTENSION ".replay"
+/// The record takes the time from the frame before the last action, so it may be a second behind the replay.
+#define TIME_TOLERANCE 1
+
+namespace
+{
+
+constexpr std::array VERDICT_NAMES {
+	std::pair { ReplayVerifier::Verdict::Verified, std::string_view("verified") },
+	std::pair { ReplayVerifier::Verdict::Mismatch, std::string_view("mismatch") },
+	std::pair { ReplayVerifier::Verdict::Unscored, std::string_view("unscored") },
+	std::pair { ReplayVerifier::Verdict::Corrupt, std::string_view("corrupt") },
+};
+
+/// Replay file with the hash parsed from its name.
+struct ReplayFile
+{
+	std::string path;
+	uint64_t hash;
+};
+
+/// The first check of the record the game fails, nothing if it passes all of them.
+std::string_view check(const ReplayVerifier::Game &game, const ScoreRecord &record)
+{
+	if (game.width != record.width || game.height != record.height
+		|| game.numberOfMines != static_cast<int>(record.numberOfMines))
+	{
+		return "board";
+	}
+	if (!game.won) {
+		return "result";
+	}
+	// The records of older versions do not carry the 3BV, the time and the clicks.
+	if (record.bbbv != 0 && game.bbbv != record.bbbv) {
+		return "3bv";
+	}
+	if (record.clicks != 0 && game.clicks != record.clicks) {
+		return "clicks";
+	}
+
+	long seconds = game.duration / 1000;
+	if (record.clicks != 0 && std::abs(seconds - static_cast<long>(record.time)) > TIME_TOLERANCE) {
+		return "time";
+	}
+	if (record.clicks != 0) {
+		// The same formula as the Status computes the score with.
+		long tiles = static_cast<long>(record.width) * record.height;
+		if ((tiles * record.numberOfMines - static_cast<long>(record.time)) / record.clicks != record.score) {
+			return "score";
+		}
+	}
+	return {};
+}
+
+}
+
+uint64_t ReplayVerifier::Result::count(Verdict verdict) const
+{
+	return std::count_if(games.begin(), games.end(), [verdict](const Game &game) {
+		return game.verdict == verdict;
+	});
+}
+
+uint32_t ReplayVerifier::Result::thinkTime(double quantile) const
+{
+	if (thinkTimes.empty()) {
+		return 0;
+	}
+	return thinkTimes[static_cast<size_t>(quantile * (thinkTimes.size() - 1))];
+}
+
+ReplayVerifier::ReplayVerifier(const Options &options)
+	: m_options(options)
+{
+}
+
+ReplayVerifier::Result ReplayVerifier::run() const
+{
+	auto start = std::chrono::steady_clock::now();
+
+	NamePool names;
+	ScoreJournal journal(m_options.scores, names);
+	auto contents = journal.load(m_options.legacyScores);
+
+	std::unordered_map<uint64_t, ScoreRecord> records;
+	for (auto &[difficulty, tab] : contents.sections) {
+		for (auto &record : tab) {
+			records.emplace(record.hash, record);
+		}
+	}
+
+	// Every replay file is named by the hash of its record in hexadecimal.
+	std::vector<ReplayFile> files;
+	std::error_code error;
+	for (const auto &entry : std::filesystem::directory_iterator(m_options.replays, error)) {
+		auto path = entry.path();
+		auto stem = path.stem().string();
+		uint64_t hash;
+		auto [end, parseError] = std::from_chars(stem.data(), stem.data() + stem.size(), hash, 16);
+		if (path.extension() == REPLAY_EXTENSION && parseError == std::errc() && end == stem.data() + stem.size()) {
+			files.push_back({ path.string(), hash });
+		}
+	}
+
+	// Every worker collects its own games and think times, they are merged once all the replays are verified.
+	Scheduler scheduler(m_options.threads);
+	std::vector<Result> results(scheduler.size());
+	scheduler.parallelFor(files.size(), REPLAYS_PER_TASK, [&files, &records, &names, &results](size_t index) {
+		auto &result = results[Scheduler::workerIndex()];
+		result.games.push_back(verify(files[index].path, files[index].hash, records, names, result.thinkTimes));
+	});
+
+	Result total;
+	total.games.reserve(files.size());
+	for (auto &result : results) {
+		total.games.insert(total.games.end(), result.games.begin(), result.games.end());
+		total.thinkTimes.insert(total.thinkTimes.end(), result.thinkTimes.begin(), result.thinkTimes.end());
+	}
+	std::sort(total.games.begin(), total.games.end(), [](const Game &lhs, const Game &rhs) {
+		return lhs.hash < rhs.hash;
+	});
+	std::sort(total.thinkTimes.begin(), total.thinkTimes.end());
+
+	for (const auto &[hash, record] : records) {
+		auto game = std::lower_bound(total.games.begin(), total.games.end(), hash, [](const Game &game, uint64_t hash) {
+			return game.hash < hash;
+		});
+		total.unreplayedRecords += game == total.games.end() || game->hash != hash;
+	}
+
+	total.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return total;
+}
+
+ReplayVerifier::Game ReplayVerifier::verify(const std::string &path, uint64_t hash,
+	const std::unordered_map<uint64_t, ScoreRecord> &records, const NamePool &names,
+	std::vector<uint32_t> &thinkTimes)
+{
+	Game game;
+	game.hash = hash;
+
+	auto replay = Replay::load(path);
+	if (!replay.has_value() || replay->numberOfMines() > int64_t(replay->width()) * replay->height() - 9) {
+		return game;
+	}
+	game.width = replay->width();
+	game.height = replay->height();
+	game.numberOfMines = replay->numberOfMines();
+
+	Minefield field(game.width, game.height, game.numberOfMines);
+	uint32_t previous = 0;
+	std::vector<uint32_t> gaps;
+	gaps.reserve(replay->events().size());
+	for (const auto &event : replay->events()) {
+		bool flagging = event.action == Replay::Action::Flag && !field.isFlagged(event.cell);
+		// The board records only the actions changing it, and no action is possible after the end of the game.
+		if (field.state() != Minefield::State::Playing || !replay->apply(field, event)) {
+			return game;
+		}
+
+		if (event.action != Replay::Action::Flag || flagging) {
+			game.clicks++;
+		}
+		if (flagging) {
+			game.flags++;
+			game.correctFlags += field.isMine(event.cell);
+		}
+		if (&event != &replay->events().front()) {
+			gaps.push_back(event.time - previous);
+		}
+		previous = event.time;
+	}
+
+	game.won = field.state() == Minefield::State::Win;
+	game.duration = replay->duration();
+	game.bbbv = field.initialized() ? field.bbbv() : 0;
+	if (!gaps.empty()) {
+		thinkTimes.insert(thinkTimes.end(), gaps.begin(), gaps.end());
+		auto median = gaps.begin() + gaps.size() / 2;
+		std::nth_element(gaps.begin(), median, gaps.end());
+		game.thinkTime = *median;
+	}
+
+	auto record = records.find(hash);
+	if (record == records.end()) {
+		game.verdict = Verdict::Unscored;
+		return game;
+	}
+
+	// A replay renamed to the hash of another record does not hash to it.
+	if (recordHash(record->second, names.name(record->second.name), replay->encode()) != hash) {
+		game.reason = "hash";
+	}
+	else {
+		game.reason = check(game, record->second);
+	}
+	game.verdict = game.reason.empty() ? Verdict::Verified : Verdict::Mismatch;
+	return game;
+}
+
+bool ReplayVerifier::write(const std::string &path, const Result &result)
+{
+	std::unique_ptr<FILE, decltype(&fclose)> file(fopen(path.c_str(), "w"), fclose);
+	if (!file) {
+		return false;
+	}
+
+	fprintf(file.get(), "hash\tverdict\treason\twidth\theight\tmines\twon\tseconds\tclicks\t3bv\t3bv_per_second\t"
+		"efficiency\tflags\tflag_accuracy\tthink_ms\n");
+	for (const auto &game : result.games) {
+		fprintf(file.get(), "%016llx\t%s\t%s\t%d\t%d\t%d\t%d\t%.3f\t%u\t%u\t%.3f\t%.3f\t%u\t%.3f\t%u\n",
+			static_cast<unsigned long long>(game.hash), name(game.verdict).data(),
+			game.reason.empty() ? "-" : game.reason.data(), game.width, game.height, game.numberOfMines, game.won,
+			game.duration / 1000.0, game.clicks, game.bbbv, game.bbbvPerSecond(), game.efficiency(), game.flags,
+			game.flagAccuracy(), game.thinkTime);
+	}
+	return fflush(file.get()) == 0 && !ferror(file.get());
+}
+
+std::string_view ReplayVerifier::name(Verdict verdict)
+{
+	for (auto [value, name] : VERDICT_NAMES) {
+		if (value == verdict) {
+			return name;
+		}
+	}
+	return {};
+}
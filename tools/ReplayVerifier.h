@@ -0,0 +1,130 @@
+#pragma once
+
+#include "NamePool.h"
+#include "ScoreRecord.h"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @class ReplayVerifier
+ * @brief Headless check of the recorded games against the leaderboard.
+ *
+ * Every replay file is named by the hash of its @c ScoreRecord, see @c Status. The replays are loaded and played on
+ * a @c Minefield by the workers of a @c Scheduler, the outcome of every replay is compared with the record of its
+ * hash: the hash recomputed from the replay and the record, see @c recordHash, the board, the win, the 3BV, the
+ * clicks, the time and the score recomputed from them. The replays of the lost games have no record, they are only
+ * analysed.
+ *
+ * Besides the verdict every game yields its 3BV per second, its efficiency, the think times between the actions
+ * and the share of the flags placed on mines.
+ */
+class ReplayVerifier
+{
+public:
+	/// Outcome of the check of one replay.
+	enum class Verdict
+	{
+		/// The replay reproduces its record.
+		Verified,
+		/// The replay differs from its record.
+		Mismatch,
+		/// There is no record of the replay, e.g. the game was lost.
+		Unscored,
+		/// The file is not a valid replay, or an action of it does not change the board.
+		Corrupt,
+	};
+
+	/// Configuration of the verification.
+	struct Options
+	{
+		/// Directory of the replay files.
+		std::string replays = "replays";
+		/// Base name of the @c ScoreJournal files.
+		std::string scores = "scores";
+		/// Score file in the legacy text format imported when there is no journal.
+		std::string legacyScores = "scores.txt";
+		/// Number of the worker threads, zero for all the cores.
+		unsigned threads = 0;
+	};
+
+	/// Outcome and analytics of one replay.
+	struct Game
+	{
+		uint64_t hash = 0;
+		Verdict verdict = Verdict::Corrupt;
+		/// The first check the replay failed, empty unless the verdict is a mismatch.
+		std::string_view reason = {};
+		int width = 0;
+		int height = 0;
+		int numberOfMines = 0;
+		bool won = false;
+		/// Milliseconds from the first to the last action.
+		uint32_t duration = 0;
+		/// Clicks counted the same way as the @c Board counts them, removing a flag is not a click.
+		uint32_t clicks = 0;
+		uint32_t bbbv = 0;
+		uint32_t flags = 0;
+		/// Flags placed on mines.
+		uint32_t correctFlags = 0;
+		/// Median milliseconds between two consecutive actions.
+		uint32_t thinkTime = 0;
+
+		double bbbvPerSecond() const { return won && duration ? bbbv * 1000.0 / duration : 0; }
+		double efficiency() const { return won && clicks ? static_cast<double>(bbbv) / clicks : 0; }
+		double flagAccuracy() const { return flags ? static_cast<double>(correctFlags) / flags : 0; }
+	};
+
+	/// Outcome of all the replays.
+	struct Result
+	{
+		/// Games sorted by the hash.
+		std::vector<Game> games;
+		/// Milliseconds between all the consecutive actions of all the games, sorted.
+		std::vector<uint32_t> thinkTimes;
+		/// Records of the leaderboard without a replay, e.g. won before the replays were recorded.
+		uint64_t unreplayedRecords = 0;
+		/// Wall time of the whole verification.
+		double seconds = 0;
+
+		/// Number of the games with the verdict.
+		uint64_t count(Verdict verdict) const;
+
+		/// Think time at the quantile in the range [0, 1].
+		uint32_t thinkTime(double quantile) const;
+	};
+
+	explicit ReplayVerifier(const Options &options);
+
+	/// Load the leaderboard, verify all the replays and return their outcome.
+	Result run() const;
+
+	/**
+	 * @brief Play the replay file and compare it with the record of its hash.
+	 *
+	 * @param path Path of the replay file.
+	 * @param hash Hash of the record of the replay.
+	 * @param records Records of the leaderboard keyed by their hash.
+	 * @param names Names of the players of the records.
+	 * @param thinkTimes Think times of the replay are appended to it.
+	 * @return The outcome of the replay.
+	 */
+	static Game verify(const std::string &path, uint64_t hash, const std::unordered_map<uint64_t, ScoreRecord> &records,
+		const NamePool &names, std::vector<uint32_t> &thinkTimes);
+
+	/**
+	 * @brief Write the games to a tab separated file, one column per field.
+	 *
+	 * @return True if the whole file was written.
+	 */
+	static bool write(const std::string &path, const Result &result);
+
+	/// Name of the verdict used in the output.
+	static std::string_view name(Verdict verdict);
+
+private:
+	Options m_options;
+};
@@ -0,0 +1,284 @@
+#include "Simulator.h"
+
+#include "Generator.h"
+#include "GuessOptimizer.h"
+#include "Minefield.h"
+#include "ProbabilityEngine.h"
+#include "Scheduler.h"
+#include "Solver.h"
+
+#include <algorithm>
+#include <array>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+/// Games played by one task, large enough to amortize the task, small enough to balance the workers.
+#define GAMES_PER_TASK 16
+/// Mixed into the seed of a game to get the seed of its random choices, so they differ from its board.
+#define CHOICE_SEED 0xd1b54a32d192ed03
+/// Consecutive calls without any effective action of the bot in a game before the game is abandoned.
+#define MAX_STALLED_CALLS 3
+
+namespace
+{
+
+constexpr std::array POLICY_NAMES {
+	std::pair { Simulator::Policy::Random, std::string_view("random") },
+	std::pair { Simulator::Policy::Solver, std::string_view("solver") },
+	std::pair { Simulator::Policy::Probability, std::string_view("probability") },
+	std::pair { Simulator::Policy::Lookahead, std::string_view("lookahead") },
+};
+
+/// Random hidden cell, the known mines are skipped when the solver is given.
+int randomCell(const Minefield &field, const Solver *solver, std::mt19937_64 &random)
+{
+	std::vector<int> cells;
+	for (int cell = 0; cell < field.size(); cell++) {
+		if (!field.isRevealed(cell) && (!solver || solver->knowledge(cell) != Solver::Knowledge::Mine)) {
+			cells.push_back(cell);
+		}
+	}
+	return cells[std::uniform_int_distribution<size_t>(0, cells.size() - 1)(random)];
+}
+
+}
+
+void Simulator::Result::merge(const Result &other)
+{
+	games += other.games;
+	wins += other.wins;
+	abandoned += other.abandoned;
+	clicks += other.clicks;
+	bbbv += other.bbbv;
+	winningClicks += other.winningClicks;
+	bbbvPerSecond += other.bbbvPerSecond;
+}
+
+Simulator::Simulator(const Options &options)
+	: m_options(options)
+{
+	if (!m_options.bot.empty()) {
+		m_bot = std::make_unique<BotPlugin>(m_options.bot);
+	}
+	if (m_options.corpus.empty()) {
+		return;
+	}
+
+	m_corpus = std::make_unique<BoardCorpus>(m_options.corpus);
+	if (!m_corpus->isOpen()) {
+		throw std::runtime_error("Could not open the board corpus " + m_options.corpus);
+	}
+
+	// The corpus is iterated only forward, the games are picked by the index.
+	m_boards.reserve(m_corpus->size());
+	for (const auto &board : *m_corpus) {
+		m_boards.push_back(&board);
+	}
+}
+
+Simulator::Result Simulator::run() const
+{
+	auto start = std::chrono::steady_clock::now();
+
+	// Every worker adds to its own totals, they are merged once all the games are played.
+	Scheduler scheduler(m_options.threads);
+	std::vector<Result> results(scheduler.size());
+	if (m_bot) {
+		// Every worker has its own instance of the bot, an instance is not shared by the threads.
+		std::vector<BotPlugin::Bot> bots;
+		bots.reserve(scheduler.size());
+		for (unsigned worker = 0; worker < scheduler.size(); worker++) {
+			bots.push_back(m_bot->create(m_options.botOptions));
+		}
+
+		uint64_t batch = std::max<uint32_t>(m_options.batch, 1);
+		scheduler.parallelFor((games() + batch - 1) / batch, 1, [this, batch, &bots, &results](size_t index) {
+			int worker = Scheduler::workerIndex();
+			uint64_t first = index * batch;
+			play(first, std::min(batch, games() - first), bots[worker], results[worker]);
+		});
+	}
+	else {
+		scheduler.parallelFor(games(), GAMES_PER_TASK, [this, &results](size_t game) {
+			play(game, results[Scheduler::workerIndex()]);
+		});
+	}
+
+	Result total;
+	for (const auto &result : results) {
+		total.merge(result);
+	}
+	total.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return total;
+}
+
+void Simulator::play(uint64_t game, Result &result) const
+{
+	auto start = std::chrono::steady_clock::now();
+	std::mt19937_64 random(Generator::candidate(m_options.seed, game) ^ CHOICE_SEED);
+
+	Minefield field = this->start(game);
+	Solver solver(field);
+	ProbabilityEngine probability(field, solver);
+	GuessOptimizer optimizer(field);
+	solver.update(field.changes());
+	uint64_t clicks = 1;
+
+	while (field.state() == Minefield::State::Playing) {
+		if (m_options.policy != Policy::Random) {
+			bool progress = false;
+			for (auto [cell, mine] : solver.deductions()) {
+				if (!mine && field.reveal(cell)) {
+					solver.update(field.changes());
+					clicks++;
+					progress = true;
+				}
+			}
+			if (progress) {
+				continue;
+			}
+		}
+
+		int cell;
+		switch (m_options.policy) {
+		case Policy::Random:
+			cell = randomCell(field, nullptr, random);
+			break;
+		case Policy::Solver:
+			cell = randomCell(field, &solver, random);
+			break;
+		case Policy::Probability:
+			probability.compute();
+			cell = probability.safestCell();
+			break;
+		case Policy::Lookahead:
+			cell = optimizer.guess(m_options.guessBudget);
+			break;
+		}
+
+		field.reveal(cell);
+		solver.update(field.changes());
+		clicks++;
+	}
+
+	finish(field, clicks, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(), result);
+}
+
+void Simulator::play(uint64_t first, uint64_t count, BotPlugin::Bot &bot, Result &result) const
+{
+	auto start = std::chrono::steady_clock::now();
+
+	std::vector<Minefield> fields;
+	fields.reserve(count);
+	for (uint64_t game = first; game < first + count; game++) {
+		fields.push_back(this->start(game));
+	}
+	std::vector<uint64_t> clicks(count, 1);
+	std::vector<int> stalls(count, 0);
+	std::vector<uint8_t> progress(count);
+
+	BotBatch batch;
+	while (true) {
+		batch.clear();
+		for (uint64_t index = 0; index < count; index++) {
+			if (fields[index].state() == Minefield::State::Playing && stalls[index] < MAX_STALLED_CALLS) {
+				batch.add(first + index, fields[index]);
+			}
+		}
+		if (batch.empty()) {
+			break;
+		}
+
+		std::fill(progress.begin(), progress.end(), 0);
+		for (const auto &action : bot.act(batch)) {
+			uint64_t index = action.game - first;
+			if (index >= count || fields[index].state() != Minefield::State::Playing
+				|| action.cell >= static_cast<uint32_t>(fields[index].size()))
+			{
+				continue;
+			}
+
+			auto &field = fields[index];
+			bool changed = false;
+			switch (action.type) {
+			case MINESWEEPER_ACTION_REVEAL:
+				changed = field.reveal(action.cell);
+				break;
+			case MINESWEEPER_ACTION_FLAG:
+				changed = field.toggleFlag(action.cell);
+				break;
+			case MINESWEEPER_ACTION_CHORD:
+				changed = field.chord(action.cell);
+				break;
+			}
+			// The clicks are the reveals, the same as the policies count them.
+			clicks[index] += changed && action.type != MINESWEEPER_ACTION_FLAG;
+			progress[index] |= changed;
+		}
+
+		for (const auto &game : batch.games()) {
+			uint64_t index = game.game - first;
+			stalls[index] = progress[index] ? 0 : stalls[index] + 1;
+		}
+	}
+
+	// The games of the batch are played together, each takes an equal share of the time.
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / count;
+	for (uint64_t index = 0; index < count; index++) {
+		result.abandoned += fields[index].state() == Minefield::State::Playing;
+		finish(fields[index], clicks[index], seconds, result);
+	}
+}
+
+Minefield Simulator::start(uint64_t game) const
+{
+	auto seed = Generator::candidate(m_options.seed, game);
+	const auto *board = m_corpus ? m_boards[game] : nullptr;
+	Minefield field(board ? board->width : m_options.width, board ? board->height : m_options.height,
+		board ? board->numberOfMines : m_options.numberOfMines);
+
+	int first;
+	if (board) {
+		first = board->first;
+		board->place(field);
+	}
+	else {
+		first = field.index(field.width() / 2, field.height() / 2);
+		field.generate(first, seed);
+	}
+	field.reveal(first);
+	return field;
+}
+
+void Simulator::finish(const Minefield &field, uint64_t clicks, double seconds, Result &result)
+{
+	result.games++;
+	result.clicks += clicks;
+	if (field.state() == Minefield::State::Win) {
+		result.wins++;
+		result.bbbv += field.bbbv();
+		result.winningClicks += clicks;
+		result.bbbvPerSecond += seconds > 0 ? field.bbbv() / seconds : 0;
+	}
+}
+
+std::string_view Simulator::name(Policy policy)
+{
+	for (auto [value, name] : POLICY_NAMES) {
+		if (value == policy) {
+			return name;
+		}
+	}
+	return {};
+}
+
+std::optional<Simulator::Policy> Simulator::policy(std::string_view name)
+{
+	for (auto [value, policyName] : POLICY_NAMES) {
+		if (policyName == name) {
+			return value;
+		}
+	}
+	return std::nullopt;
+}
@@ -0,0 +1,155 @@
+#pragma once
+
+#include "BoardCorpus.h"
+#include "BotPlugin.h"
+#include "Minefield.h"
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @class Simulator
+ * @brief Headless player of many games with a fixed policy.
+ *
+ * Every game is played on a @c Minefield without any rendering, the first click is the centre of the board. The
+ * games are independent, so they are spread over the workers of a @c Scheduler. The board and the random choices of
+ * a game are derived from the master seed and the index of the game only, so the results are the same for any number
+ * of threads.
+ *
+ * With a @c BoardCorpus every board of the corpus is played once with the first click stored in the corpus, so the
+ * different policies and versions are compared on an identical workload.
+ *
+ * With a @c BotPlugin the bot plays instead of the policy. Every task plays a batch of the games at once and the bot
+ * chooses its actions in all of them in one call, so the cost of the call is shared by the whole batch.
+ */
+class Simulator
+{
+public:
+	/// How the player chooses the cell to be revealed.
+	enum class Policy
+	{
+		/// A random hidden cell, no deductions.
+		Random,
+		/// The safe cells deduced by the @c Solver, a random undeduced cell when there is none.
+		Solver,
+		/// The safe cells deduced by the @c Solver, the cell with the lowest mine probability when there is none.
+		Probability,
+		/// The safe cells deduced by the @c Solver, the guess of the @c GuessOptimizer when there is none.
+		Lookahead,
+	};
+
+	/// Configuration of the simulation.
+	struct Options
+	{
+		int width = 30;
+		int height = 16;
+		int numberOfMines = 99;
+		uint64_t games = 1000;
+		Policy policy = Policy::Probability;
+		uint64_t seed = 1;
+		/// Number of the worker threads, zero for all the cores.
+		unsigned threads = 0;
+		/// Time budget of one guess of the @c Policy::Lookahead.
+		std::chrono::milliseconds guessBudget = std::chrono::milliseconds(20);
+		/// Path of the @c BoardCorpus to be played instead of the generated boards, empty for none.
+		std::string corpus = {};
+		/// Path of the @c BotPlugin playing instead of the policy, empty for none.
+		std::string bot = {};
+		/// Options passed to the bot.
+		std::string botOptions = {};
+		/// Games given to the bot in one call.
+		uint32_t batch = 256;
+	};
+
+	/// Totals over the simulated games.
+	struct Result
+	{
+		uint64_t games = 0;
+		uint64_t wins = 0;
+		/// Games the bot stopped making progress in, counted as lost.
+		uint64_t abandoned = 0;
+		/// Clicks of all the games, every reveal of a hidden cell is one click.
+		uint64_t clicks = 0;
+		/// 3BV of the won games.
+		uint64_t bbbv = 0;
+		/// Clicks of the won games.
+		uint64_t winningClicks = 0;
+		/// Sum of the 3BV per second of the computation of the won games.
+		double bbbvPerSecond = 0;
+		/// Wall time of the whole simulation.
+		double seconds = 0;
+
+		double winRate() const { return games ? static_cast<double>(wins) / games : 0; }
+		double clicksPerGame() const { return games ? static_cast<double>(clicks) / games : 0; }
+		double gamesPerSecond() const { return seconds > 0 ? games / seconds : 0; }
+
+		/// Mean 3BV per second of the won games, the pace of the policy if the clicks were free.
+		double meanBbbvPerSecond() const { return wins ? bbbvPerSecond / wins : 0; }
+
+		/// Ratio of the 3BV to the clicks of the won games, 1 means no click was wasted.
+		double efficiency() const { return winningClicks ? static_cast<double>(bbbv) / winningClicks : 0; }
+
+		/// Add the totals of another part of the simulation.
+		void merge(const Result &other);
+	};
+
+	/**
+	 * @brief Create the simulator.
+	 *
+	 * @throws std::runtime_error If the corpus or the bot of the options can not be opened.
+	 */
+	explicit Simulator(const Options &options);
+
+	/// Number of the games to be played, the number of the boards of the corpus if there is one.
+	uint64_t games() const { return m_corpus ? m_boards.size() : m_options.games; }
+
+	/**
+	 * @brief Play all the games and return their totals.
+	 *
+	 * @throws std::runtime_error If the bot does not create its instance for every worker.
+	 */
+	Result run() const;
+
+	/**
+	 * @brief Play one game.
+	 *
+	 * @param game Index of the game, selects its board and its random choices.
+	 * @param result Totals the game is added to.
+	 */
+	void play(uint64_t game, Result &result) const;
+
+	/**
+	 * @brief Play the games with the bot.
+	 *
+	 * @param first Index of the first game.
+	 * @param count Number of the games.
+	 * @param bot Instance of the bot used only by the calling thread.
+	 * @param result Totals the games are added to.
+	 */
+	void play(uint64_t first, uint64_t count, BotPlugin::Bot &bot, Result &result) const;
+
+	/// Name of the policy used on the command line.
+	static std::string_view name(Policy policy);
+
+	/// Policy of the name used on the command line.
+	static std::optional<Policy> policy(std::string_view name);
+
+private:
+	/// Field of the game after its first click.
+	Minefield start(uint64_t game) const;
+
+	/// Add the finished game to the totals.
+	static void finish(const Minefield &field, uint64_t clicks, double seconds, Result &result);
+
+private:
+	Options m_options;
+	std::unique_ptr<BoardCorpus> m_corpus;
+	std::unique_ptr<BotPlugin> m_bot;
+	/// Boards of the corpus pointing into its mapping, indexed by the game.
+	std::vector<const BoardCorpus::Board *> m_boards;
+};
@@ -0,0 +1,119 @@
+#include "ArenaServer.h"
+
+#include <atomic>
+#include <cerrno>
+#include <charconv>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <string_view>
+
+/// Period of exporting the metrics.
+#define METRICS_PERIOD std::chrono::seconds(1)
+
+namespace
+{
+
+std::atomic<bool> stopped = false;
+
+void stop(int)
+{
+	stopped.store(true, std::memory_order_relaxed);
+}
+
+void usage(const char *program)
+{
+	fprintf(stderr,
+		"Usage: %s [options]\n"
+		"  --socket PATH       Unix domain socket the bots connect to (minesweeper-arena.sock)\n"
+		"  --metrics FILE      tab separated metrics rewritten every second (arena-metrics.tsv)\n"
+		"  --connections N     connections served at once (1024)\n"
+		"  --games N           games of one connection (4096)\n",
+		program);
+}
+
+template <typename Number>
+bool parse(std::string_view text, Number &number)
+{
+	auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), number);
+	return error == std::errc() && end == text.data() + text.size();
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+	ArenaServer::Options options;
+	std::string metrics = "arena-metrics.tsv";
+
+	for (int i = 1; i < argc; i++) {
+		std::string_view option = argv[i];
+		if (option == "--help" || option == "-h") {
+			usage(argv[0]);
+			return 0;
+		}
+		if (i + 1 == argc) {
+			fprintf(stderr, "Missing the value of %s\n", argv[i]);
+			return 1;
+		}
+
+		std::string_view value = argv[++i];
+		bool valid = true;
+		if (option == "--socket") {
+			options.socket = value;
+		}
+		else if (option == "--metrics") {
+			metrics = value;
+		}
+		else if (option == "--connections") {
+			valid = parse(value, options.maxConnections) && options.maxConnections > 0;
+		}
+		else if (option == "--games") {
+			valid = parse(value, options.maxGames) && options.maxGames > 0;
+		}
+		else {
+			fprintf(stderr, "Unknown option %s\n", argv[i - 1]);
+			usage(argv[0]);
+			return 1;
+		}
+
+		if (!valid) {
+			fprintf(stderr, "Invalid value %s of %s\n", argv[i], argv[i - 1]);
+			return 1;
+		}
+	}
+
+	ArenaServer server(options);
+	if (!server.listen()) {
+		fprintf(stderr, "Could not listen on %s: %s\n", options.socket.c_str(), strerror(errno));
+		return 1;
+	}
+
+	struct sigaction action {};
+	action.sa_handler = stop;
+	sigaction(SIGINT, &action, nullptr);
+	sigaction(SIGTERM, &action, nullptr);
+
+	printf("listening on %s\n", options.socket.c_str());
+	bool reported = true;
+	bool clean = server.run(stopped, METRICS_PERIOD, [&server, &metrics, &reported](const ArenaServer::Metrics &) {
+		// A failed export is reported once, the arena keeps serving the bots.
+		bool written = server.writeMetrics(metrics);
+		if (!written && reported) {
+			fprintf(stderr, "Could not write %s\n", metrics.c_str());
+		}
+		reported = written;
+	});
+	if (!clean) {
+		fprintf(stderr, "Serving failed: %s\n", strerror(errno));
+	}
+	server.writeMetrics(metrics);
+
+	const auto &result = server.metrics();
+	printf("connections    %llu\n", static_cast<unsigned long long>(result.connections));
+	printf("requests       %llu\n", static_cast<unsigned long long>(result.totalRequests()));
+	printf("games won      %llu, lost %llu\n", static_cast<unsigned long long>(result.wins),
+		static_cast<unsigned long long>(result.losses));
+	printf("latency        p50 %.1fus, p99 %.1fus\n", result.latencyQuantile(0.5), result.latencyQuantile(0.99));
+	return clean ? 0 : 1;
+}
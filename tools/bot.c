@@ -0,0 +1,145 @@
+/*
+ * Reference bot of the plugin interface, see MinesweeperBot.h.
+ *
+ * The bot makes the single cell deductions: a number with all its mines flagged is chorded and a number with as many
+ * hidden neighbours as missing mines gets them flagged. A game without any deduction gets a random hidden cell
+ * revealed. The bot is written in plain C to keep it honest about the interface.
+ */
+
+#include "MinesweeperBot.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct SimpleBot
+{
+	/* Tiles of the game being played with the flags of the current call placed. */
+	uint8_t *tiles;
+	size_t capacity;
+	uint64_t random;
+} SimpleBot;
+
+static uint64_t next(SimpleBot *bot)
+{
+	/* xorshift64 */
+	bot->random ^= bot->random << 13;
+	bot->random ^= bot->random >> 7;
+	bot->random ^= bot->random << 17;
+	return bot->random;
+}
+
+static void *create(const char *options)
+{
+	SimpleBot *bot = calloc(1, sizeof(SimpleBot));
+	if (bot) {
+		bot->random = options ? strtoull(options, NULL, 10) : 0;
+		bot->random = bot->random ? bot->random : 0x9e3779b97f4a7c15u;
+	}
+	return bot;
+}
+
+static void destroy(void *instance)
+{
+	SimpleBot *bot = instance;
+	free(bot->tiles);
+	free(bot);
+}
+
+static int isHidden(uint8_t tile)
+{
+	return tile == MINESWEEPER_TILE_HIDDEN;
+}
+
+static uint32_t play(SimpleBot *bot, const MinesweeperObservation *game, MinesweeperAction *actions, uint32_t capacity)
+{
+	int width = game->width;
+	int height = game->height;
+	uint32_t count = 0;
+	uint32_t hidden = 0;
+
+	for (int cell = 0; cell < width * height && count < capacity; cell++) {
+		int number = bot->tiles[cell];
+		hidden += isHidden(bot->tiles[cell]);
+		if (number < 1 || number > 8) {
+			continue;
+		}
+
+		int flags = 0;
+		int unknown = 0;
+		for (int y = cell / width - 1; y <= cell / width + 1; y++) {
+			for (int x = cell % width - 1; x <= cell % width + 1; x++) {
+				if (x >= 0 && x < width && y >= 0 && y < height) {
+					flags += bot->tiles[y * width + x] == MINESWEEPER_TILE_FLAG;
+					unknown += isHidden(bot->tiles[y * width + x]);
+				}
+			}
+		}
+		if (unknown == 0) {
+			continue;
+		}
+
+		if (flags == number) {
+			actions[count++] = (MinesweeperAction) { game->game, (uint32_t)cell, MINESWEEPER_ACTION_CHORD, { 0 } };
+		}
+		else if (flags + unknown == number) {
+			for (int y = cell / width - 1; y <= cell / width + 1; y++) {
+				for (int x = cell % width - 1; x <= cell % width + 1; x++) {
+					int neighbour = y * width + x;
+					if (x >= 0 && x < width && y >= 0 && y < height && isHidden(bot->tiles[neighbour])
+						&& count < capacity)
+					{
+						/* Flagged once even if another number deduces it again. */
+						bot->tiles[neighbour] = MINESWEEPER_TILE_FLAG;
+						actions[count++] = (MinesweeperAction) { game->game, (uint32_t)neighbour, MINESWEEPER_ACTION_FLAG,
+							{ 0 } };
+					}
+				}
+			}
+		}
+	}
+
+	if (count == 0 && hidden > 0) {
+		uint32_t chosen = next(bot) % hidden;
+		for (int cell = 0; cell < width * height; cell++) {
+			if (isHidden(bot->tiles[cell]) && chosen-- == 0) {
+				actions[count++] = (MinesweeperAction) { game->game, (uint32_t)cell, MINESWEEPER_ACTION_REVEAL, { 0 } };
+				break;
+			}
+		}
+	}
+	return count;
+}
+
+static uint32_t act(void *instance, const MinesweeperObservation *games, uint32_t count, const uint8_t *tiles,
+	MinesweeperAction *actions, uint32_t capacity)
+{
+	SimpleBot *bot = instance;
+	uint32_t written = 0;
+	for (uint32_t i = 0; i < count && written < capacity; i++) {
+		size_t size = (size_t)games[i].width * games[i].height;
+		if (size > bot->capacity) {
+			uint8_t *grown = realloc(bot->tiles, size);
+			if (!grown) {
+				break;
+			}
+			bot->tiles = grown;
+			bot->capacity = size;
+		}
+		memcpy(bot->tiles, tiles + games[i].tiles, size);
+		written += play(bot, &games[i], actions + written, capacity - written);
+	}
+	return written;
+}
+
+const MinesweeperBot *minesweeper_bot(uint32_t abiVersion)
+{
+	static const MinesweeperBot BOT = {
+		MINESWEEPER_BOT_ABI_VERSION,
+		sizeof(MinesweeperBot),
+		"simple",
+		create,
+		destroy,
+		act,
+	};
+	return MINESWEEPER_BOT_ABI_MAJOR(abiVersion) == MINESWEEPER_BOT_ABI_MAJOR(MINESWEEPER_BOT_ABI_VERSION) ? &BOT : NULL;
+}
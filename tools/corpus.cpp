@@ -0,0 +1,224 @@
+#include "BoardCorpus.h"
+#include "Generator.h"
+#include "Minefield.h"
+#include "Scheduler.h"
+
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#define NO_GUESS_TIMEOUT std::chrono::seconds(10)
+
+namespace
+{
+
+void usage(const char *program)
+{
+	fprintf(stderr,
+		"Usage:\n"
+		"  %s generate [options] OUTPUT   write boards generated from the seeds derived from the master seed\n"
+		"  %s import [options] SEEDS OUTPUT  write the boards of the seeds listed one per line in the SEEDS file\n"
+		"  %s info CORPUS                  print the summary of the corpus\n"
+		"Options:\n"
+		"  --width N      cells in the horizontal direction (30)\n"
+		"  --height N     cells in the vertical direction (16)\n"
+		"  --mines N      number of mines (99)\n"
+		"  --count N      number of the generated boards (1000)\n"
+		"  --seed N       master seed of the generated boards (1)\n"
+		"  --no-guess     generate only the boards solvable without guessing\n",
+		program, program, program);
+}
+
+template <typename Number>
+bool parse(std::string_view text, Number &number)
+{
+	auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), number);
+	return error == std::errc() && end == text.data() + text.size();
+}
+
+struct Options
+{
+	int width = 30;
+	int height = 16;
+	int numberOfMines = 99;
+	uint64_t count = 1000;
+	uint64_t seed = 1;
+	bool noGuess = false;
+	std::vector<std::string> files;
+};
+
+bool parseOptions(int argc, char *argv[], Options &options)
+{
+	for (int i = 2; i < argc; i++) {
+		std::string_view option = argv[i];
+		if (!option.starts_with("--")) {
+			options.files.emplace_back(option);
+			continue;
+		}
+		if (option == "--no-guess") {
+			options.noGuess = true;
+			continue;
+		}
+		if (i + 1 == argc) {
+			fprintf(stderr, "Missing the value of %s\n", argv[i]);
+			return false;
+		}
+
+		std::string_view value = argv[++i];
+		bool valid;
+		if (option == "--width") {
+			valid = parse(value, options.width) && options.width > 0 && options.width <= UINT16_MAX;
+		}
+		else if (option == "--height") {
+			valid = parse(value, options.height) && options.height > 0 && options.height <= UINT16_MAX;
+		}
+		else if (option == "--mines") {
+			valid = parse(value, options.numberOfMines) && options.numberOfMines >= 0;
+		}
+		else if (option == "--count") {
+			valid = parse(value, options.count);
+		}
+		else if (option == "--seed") {
+			valid = parse(value, options.seed);
+		}
+		else {
+			fprintf(stderr, "Unknown option %s\n", argv[i - 1]);
+			return false;
+		}
+
+		if (!valid) {
+			fprintf(stderr, "Invalid value %s of %s\n", argv[i], argv[i - 1]);
+			return false;
+		}
+	}
+	return true;
+}
+
+/// Write the boards of the seeds, the first click is the centre of the board.
+int write(const Options &options, const std::string &output, auto &&nextSeed)
+{
+	BoardCorpusWriter writer(output);
+	if (!writer.isOpen()) {
+		fprintf(stderr, "Could not create %s\n", output.c_str());
+		return 1;
+	}
+
+	Minefield field(options.width, options.height, options.numberOfMines);
+	Scheduler scheduler;
+	Generator generator(options.width, options.height, options.numberOfMines, &scheduler);
+	int first = field.index(options.width / 2, options.height / 2);
+
+	uint64_t seed;
+	uint64_t rejected = 0;
+	while (nextSeed(seed)) {
+		if (options.noGuess) {
+			auto layout = generator.generate(first, seed, NO_GUESS_TIMEOUT);
+			rejected += !layout.accepted;
+			seed = layout.seed;
+		}
+
+		field.generate(first, seed);
+		if (!writer.add(field, first)) {
+			fprintf(stderr, "Could not write %s\n", output.c_str());
+			return 1;
+		}
+	}
+
+	auto count = writer.count();
+	if (!writer.close()) {
+		fprintf(stderr, "Could not write %s\n", output.c_str());
+		return 1;
+	}
+
+	printf("%llu boards written to %s\n", static_cast<unsigned long long>(count), output.c_str());
+	if (rejected > 0) {
+		printf("%llu boards are not no-guess, the search timed out\n", static_cast<unsigned long long>(rejected));
+	}
+	return 0;
+}
+
+int info(const std::string &path)
+{
+	BoardCorpus corpus(path);
+	if (!corpus.isOpen()) {
+		fprintf(stderr, "%s is not a board corpus\n", path.c_str());
+		return 1;
+	}
+
+	uint64_t boards = 0;
+	uint64_t cells = 0;
+	uint64_t mines = 0;
+	for (const auto &board : corpus) {
+		boards++;
+		cells += board.size();
+		mines += board.numberOfMines;
+	}
+
+	printf("boards       %llu\n", static_cast<unsigned long long>(boards));
+	if (boards != corpus.size()) {
+		printf("truncated    %llu boards declared\n", static_cast<unsigned long long>(corpus.size()));
+	}
+	if (boards > 0) {
+		printf("cells/board  %.1f\n", static_cast<double>(cells) / boards);
+		printf("mines/board  %.1f\n", static_cast<double>(mines) / boards);
+	}
+	return 0;
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc < 2) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	std::string_view command = argv[1];
+	Options options;
+	if (!parseOptions(argc, argv, options)) {
+		return 1;
+	}
+
+	uint64_t cells = uint64_t(options.width) * options.height;
+	if (cells > BoardCorpus::MAX_CELLS) {
+		fprintf(stderr, "Too many cells on a %dx%d board\n", options.width, options.height);
+		return 1;
+	}
+
+	// The mines are not placed around the first click, see Minefield::generate.
+	if (static_cast<uint64_t>(options.numberOfMines) + 9 > cells) {
+		fprintf(stderr, "Too many mines for a %dx%d board\n", options.width, options.height);
+		return 1;
+	}
+
+	if (command == "generate" && options.files.size() == 1) {
+		uint64_t n = 0;
+		return write(options, options.files[0], [&options, &n](uint64_t &seed) {
+			seed = Generator::candidate(options.seed, n);
+			return n++ < options.count;
+		});
+	}
+
+	if (command == "import" && options.files.size() == 2) {
+		std::ifstream seeds(options.files[0]);
+		if (!seeds) {
+			fprintf(stderr, "Could not open %s\n", options.files[0].c_str());
+			return 1;
+		}
+		return write(options, options.files[1], [&seeds](uint64_t &seed) {
+			return static_cast<bool>(seeds >> seed);
+		});
+	}
+
+	if (command == "info" && options.files.size() == 1) {
+		return info(options.files[0]);
+	}
+
+	usage(argv[0]);
+	return 1;
+}
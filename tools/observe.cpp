@@ -0,0 +1,115 @@
+#include "ObserverReader.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <string_view>
+#include <thread>
+
+/// Period of reading the deltas, a reader polling this often keeps up with any game.
+#define POLL_PERIOD std::chrono::milliseconds(1)
+#define REPORT_PERIOD std::chrono::seconds(1)
+
+namespace
+{
+
+std::atomic<bool> stopped = false;
+
+void stop(int)
+{
+	stopped.store(true, std::memory_order_relaxed);
+}
+
+void usage(const char *program)
+{
+	fprintf(stderr,
+		"Usage: %s [options]\n"
+		"  --feed NAME    shared memory segment of the game (/minesweeper-board)\n",
+		program);
+}
+
+const char *stateName(int state)
+{
+	switch (state) {
+	case 0:
+		return "playing";
+	case 1:
+		return "won";
+	case 2:
+		return "lost";
+	}
+	return "unknown";
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+	std::string feed = "/minesweeper-board";
+
+	for (int i = 1; i < argc; i++) {
+		std::string_view option = argv[i];
+		if (option == "--help" || option == "-h") {
+			usage(argv[0]);
+			return 0;
+		}
+		if (i + 1 == argc) {
+			fprintf(stderr, "Missing the value of %s\n", argv[i]);
+			return 1;
+		}
+
+		std::string_view value = argv[++i];
+		if (option == "--feed") {
+			feed = value;
+		}
+		else {
+			fprintf(stderr, "Unknown option %s\n", argv[i - 1]);
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	ObserverReader reader(feed);
+	if (!reader.isOpen()) {
+		fprintf(stderr, "Could not open the feed %s, is the game running?\n", feed.c_str());
+		return 1;
+	}
+
+	struct sigaction action {};
+	action.sa_handler = stop;
+	sigaction(SIGINT, &action, nullptr);
+	sigaction(SIGTERM, &action, nullptr);
+
+	// The board is followed by the deltas, the snapshot is taken only when they are not complete.
+	ObserverReader::Snapshot board;
+	reader.snapshot(board);
+	uint64_t deltas = 0;
+	uint64_t snapshots = 1;
+	auto report = std::chrono::steady_clock::now() + REPORT_PERIOD;
+	while (!stopped.load(std::memory_order_relaxed) && reader.alive()) {
+		bool complete = reader.poll([&board, &deltas](int cell, PackedTile tile) {
+			if (cell < static_cast<int>(board.tiles.size())) {
+				board.tiles[cell] = tile;
+			}
+			deltas++;
+		});
+		if (!complete) {
+			reader.snapshot(board);
+			snapshots++;
+		}
+
+		if (auto now = std::chrono::steady_clock::now(); now >= report) {
+			auto hidden = std::count(board.tiles.begin(), board.tiles.end(), PackedTile::Hidden);
+			printf("game %llu  %dx%d  %s  hidden %lld  flags %d  deltas %llu  snapshots %llu\n",
+				static_cast<unsigned long long>(board.game), board.width, board.height, stateName(reader.state()),
+				static_cast<long long>(hidden), reader.numberOfFlags(), static_cast<unsigned long long>(deltas),
+				static_cast<unsigned long long>(snapshots));
+			fflush(stdout);
+			report = now + REPORT_PERIOD;
+		}
+		std::this_thread::sleep_for(POLL_PERIOD);
+	}
+	return 0;
+}
@@ -0,0 +1,146 @@
+#include "Simulator.h"
+
+#include <charconv>
+#include <cstdio>
+#include <stdexcept>
+#include <string_view>
+
+namespace
+{
+
+void usage(const char *program)
+{
+	fprintf(stderr,
+		"Usage: %s [options]\n"
+		"  --width N      cells in the horizontal direction (30)\n"
+		"  --height N     cells in the vertical direction (16)\n"
+		"  --mines N      number of mines (99)\n"
+		"  --games N      number of games to play (1000)\n"
+		"  --policy NAME  random, solver, probability or lookahead (probability)\n"
+		"  --seed N       master seed of the boards (1)\n"
+		"  --threads N    worker threads, 0 for all the cores (0)\n"
+		"  --budget MS    time budget of one lookahead guess (20)\n"
+		"  --corpus FILE  play the boards of the corpus instead of the generated ones\n"
+		"  --bot FILE     play with the bot plugin instead of the policy\n"
+		"  --bot-args S   options passed to the bot\n"
+		"  --batch N      games given to the bot at once (256)\n",
+		program);
+}
+
+template <typename Number>
+bool parse(std::string_view text, Number &number)
+{
+	auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), number);
+	return error == std::errc() && end == text.data() + text.size();
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+	Simulator::Options options;
+
+	for (int i = 1; i < argc; i++) {
+		std::string_view option = argv[i];
+		if (option == "--help" || option == "-h") {
+			usage(argv[0]);
+			return 0;
+		}
+		if (i + 1 == argc) {
+			fprintf(stderr, "Missing the value of %s\n", argv[i]);
+			return 1;
+		}
+
+		std::string_view value = argv[++i];
+		int64_t budget = options.guessBudget.count();
+		bool valid = true;
+		if (option == "--width") {
+			valid = parse(value, options.width) && options.width > 0;
+		}
+		else if (option == "--height") {
+			valid = parse(value, options.height) && options.height > 0;
+		}
+		else if (option == "--mines") {
+			valid = parse(value, options.numberOfMines) && options.numberOfMines >= 0;
+		}
+		else if (option == "--games") {
+			valid = parse(value, options.games);
+		}
+		else if (option == "--seed") {
+			valid = parse(value, options.seed);
+		}
+		else if (option == "--threads") {
+			valid = parse(value, options.threads);
+		}
+		else if (option == "--budget") {
+			valid = parse(value, budget) && budget > 0;
+			options.guessBudget = std::chrono::milliseconds(budget);
+		}
+		else if (option == "--corpus") {
+			options.corpus = value;
+		}
+		else if (option == "--bot") {
+			options.bot = value;
+		}
+		else if (option == "--bot-args") {
+			options.botOptions = value;
+		}
+		else if (option == "--batch") {
+			valid = parse(value, options.batch) && options.batch > 0;
+		}
+		else if (option == "--policy") {
+			auto policy = Simulator::policy(value);
+			valid = policy.has_value();
+			options.policy = policy.value_or(options.policy);
+		}
+		else {
+			fprintf(stderr, "Unknown option %s\n", argv[i - 1]);
+			usage(argv[0]);
+			return 1;
+		}
+
+		if (!valid) {
+			fprintf(stderr, "Invalid value %s of %s\n", argv[i], argv[i - 1]);
+			return 1;
+		}
+	}
+
+	// The mines are not placed around the first click, see Minefield::generate.
+	if (options.numberOfMines > options.width * options.height - 9) {
+		fprintf(stderr, "Too many mines for a %dx%d board\n", options.width, options.height);
+		return 1;
+	}
+
+	Simulator::Result result;
+	try {
+		result = Simulator(options).run();
+	}
+	catch (const std::runtime_error &error) {
+		fprintf(stderr, "%s\n", error.what());
+		return 1;
+	}
+
+	if (options.corpus.empty()) {
+		printf("board        %dx%d, %d mines\n", options.width, options.height, options.numberOfMines);
+	}
+	else {
+		printf("corpus       %s\n", options.corpus.c_str());
+	}
+	if (options.bot.empty()) {
+		printf("policy       %s\n", Simulator::name(options.policy).data());
+	}
+	else {
+		printf("bot          %s\n", options.bot.c_str());
+	}
+	printf("games        %llu\n", static_cast<unsigned long long>(result.games));
+	if (result.abandoned) {
+		printf("abandoned    %llu\n", static_cast<unsigned long long>(result.abandoned));
+	}
+	printf("win rate     %.2f%%\n", 100 * result.winRate());
+	printf("3BV/s        %.1f\n", result.meanBbbvPerSecond());
+	printf("efficiency   %.3f\n", result.efficiency());
+	printf("clicks/game  %.1f\n", result.clicksPerGame());
+	printf("games/s      %.1f\n", result.gamesPerSecond());
+
+	return 0;
+}
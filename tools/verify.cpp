@@ -0,0 +1,118 @@
+#include "ReplayVerifier.h"
+
+#include <charconv>
+#include <cstdio>
+#include <string_view>
+
+namespace
+{
+
+void usage(const char *program)
+{
+	fprintf(stderr,
+		"Usage: %s [options]\n"
+		"  --replays DIR   directory of the replay files (replays)\n"
+		"  --scores NAME   base name of the score journal (scores)\n"
+		"  --legacy FILE   score file of the older versions (scores.txt)\n"
+		"  --output FILE   tab separated summary of every replay (verify.tsv)\n"
+		"  --threads N     worker threads, 0 for all the cores (0)\n",
+		program);
+}
+
+template <typename Number>
+bool parse(std::string_view text, Number &number)
+{
+	auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), number);
+	return error == std::errc() && end == text.data() + text.size();
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+	ReplayVerifier::Options options;
+	std::string output = "verify.tsv";
+
+	for (int i = 1; i < argc; i++) {
+		std::string_view option = argv[i];
+		if (option == "--help" || option == "-h") {
+			usage(argv[0]);
+			return 0;
+		}
+		if (i + 1 == argc) {
+			fprintf(stderr, "Missing the value of %s\n", argv[i]);
+			return 1;
+		}
+
+		std::string_view value = argv[++i];
+		bool valid = true;
+		if (option == "--replays") {
+			options.replays = value;
+		}
+		else if (option == "--scores") {
+			options.scores = value;
+		}
+		else if (option == "--legacy") {
+			options.legacyScores = value;
+		}
+		else if (option == "--output") {
+			output = value;
+		}
+		else if (option == "--threads") {
+			valid = parse(value, options.threads);
+		}
+		else {
+			fprintf(stderr, "Unknown option %s\n", argv[i - 1]);
+			usage(argv[0]);
+			return 1;
+		}
+
+		if (!valid) {
+			fprintf(stderr, "Invalid value %s of %s\n", argv[i], argv[i - 1]);
+			return 1;
+		}
+	}
+
+	auto result = ReplayVerifier(options).run();
+	if (!ReplayVerifier::write(output, result)) {
+		fprintf(stderr, "Could not write %s\n", output.c_str());
+		return 1;
+	}
+
+	uint64_t wins = 0;
+	uint64_t bbbv = 0;
+	uint64_t clicks = 0;
+	uint64_t flags = 0;
+	uint64_t correctFlags = 0;
+	double bbbvPerSecond = 0;
+	for (const auto &game : result.games) {
+		flags += game.flags;
+		correctFlags += game.correctFlags;
+		if (game.won) {
+			wins++;
+			bbbv += game.bbbv;
+			clicks += game.clicks;
+			bbbvPerSecond += game.bbbvPerSecond();
+		}
+	}
+
+	auto count = [&result](ReplayVerifier::Verdict verdict) {
+		return static_cast<unsigned long long>(result.count(verdict));
+	};
+	printf("replays        %llu\n", static_cast<unsigned long long>(result.games.size()));
+	printf("verified       %llu\n", count(ReplayVerifier::Verdict::Verified));
+	printf("mismatched     %llu\n", count(ReplayVerifier::Verdict::Mismatch));
+	printf("unscored       %llu\n", count(ReplayVerifier::Verdict::Unscored));
+	printf("corrupt        %llu\n", count(ReplayVerifier::Verdict::Corrupt));
+	printf("no replay      %llu records\n", static_cast<unsigned long long>(result.unreplayedRecords));
+	printf("3BV/s          %.2f\n", wins ? bbbvPerSecond / wins : 0);
+	printf("efficiency     %.3f\n", clicks ? static_cast<double>(bbbv) / clicks : 0);
+	printf("flag accuracy  %.1f%%\n", flags ? 100.0 * correctFlags / flags : 0);
+	printf("think time     p50 %ums, p90 %ums, p99 %ums\n", result.thinkTime(0.5), result.thinkTime(0.9),
+		result.thinkTime(0.99));
+	printf("replays/s      %.0f\n", result.seconds > 0 ? result.games.size() / result.seconds : 0);
+	printf("summary        %s\n", output.c_str());
+
+	// A mismatched replay means a record of the leaderboard can not be trusted.
+	return count(ReplayVerifier::Verdict::Mismatch) == 0 ? 0 : 2;
+}